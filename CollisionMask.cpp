@@ -0,0 +1,144 @@
+//
+//  CollisionMask.cpp
+//  SPRED - Sprite Editor
+//
+//  Collision mask implementation
+//
+
+#include "CollisionMask.h"
+#include "SpriteData.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SPRED {
+
+CollisionMask::CollisionMask() {
+    clear();
+}
+
+void CollisionMask::clear() {
+    m_width = 0;
+    m_height = 0;
+    std::memset(m_rows, 0, sizeof(m_rows));
+    updateExtents();
+}
+
+bool CollisionMask::build(const uint8_t* pixels, int width, int height) {
+    clear();
+    if (!pixels || width <= 0 || height <= 0 || width > MAX_SIZE || height > MAX_SIZE) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + y * width;
+        uint64_t bits = 0;
+        for (int x = 0; x < width; x++) {
+            bits |= uint64_t(row[x] != 0) << x;
+        }
+        m_rows[y] = bits;
+    }
+    updateExtents();
+    return true;
+}
+
+bool CollisionMask::build(const SpriteData& sprite) {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return build(sprite.getUnpackedPixels(scratch), sprite.getWidth(), sprite.getHeight());
+}
+
+bool CollisionMask::buildFromRows(const uint64_t* rows, int width, int height) {
+    clear();
+    if (!rows || width <= 0 || height <= 0 || width > MAX_SIZE || height > MAX_SIZE) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    const uint64_t valid = width == 64 ? ~uint64_t(0) : ((uint64_t(1) << width) - 1);
+    for (int y = 0; y < height; y++) {
+        m_rows[y] = rows[y] & valid;
+    }
+    updateExtents();
+    return true;
+}
+
+void CollisionMask::updateExtents() {
+    m_minX = m_minY = MAX_SIZE;
+    m_maxX = m_maxY = -1;
+    for (int y = 0; y < MAX_SIZE; y++) {
+        uint64_t bits = m_rows[y];
+        if (bits == 0) {
+            m_rowMinX[y] = MAX_SIZE;
+            m_rowMaxX[y] = -1;
+            continue;
+        }
+        m_rowMinX[y] = static_cast<int8_t>(__builtin_ctzll(bits));
+        m_rowMaxX[y] = static_cast<int8_t>(63 - __builtin_clzll(bits));
+        m_minX = std::min<int>(m_minX, m_rowMinX[y]);
+        m_maxX = std::max<int>(m_maxX, m_rowMaxX[y]);
+        m_minY = std::min(m_minY, y);
+        m_maxY = y;
+    }
+}
+
+int CollisionMask::getPixelCount() const {
+    int count = 0;
+    for (int y = 0; y < m_height; y++) {
+        count += __builtin_popcountll(m_rows[y]);
+    }
+    return count;
+}
+
+// ============================================================================
+// Overlap tests
+// ============================================================================
+
+template <typename Fn>
+bool CollisionMask::forEachOverlapRow(const CollisionMask& a, int ax, int ay,
+                                      const CollisionMask& b, int bx, int by, Fn fn) {
+    if (a.isEmpty() || b.isEmpty()) {
+        return false;
+    }
+
+    // b relative to a; anything 64 or more apart cannot touch
+    const int64_t dx = int64_t(bx) - ax;
+    const int64_t dy = int64_t(by) - ay;
+    if (dx <= -MAX_SIZE || dx >= MAX_SIZE || dy <= -MAX_SIZE || dy >= MAX_SIZE) {
+        return false;
+    }
+    const int offsetX = static_cast<int>(dx);
+    const int offsetY = static_cast<int>(dy);
+
+    // Intersect the bounding boxes in a's coordinates
+    const int x0 = std::max(a.m_minX, b.m_minX + offsetX);
+    const int x1 = std::min(a.m_maxX, b.m_maxX + offsetX);
+    const int y0 = std::max(a.m_minY, b.m_minY + offsetY);
+    const int y1 = std::min(a.m_maxY, b.m_maxY + offsetY);
+    if (x0 > x1 || y0 > y1) {
+        return false;
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        uint64_t rowB = b.m_rows[y - offsetY];
+        uint64_t shifted = offsetX >= 0 ? rowB << offsetX : rowB >> -offsetX;
+        if (fn(a.m_rows[y] & shifted)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CollisionMask::overlaps(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by) {
+    return forEachOverlapRow(a, ax, ay, b, bx, by, [](uint64_t bits) { return bits != 0; });
+}
+
+int CollisionMask::overlapCount(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by) {
+    int count = 0;
+    forEachOverlapRow(a, ax, ay, b, bx, by, [&count](uint64_t bits) {
+        count += __builtin_popcountll(bits);
+        return false;
+    });
+    return count;
+}
+
+} // namespace SPRED
@@ -0,0 +1,99 @@
+//
+//  CollisionMask.h
+//  SPRED - Sprite Editor
+//
+//  1-bit opacity masks for pixel-perfect sprite collision
+//
+
+#ifndef SPRED_COLLISION_MASK_H
+#define SPRED_COLLISION_MASK_H
+
+#include <cstdint>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// CollisionMask - One 64-bit word per row, bit x set where the index is non-zero
+///
+/// The bounding box of all set bits and each row's first and last set bit
+/// are kept alongside the rows. An overlap test clips both masks to the
+/// intersection of their bounding boxes and then needs one shift and one
+/// AND per row, so two 40x40 sprites are compared in at most 40 steps.
+///
+/// Usage:
+///   CollisionMask ship, rock;
+///   ship.build(shipSprite);
+///   rock.build(rockSprite);
+///   if (CollisionMask::overlaps(ship, shipX, shipY, rock, rockX, rockY)) { ... }
+class CollisionMask {
+public:
+    /// Largest supported width and height
+    static constexpr int MAX_SIZE = 64;
+
+    CollisionMask();
+
+    /// Build from byte-per-pixel indices
+    /// @return false if the size is out of range (the mask is left empty)
+    bool build(const uint8_t* pixels, int width, int height);
+
+    /// Build from a sprite in either pixel layout
+    bool build(const SpriteData& sprite);
+
+    /// Build from opacity rows, e.g. SpriteCodecs::decodeOpacityMask output
+    /// Bits at or beyond width are ignored.
+    bool buildFromRows(const uint64_t* rows, int width, int height);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    uint64_t getRow(int y) const { return (y >= 0 && y < m_height) ? m_rows[y] : 0; }
+    bool testPixel(int x, int y) const { return x >= 0 && x < m_width && ((getRow(y) >> x) & 1) != 0; }
+
+    /// True if no pixel is set
+    bool isEmpty() const { return m_maxX < m_minX; }
+
+    /// Bounding box of set pixels, inclusive (minX > maxX when empty)
+    int getMinX() const { return m_minX; }
+    int getMinY() const { return m_minY; }
+    int getMaxX() const { return m_maxX; }
+    int getMaxY() const { return m_maxY; }
+
+    /// First and last set pixel of a row, inclusive (first > last when the row is empty)
+    int getRowMinX(int y) const { return m_rowMinX[y]; }
+    int getRowMaxX(int y) const { return m_rowMaxX[y]; }
+
+    /// Number of set pixels
+    int getPixelCount() const;
+
+    /// Pixel-perfect overlap of two positioned masks
+    /// @param ax, ay Top-left of a in world coordinates
+    /// @param bx, by Top-left of b in world coordinates
+    static bool overlaps(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by);
+
+    /// Number of pixels where two positioned masks overlap (0 if they do not touch)
+    static int overlapCount(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by);
+
+private:
+    int m_width;
+    int m_height;
+    int m_minX;
+    int m_minY;
+    int m_maxX;
+    int m_maxY;
+    uint64_t m_rows[MAX_SIZE];
+    int8_t m_rowMinX[MAX_SIZE];
+    int8_t m_rowMaxX[MAX_SIZE];
+
+    void clear();
+    void updateExtents();
+
+    /// Calls fn(rowA & shiftedRowB) for every row where the bounding boxes meet
+    /// and stops early when fn returns true
+    template <typename Fn>
+    static bool forEachOverlapRow(const CollisionMask& a, int ax, int ay,
+                                  const CollisionMask& b, int bx, int by, Fn fn);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_COLLISION_MASK_H
@@ -0,0 +1,126 @@
+//
+//  NibblePacking.cpp
+//  SPRED - Sprite Editor
+//
+//  SIMD pack/unpack kernels for 4-bit index data
+//
+
+#include "NibblePacking.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPRED_NIBBLE_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace SPRED {
+
+// Each vector loop handles whole blocks and leaves the remainder to the
+// scalar tail. Packing reads 2N bytes before writing N, so the blocks can
+// run in place: a block never overwrites input that a later block reads.
+
+void NibblePacking::pack(const uint8_t* indices, uint8_t* packed, size_t pixelCount) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    for (; i + 64 <= pixelCount; i += 64) {
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i)), lowNibbles);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i + 32)), lowNibbles);
+        // Per 16-bit lane (odd << 8 | even): v | v >> 4 leaves even | odd << 4 in the low byte
+        a = _mm256_and_si256(_mm256_or_si256(a, _mm256_srli_epi16(a, 4)), lowBytes);
+        b = _mm256_and_si256(_mm256_or_si256(b, _mm256_srli_epi16(b, 4)), lowBytes);
+        __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(packed + i / 2), out);
+    }
+#elif defined(SPRED_NIBBLE_SSE2)
+    const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    for (; i + 32 <= pixelCount; i += 32) {
+        __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)), lowNibbles);
+        __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 16)), lowNibbles);
+        a = _mm_and_si128(_mm_or_si128(a, _mm_srli_epi16(a, 4)), lowBytes);
+        b = _mm_and_si128(_mm_or_si128(b, _mm_srli_epi16(b, 4)), lowBytes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i / 2), _mm_packus_epi16(a, b));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t lowNibbles = vdupq_n_u8(0x0F);
+    for (; i + 32 <= pixelCount; i += 32) {
+        uint8x16x2_t pairs = vld2q_u8(indices + i);  // val[0] = even pixels, val[1] = odd pixels
+        uint8x16_t out = vorrq_u8(vandq_u8(pairs.val[0], lowNibbles), vshlq_n_u8(pairs.val[1], 4));
+        vst1q_u8(packed + i / 2, out);
+    }
+#endif
+
+    // Scalar tail (and fallback)
+    for (; i + 2 <= pixelCount; i += 2) {
+        packed[i / 2] = static_cast<uint8_t>((indices[i] & 0x0F) | ((indices[i + 1] & 0x0F) << 4));
+    }
+    if (i < pixelCount) {
+        packed[i / 2] = indices[i] & 0x0F;
+    }
+}
+
+void NibblePacking::unpack(const uint8_t* packed, uint8_t* indices, size_t pixelCount) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+    for (; i + 64 <= pixelCount; i += 64) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + i / 2));
+        __m256i even = _mm256_and_si256(p, lowNibbles);
+        __m256i odd = _mm256_and_si256(_mm256_srli_epi16(p, 4), lowNibbles);
+        __m256i lo = _mm256_unpacklo_epi8(even, odd);
+        __m256i hi = _mm256_unpackhi_epi8(even, odd);
+        // unpack works per 128-bit lane; reassemble lanes in pixel order
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices + i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+#elif defined(SPRED_NIBBLE_SSE2)
+    const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+    for (; i + 32 <= pixelCount; i += 32) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i / 2));
+        __m128i even = _mm_and_si128(p, lowNibbles);
+        __m128i odd = _mm_and_si128(_mm_srli_epi16(p, 4), lowNibbles);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), _mm_unpacklo_epi8(even, odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i + 16), _mm_unpackhi_epi8(even, odd));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t lowNibbles = vdupq_n_u8(0x0F);
+    for (; i + 32 <= pixelCount; i += 32) {
+        uint8x16_t p = vld1q_u8(packed + i / 2);
+        uint8x16x2_t pairs;
+        pairs.val[0] = vandq_u8(p, lowNibbles);
+        pairs.val[1] = vshrq_n_u8(p, 4);
+        vst2q_u8(indices + i, pairs);
+    }
+#endif
+
+    // Scalar tail (and fallback)
+    for (; i + 2 <= pixelCount; i += 2) {
+        uint8_t byte = packed[i / 2];
+        indices[i] = byte & 0x0F;
+        indices[i + 1] = byte >> 4;
+    }
+    if (i < pixelCount) {
+        indices[i] = packed[i / 2] & 0x0F;
+    }
+}
+
+const char* NibblePacking::getKernelName() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(SPRED_NIBBLE_SSE2)
+    return "SSE2";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+} // namespace SPRED
@@ -0,0 +1,62 @@
+//
+//  NibblePacking.h
+//  SPRED - Sprite Editor
+//
+//  Conversion between byte-per-pixel and two-pixels-per-byte index data
+//
+
+#ifndef SPRED_NIBBLE_PACKING_H
+#define SPRED_NIBBLE_PACKING_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPRED {
+
+/// Packed Index Layout
+/// ===================
+///
+/// Two 4-bit palette indices per byte, in pixel order:
+///   byte[i] = pixel[2i] | (pixel[2i+1] << 4)
+///
+/// The low nibble holds the even pixel. An odd pixel count leaves the high
+/// nibble of the last byte zero (transparent).
+
+class NibblePacking {
+public:
+    /// Bytes needed to hold pixelCount packed indices
+    static constexpr size_t packedSize(size_t pixelCount) { return (pixelCount + 1) / 2; }
+
+    /// Pack byte-per-pixel indices (only the low 4 bits of each byte are kept)
+    /// May be used in place (packed == indices).
+    /// @param indices Input indices (pixelCount bytes)
+    /// @param packed Output buffer (packedSize(pixelCount) bytes)
+    /// @param pixelCount Number of pixels
+    static void pack(const uint8_t* indices, uint8_t* packed, size_t pixelCount);
+
+    /// Unpack to byte-per-pixel indices
+    /// Must not be used in place.
+    /// @param packed Input buffer (packedSize(pixelCount) bytes)
+    /// @param indices Output indices (pixelCount bytes)
+    /// @param pixelCount Number of pixels
+    static void unpack(const uint8_t* packed, uint8_t* indices, size_t pixelCount);
+
+    /// Read one pixel from packed data
+    static inline uint8_t get(const uint8_t* packed, size_t pixelIndex) {
+        return (packed[pixelIndex >> 1] >> ((pixelIndex & 1) << 2)) & 0x0F;
+    }
+
+    /// Write one pixel into packed data
+    static inline void set(uint8_t* packed, size_t pixelIndex, uint8_t colorIndex) {
+        int shift = static_cast<int>((pixelIndex & 1) << 2);
+        uint8_t& byte = packed[pixelIndex >> 1];
+        byte = static_cast<uint8_t>((byte & ~(0x0F << shift)) | ((colorIndex & 0x0F) << shift));
+    }
+
+    /// Name of the kernel selected at build time ("AVX2", "SSE2", "NEON" or "Scalar")
+    static const char* getKernelName();
+};
+
+} // namespace SPRED
+
+#endif // SPRED_NIBBLE_PACKING_H
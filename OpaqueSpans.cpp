@@ -0,0 +1,135 @@
+//
+//  OpaqueSpans.cpp
+//  SPRED - Sprite Editor
+//
+//  Opaque run list implementation
+//
+
+#include "OpaqueSpans.h"
+#include "SpriteData.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SPRED {
+
+bool OpaqueSpans::build(const uint8_t* pixels, int width, int height) {
+    m_width = 0;
+    m_height = 0;
+    m_rowStart.assign(1, 0);
+    m_spans.clear();
+    m_indices.clear();
+    m_source = nullptr;
+    if (!pixels || width <= 0 || height <= 0 || width > MAX_SPRITE_SIZE || height > MAX_SPRITE_SIZE) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+
+    m_rowStart.reserve(height + 1);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + size_t(y) * width;
+        int x = 0;
+        while (x < width) {
+            while (x < width && row[x] == 0) {
+                x++;
+            }
+            int start = x;
+            while (x < width && row[x] != 0) {
+                x++;
+            }
+            if (x > start) {
+                OpaqueSpan span;
+                span.x = static_cast<uint8_t>(start);
+                span.length = static_cast<uint8_t>(x - start);
+                span.offset = static_cast<uint16_t>(m_indices.size());
+                m_spans.push_back(span);
+                m_indices.insert(m_indices.end(), row + start, row + x);
+            }
+        }
+        m_rowStart.push_back(static_cast<uint16_t>(m_spans.size()));
+    }
+    return true;
+}
+
+void OpaqueSpans::build(const SpriteData& sprite) {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    build(sprite.getUnpackedPixels(scratch), sprite.getWidth(), sprite.getHeight());
+    m_source = &sprite;
+    m_generation = sprite.getGeneration();
+}
+
+bool OpaqueSpans::update(const SpriteData& sprite) {
+    if (m_source == &sprite && m_generation == sprite.getGeneration()) {
+        return false;
+    }
+    build(sprite);
+    return true;
+}
+
+size_t OpaqueSpans::getMemoryUsage() const {
+    return m_rowStart.size() * sizeof(uint16_t) + m_spans.size() * sizeof(OpaqueSpan) + m_indices.size();
+}
+
+// ============================================================================
+// Blitting
+// ============================================================================
+
+template <typename Fn>
+void OpaqueSpans::forEachClippedRun(int targetWidth, int targetHeight, int x, int y, Fn fn) const {
+    // Sprite-space clip rectangle; 64-bit so far-off positions cannot overflow
+    const int clipX0 = static_cast<int>(std::max<int64_t>(0, -int64_t(x)));
+    const int clipX1 = static_cast<int>(std::min<int64_t>(m_width, int64_t(targetWidth) - x));
+    const int clipY0 = static_cast<int>(std::max<int64_t>(0, -int64_t(y)));
+    const int clipY1 = static_cast<int>(std::min<int64_t>(m_height, int64_t(targetHeight) - y));
+    if (clipX0 >= clipX1 || clipY0 >= clipY1) {
+        return;
+    }
+    const bool clippedX = clipX0 > 0 || clipX1 < m_width;
+
+    for (int row = clipY0; row < clipY1; row++) {
+        const OpaqueSpan* span = getRowSpans(row);
+        const OpaqueSpan* end = span + getRowSpanCount(row);
+        for (; span != end; span++) {
+            int s0 = span->x;
+            int s1 = span->x + span->length;
+            if (clippedX) {
+                s0 = std::max(s0, clipX0);
+                s1 = std::min(s1, clipX1);
+                if (s0 >= s1) {
+                    continue;
+                }
+            }
+            fn(m_indices.data() + span->offset + (s0 - span->x), s1 - s0, x + s0, y + row);
+        }
+    }
+}
+
+void OpaqueSpans::blit(const SpriteSurface& surface, int x, int y, const uint32_t* table) const {
+    if (!surface.pixels || !table) {
+        return;
+    }
+    forEachClippedRun(surface.width, surface.height, x, y,
+                      [&](const uint8_t* indices, int count, int destX, int destY) {
+        uint8_t* dst = surface.pixels + size_t(destY) * surface.stride + size_t(destX) * 4;
+        if (count < SHORT_RUN) {
+            // Too short to pay for the kernel call
+            for (int i = 0; i < count; i++) {
+                uint8_t index = indices[i];
+                std::memcpy(dst + i * 4, &table[index < PaletteExpand::TABLE_SIZE ? index : 0], 4);
+            }
+        } else {
+            PaletteExpand::expandRow(indices, count, table, dst);
+        }
+    });
+}
+
+void OpaqueSpans::blitIndices(uint8_t* dst, int width, int height, size_t stride, int x, int y) const {
+    if (!dst) {
+        return;
+    }
+    forEachClippedRun(width, height, x, y, [&](const uint8_t* indices, int count, int destX, int destY) {
+        std::memcpy(dst + size_t(destY) * stride + destX, indices, count);
+    });
+}
+
+} // namespace SPRED
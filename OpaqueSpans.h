@@ -0,0 +1,99 @@
+//
+//  OpaqueSpans.h
+//  SPRED - Sprite Editor
+//
+//  Per-row opaque run lists for sparse sprite blits
+//
+
+#ifndef SPRED_OPAQUE_SPANS_H
+#define SPRED_OPAQUE_SPANS_H
+
+#include "PaletteExpand.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// One run of non-zero indices within a row
+struct OpaqueSpan {
+    uint8_t x;              // First pixel of the run
+    uint8_t length;         // Pixels in the run (at least 1)
+    uint16_t offset;        // Into the run index buffer
+};
+
+/// OpaqueSpans - A sprite as per-row lists of opaque runs
+///
+/// Index 0 is transparent, so a blit only has to touch the runs in between.
+/// Each run's indices are stored back to back, so a run is one memcpy into
+/// an index buffer or one PaletteExpand::expandRow into a 32-bit surface,
+/// and the gaps cost nothing. update() rebuilds only when the source
+/// sprite's generation has changed, so keeping one OpaqueSpans next to each
+/// sprite and calling update() before drawing builds the runs on first use
+/// and again only after an edit. Unlike the SpriteSpan runs of Masked
+/// payloads, runs never cross a row end, so clipping works row by row.
+///
+/// Usage:
+///   OpaqueSpans spans;
+///   spans.update(ship);                                   // Cheap when unchanged
+///   spans.blit(surface, shipX, shipY, table);
+class OpaqueSpans {
+public:
+    /// Runs shorter than this are expanded inline instead of through expandRow
+    static constexpr int SHORT_RUN = 8;
+
+    /// Compute the runs of a sprite
+    void build(const SpriteData& sprite);
+
+    /// Compute the runs of byte-per-pixel indices
+    /// @return false if the size is out of range (the list is left empty)
+    bool build(const uint8_t* pixels, int width, int height);
+
+    /// Rebuild if the sprite is a different object or has been edited since
+    /// @return true if the runs were rebuilt
+    bool update(const SpriteData& sprite);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    /// Runs of row y, left to right
+    const OpaqueSpan* getRowSpans(int y) const { return m_spans.data() + m_rowStart[y]; }
+    int getRowSpanCount(int y) const { return m_rowStart[y + 1] - m_rowStart[y]; }
+
+    /// Indices of a run (span.length bytes)
+    const uint8_t* getSpanPixels(const OpaqueSpan& span) const { return m_indices.data() + span.offset; }
+
+    /// Total runs and opaque pixels
+    size_t getSpanCount() const { return m_spans.size(); }
+    size_t getOpaquePixelCount() const { return m_indices.size(); }
+
+    /// Bytes held for runs, row starts and indices
+    size_t getMemoryUsage() const;
+
+    /// Expand the opaque pixels into a 32-bit surface at (x, y), clipped to the surface
+    /// @param table Expansion table in the surface format (PaletteExpand::buildTable)
+    void blit(const SpriteSurface& surface, int x, int y, const uint32_t* table) const;
+
+    /// Copy the opaque indices into a byte-per-pixel buffer at (x, y), clipped to the buffer
+    /// @param stride Bytes between destination rows
+    void blitIndices(uint8_t* dst, int width, int height, size_t stride, int x, int y) const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<uint16_t> m_rowStart;       // Height + 1 entries into m_spans
+    std::vector<OpaqueSpan> m_spans;
+    std::vector<uint8_t> m_indices;         // Opaque indices, run after run
+    const SpriteData* m_source = nullptr;
+    uint64_t m_generation = 0;
+
+    /// Calls fn(indices, count, destX, destY) for every run clipped to a target
+    template <typename Fn>
+    void forEachClippedRun(int targetWidth, int targetHeight, int x, int y, Fn fn) const;
+};
+
+} // namespace SPRED
+
+#endif // SPRED_OPAQUE_SPANS_H
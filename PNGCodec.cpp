@@ -0,0 +1,682 @@
+//
+//  PNGCodec.cpp
+//  SPRED - Sprite Editor
+//
+//  Portable PNG decoder and encoder implementation
+//
+
+#include "PNGCodec.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+namespace SPRED {
+
+namespace {
+
+const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/// Compressed bytes read or written per step
+constexpr size_t IO_BUFFER_SIZE = 64 * 1024;
+
+/// Adam7 pass origins and steps
+const int ADAM7_X0[7] = {0, 4, 0, 2, 0, 1, 0};
+const int ADAM7_Y0[7] = {0, 0, 4, 0, 2, 0, 1};
+const int ADAM7_DX[7] = {8, 8, 4, 4, 2, 2, 1};
+const int ADAM7_DY[7] = {8, 8, 8, 4, 4, 2, 2};
+
+uint32_t readBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+void writeBE32(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value >> 24);
+    p[1] = uint8_t(value >> 16);
+    p[2] = uint8_t(value >> 8);
+    p[3] = uint8_t(value);
+}
+
+int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/// Undo one row's filter in place
+/// @param row Filtered bytes (without the filter byte)
+/// @param previous Unfiltered previous row (zeros for the first row of a pass)
+bool unfilterRow(int filter, uint8_t* row, const uint8_t* previous, size_t size, size_t bpp) {
+    switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < size; i++) {
+                row[i] = uint8_t(row[i] + row[i - bpp]);
+            }
+            break;
+        case 2:
+            for (size_t i = 0; i < size; i++) {
+                row[i] = uint8_t(row[i] + previous[i]);
+            }
+            break;
+        case 3:
+            for (size_t i = 0; i < bpp && i < size; i++) {
+                row[i] = uint8_t(row[i] + (previous[i] >> 1));
+            }
+            for (size_t i = bpp; i < size; i++) {
+                row[i] = uint8_t(row[i] + ((row[i - bpp] + previous[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < bpp && i < size; i++) {
+                row[i] = uint8_t(row[i] + previous[i]);
+            }
+            for (size_t i = bpp; i < size; i++) {
+                row[i] = uint8_t(row[i] + paeth(row[i - bpp], previous[i], previous[i - bpp]));
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+PNGDecoder::PNGDecoder()
+    : m_width(0)
+    , m_height(0)
+    , m_bitDepth(0)
+    , m_colorType(0)
+    , m_channels(0)
+    , m_interlaced(false)
+    , m_nextRow(0)
+    , m_streamReady(false)
+    , m_hasTransparentKey(false)
+    , m_stream(nullptr)
+    , m_idatRemaining(0)
+    , m_idatCRC(0)
+{
+}
+
+PNGDecoder::~PNGDecoder() {
+    close();
+}
+
+void PNGDecoder::close() {
+    if (m_stream) {
+        z_stream* stream = static_cast<z_stream*>(m_stream);
+        if (m_streamReady) {
+            inflateEnd(stream);
+        }
+        delete stream;
+        m_stream = nullptr;
+    }
+    m_streamReady = false;
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_file.clear();
+}
+
+bool PNGDecoder::fail(const std::string& error) {
+    m_error = error;
+    close();
+    return false;
+}
+
+bool PNGDecoder::readChunkHeader(uint32_t& length, char type[4]) {
+    uint8_t header[8];
+    if (!m_file.read(reinterpret_cast<char*>(header), 8)) {
+        return false;
+    }
+    length = readBE32(header);
+    std::memcpy(type, header + 4, 4);
+    return length <= 0x7FFFFFFFu;
+}
+
+bool PNGDecoder::open(const std::string& filename) {
+    close();
+    m_error.clear();
+    m_width = m_height = 0;
+    m_nextRow = 0;
+    m_hasTransparentKey = false;
+    for (int i = 0; i < 256; i++) {
+        m_palette[i * 4 + 0] = 0;
+        m_palette[i * 4 + 1] = 0;
+        m_palette[i * 4 + 2] = 0;
+        m_palette[i * 4 + 3] = 255;
+    }
+
+    m_file.open(filename, std::ios::binary);
+    if (!m_file) {
+        return fail("Failed to open PNG file: " + filename);
+    }
+    uint8_t signature[8];
+    if (!m_file.read(reinterpret_cast<char*>(signature), 8) || std::memcmp(signature, PNG_SIGNATURE, 8) != 0) {
+        return fail("Not a PNG file: " + filename);
+    }
+
+    // Header chunks up to the first IDAT; ancillary chunks are skipped unread
+    bool haveHeader = false;
+    bool havePalette = false;
+    std::vector<uint8_t> data;
+    for (;;) {
+        uint32_t length;
+        char type[4];
+        if (!readChunkHeader(length, type)) {
+            return fail("Truncated PNG chunk list");
+        }
+        if (std::memcmp(type, "IDAT", 4) == 0) {
+            if (!haveHeader || (m_colorType == 3 && !havePalette)) {
+                return fail("PNG image data before IHDR/PLTE");
+            }
+            m_idatRemaining = length;
+            m_idatCRC = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>("IDAT"), 4));
+            break;
+        }
+        if (std::memcmp(type, "IEND", 4) == 0) {
+            return fail("PNG has no image data");
+        }
+        bool handled = std::memcmp(type, "IHDR", 4) == 0 || std::memcmp(type, "PLTE", 4) == 0 ||
+                       std::memcmp(type, "tRNS", 4) == 0;
+        if (!handled) {
+            if (!(type[0] & 0x20)) {
+                return fail(std::string("Unsupported critical PNG chunk ") + std::string(type, 4));
+            }
+            m_file.seekg(std::streamoff(length) + 4, std::ios::cur);
+            continue;
+        }
+
+        data.resize(length + 4);
+        if (!m_file.read(reinterpret_cast<char*>(data.data()), length + 4)) {
+            return fail("Truncated PNG chunk");
+        }
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+        crc = crc32(crc, data.data(), length);
+        if (static_cast<uint32_t>(crc) != readBE32(data.data() + length)) {
+            return fail(std::string("CRC mismatch in PNG chunk ") + std::string(type, 4));
+        }
+
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            if (length != 13 || haveHeader) {
+                return fail("Invalid PNG header");
+            }
+            uint32_t width = readBE32(data.data());
+            uint32_t height = readBE32(data.data() + 4);
+            m_bitDepth = data[8];
+            m_colorType = data[9];
+            if (width == 0 || height == 0 || width > uint32_t(MAX_DIMENSION) || height > uint32_t(MAX_DIMENSION)) {
+                return fail("Unsupported PNG size");
+            }
+            if (data[10] != 0 || data[11] != 0 || data[12] > 1) {
+                return fail("Unsupported PNG compression, filter or interlace method");
+            }
+            bool depthOK;
+            switch (m_colorType) {
+                case 0: m_channels = 1; depthOK = m_bitDepth == 1 || m_bitDepth == 2 || m_bitDepth == 4 ||
+                                                   m_bitDepth == 8 || m_bitDepth == 16; break;
+                case 3: m_channels = 1; depthOK = m_bitDepth == 1 || m_bitDepth == 2 || m_bitDepth == 4 ||
+                                                   m_bitDepth == 8; break;
+                case 2: m_channels = 3; depthOK = m_bitDepth == 8 || m_bitDepth == 16; break;
+                case 4: m_channels = 2; depthOK = m_bitDepth == 8 || m_bitDepth == 16; break;
+                case 6: m_channels = 4; depthOK = m_bitDepth == 8 || m_bitDepth == 16; break;
+                default: depthOK = false; break;
+            }
+            if (!depthOK) {
+                return fail("Invalid PNG color type / bit depth");
+            }
+            m_width = static_cast<int>(width);
+            m_height = static_cast<int>(height);
+            m_interlaced = data[12] == 1;
+            haveHeader = true;
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            if (!haveHeader || length % 3 != 0 || length == 0 || length > 256 * 3) {
+                return fail("Invalid PNG palette");
+            }
+            for (uint32_t i = 0; i < length / 3; i++) {
+                m_palette[i * 4 + 0] = data[i * 3 + 0];
+                m_palette[i * 4 + 1] = data[i * 3 + 1];
+                m_palette[i * 4 + 2] = data[i * 3 + 2];
+            }
+            havePalette = true;
+        } else if (haveHeader) {        // tRNS
+            if (m_colorType == 3) {
+                for (uint32_t i = 0; i < length && i < 256; i++) {
+                    m_palette[i * 4 + 3] = data[i];
+                }
+            } else if (m_colorType == 0 && length >= 2) {
+                m_transparentKey[0] = static_cast<uint16_t>((data[0] << 8) | data[1]);
+                m_hasTransparentKey = true;
+            } else if (m_colorType == 2 && length >= 6) {
+                for (int c = 0; c < 3; c++) {
+                    m_transparentKey[c] = static_cast<uint16_t>((data[c * 2] << 8) | data[c * 2 + 1]);
+                }
+                m_hasTransparentKey = true;
+            }
+        }
+    }
+
+    z_stream* stream = new z_stream();
+    m_stream = stream;
+    if (inflateInit(stream) != Z_OK) {
+        return fail("Failed to initialize inflate");
+    }
+    m_streamReady = true;
+    m_input.resize(IO_BUFFER_SIZE);
+    m_scanline.assign(rowBytes(m_width) + 1, 0);
+    m_previous.assign(rowBytes(m_width) + 1, 0);
+    return true;
+}
+
+bool PNGDecoder::nextIDAT() {
+    // Finish the current chunk, then look for a continuation
+    uint8_t crc[4];
+    if (!m_file.read(reinterpret_cast<char*>(crc), 4)) {
+        return false;
+    }
+    if (readBE32(crc) != m_idatCRC) {
+        m_error = "CRC mismatch in PNG image data";
+        return false;
+    }
+    uint32_t length;
+    char type[4];
+    if (!readChunkHeader(length, type) || std::memcmp(type, "IDAT", 4) != 0) {
+        return false;
+    }
+    m_idatRemaining = length;
+    m_idatCRC = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>("IDAT"), 4));
+    return true;
+}
+
+bool PNGDecoder::inflateBytes(uint8_t* dst, size_t count) {
+    z_stream* stream = static_cast<z_stream*>(m_stream);
+    stream->next_out = dst;
+    stream->avail_out = static_cast<uInt>(count);
+    while (stream->avail_out > 0) {
+        if (stream->avail_in == 0) {
+            while (m_idatRemaining == 0) {
+                if (!nextIDAT()) {
+                    return fail(m_error.empty() ? "Truncated PNG image data" : m_error);
+                }
+            }
+            size_t chunk = std::min<size_t>(m_idatRemaining, m_input.size());
+            if (!m_file.read(reinterpret_cast<char*>(m_input.data()), chunk)) {
+                return fail("Truncated PNG image data");
+            }
+            m_idatCRC = static_cast<uint32_t>(crc32(m_idatCRC, m_input.data(), static_cast<uInt>(chunk)));
+            m_idatRemaining -= static_cast<uint32_t>(chunk);
+            stream->next_in = m_input.data();
+            stream->avail_in = static_cast<uInt>(chunk);
+        }
+        int result = inflate(stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END && stream->avail_out > 0) {
+            return fail("PNG image data ended early");
+        }
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            return fail("Corrupt PNG image data");
+        }
+    }
+    return true;
+}
+
+bool PNGDecoder::readScanline(int pixelCount) {
+    const size_t size = rowBytes(pixelCount);
+    if (!inflateBytes(m_scanline.data(), size + 1)) {
+        return false;
+    }
+    const size_t bpp = std::max<size_t>(1, size_t(m_channels) * m_bitDepth / 8);
+    if (!unfilterRow(m_scanline[0], m_scanline.data() + 1, m_previous.data() + 1, size, bpp)) {
+        return fail("Invalid PNG filter type");
+    }
+    // The unfiltered row becomes the previous row (and the result) for the next call
+    m_scanline.swap(m_previous);
+    return true;
+}
+
+void PNGDecoder::convertRow(const uint8_t* raw, int pixelCount, uint8_t* rgba, size_t pixelStep) const {
+    // Common 8-bit layouts first
+    if (m_bitDepth == 8) {
+        switch (m_colorType) {
+            case 6:
+                if (pixelStep == 4) {
+                    std::memcpy(rgba, raw, size_t(pixelCount) * 4);
+                    return;
+                }
+                for (int x = 0; x < pixelCount; x++, rgba += pixelStep) {
+                    std::memcpy(rgba, raw + x * 4, 4);
+                }
+                return;
+            case 2:
+                for (int x = 0; x < pixelCount; x++, rgba += pixelStep, raw += 3) {
+                    rgba[0] = raw[0];
+                    rgba[1] = raw[1];
+                    rgba[2] = raw[2];
+                    rgba[3] = (m_hasTransparentKey && raw[0] == m_transparentKey[0] &&
+                               raw[1] == m_transparentKey[1] && raw[2] == m_transparentKey[2]) ? 0 : 255;
+                }
+                return;
+            case 3:
+                for (int x = 0; x < pixelCount; x++, rgba += pixelStep) {
+                    std::memcpy(rgba, &m_palette[raw[x] * 4], 4);
+                }
+                return;
+            default:
+                break;
+        }
+    }
+
+    // Everything else through a per-sample reader
+    const int depth = m_bitDepth;
+    const int maxValue = (1 << depth) - 1;
+    auto sample = [raw, depth](size_t index) -> int {
+        if (depth == 16) {
+            return (raw[index * 2] << 8) | raw[index * 2 + 1];
+        }
+        if (depth == 8) {
+            return raw[index];
+        }
+        size_t bit = index * depth;
+        return (raw[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+    };
+    auto to8 = [depth, maxValue](int value) -> uint8_t {
+        return depth == 16 ? uint8_t(value >> 8) : uint8_t(value * 255 / maxValue);
+    };
+
+    for (int x = 0; x < pixelCount; x++, rgba += pixelStep) {
+        const size_t s = size_t(x) * m_channels;
+        switch (m_colorType) {
+            case 0: {
+                int gray = sample(s);
+                rgba[0] = rgba[1] = rgba[2] = to8(gray);
+                rgba[3] = (m_hasTransparentKey && gray == m_transparentKey[0]) ? 0 : 255;
+                break;
+            }
+            case 2: {
+                int r = sample(s), g = sample(s + 1), b = sample(s + 2);
+                rgba[0] = to8(r);
+                rgba[1] = to8(g);
+                rgba[2] = to8(b);
+                rgba[3] = (m_hasTransparentKey && r == m_transparentKey[0] && g == m_transparentKey[1] &&
+                           b == m_transparentKey[2]) ? 0 : 255;
+                break;
+            }
+            case 3:
+                std::memcpy(rgba, &m_palette[sample(s) * 4], 4);
+                break;
+            case 4:
+                rgba[0] = rgba[1] = rgba[2] = to8(sample(s));
+                rgba[3] = to8(sample(s + 1));
+                break;
+            default:    // 6
+                rgba[0] = to8(sample(s));
+                rgba[1] = to8(sample(s + 1));
+                rgba[2] = to8(sample(s + 2));
+                rgba[3] = to8(sample(s + 3));
+                break;
+        }
+    }
+}
+
+bool PNGDecoder::readRow(uint8_t* rgba) {
+    if (!m_streamReady) {
+        m_error = "PNG decoder is not open";
+        return false;
+    }
+    if (m_interlaced) {
+        m_error = "Interlaced PNG cannot be read row by row";
+        return false;
+    }
+    if (m_nextRow >= m_height) {
+        m_error = "Read past the last PNG row";
+        return false;
+    }
+    if (!readScanline(m_width)) {
+        return false;
+    }
+    convertRow(m_previous.data() + 1, m_width, rgba, 4);
+    m_nextRow++;
+    return true;
+}
+
+bool PNGDecoder::readImage(uint8_t* rgba, size_t stride) {
+    if (!m_streamReady || !rgba || stride < size_t(m_width) * 4) {
+        m_error = "Invalid PNG decode target";
+        return false;
+    }
+    if (!m_interlaced) {
+        while (m_nextRow < m_height) {
+            if (!readRow(rgba + size_t(m_nextRow) * stride)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (m_nextRow != 0) {
+        m_error = "Interlaced PNG already partly read";
+        return false;
+    }
+    for (int pass = 0; pass < 7; pass++) {
+        const int passWidth = (m_width - ADAM7_X0[pass] + ADAM7_DX[pass] - 1) / ADAM7_DX[pass];
+        const int passHeight = (m_height - ADAM7_Y0[pass] + ADAM7_DY[pass] - 1) / ADAM7_DY[pass];
+        if (passWidth <= 0 || passHeight <= 0) {
+            continue;       // Empty passes have no scanlines at all
+        }
+        std::fill(m_previous.begin(), m_previous.begin() + rowBytes(passWidth) + 1, 0);
+        for (int row = 0; row < passHeight; row++) {
+            if (!readScanline(passWidth)) {
+                return false;
+            }
+            const int y = ADAM7_Y0[pass] + row * ADAM7_DY[pass];
+            convertRow(m_previous.data() + 1, passWidth, rgba + size_t(y) * stride + size_t(ADAM7_X0[pass]) * 4,
+                       size_t(ADAM7_DX[pass]) * 4);
+        }
+    }
+    m_nextRow = m_height;
+    return true;
+}
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+PNGEncoder::PNGEncoder()
+    : m_width(0)
+    , m_height(0)
+    , m_rowsWritten(0)
+    , m_stream(nullptr)
+{
+}
+
+PNGEncoder::~PNGEncoder() {
+    release();
+}
+
+void PNGEncoder::release() {
+    if (m_stream) {
+        z_stream* stream = static_cast<z_stream*>(m_stream);
+        deflateEnd(stream);
+        delete stream;
+        m_stream = nullptr;
+    }
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_file.clear();
+}
+
+bool PNGEncoder::fail(const std::string& error) {
+    m_error = error;
+    release();
+    return false;
+}
+
+bool PNGEncoder::writeChunk(const char type[4], const uint8_t* data, size_t size) {
+    uint8_t header[8];
+    writeBE32(header, static_cast<uint32_t>(size));
+    std::memcpy(header + 4, type, 4);
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+    uint8_t trailer[4];
+    writeBE32(trailer, static_cast<uint32_t>(crc));
+    m_file.write(reinterpret_cast<const char*>(header), 8);
+    if (size > 0) {
+        m_file.write(reinterpret_cast<const char*>(data), size);
+    }
+    m_file.write(reinterpret_cast<const char*>(trailer), 4);
+    return m_file.good() || fail("Failed to write PNG file");
+}
+
+bool PNGEncoder::open(const std::string& filename, int width, int height, int compressionLevel) {
+    release();
+    m_error.clear();
+    if (width <= 0 || height <= 0 || width > PNGDecoder::MAX_DIMENSION || height > PNGDecoder::MAX_DIMENSION) {
+        return fail("Invalid PNG size");
+    }
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        return fail("Failed to create PNG file: " + filename);
+    }
+    m_file.write(reinterpret_cast<const char*>(PNG_SIGNATURE), 8);
+
+    // 8-bit RGBA, default compression and filter method, not interlaced
+    uint8_t header[13];
+    writeBE32(header, static_cast<uint32_t>(width));
+    writeBE32(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8;
+    header[9] = 6;
+    header[10] = header[11] = header[12] = 0;
+    if (!writeChunk("IHDR", header, sizeof(header))) {
+        return false;
+    }
+
+    z_stream* stream = new z_stream();
+    if (deflateInit(stream, std::max(1, std::min(9, compressionLevel))) != Z_OK) {
+        delete stream;
+        return fail("Failed to initialize deflate");
+    }
+    m_stream = stream;
+    m_output.resize(IO_BUFFER_SIZE);
+    stream->next_out = m_output.data();
+    stream->avail_out = static_cast<uInt>(m_output.size());
+    m_previous.assign(size_t(width) * 4, 0);
+    m_filtered.resize((size_t(width) * 4 + 1) * 5);
+    return true;
+}
+
+bool PNGEncoder::deflateRow(const uint8_t* data, size_t size, int flush) {
+    z_stream* stream = static_cast<z_stream*>(m_stream);
+    stream->next_in = const_cast<Bytef*>(data);
+    stream->avail_in = static_cast<uInt>(size);
+    for (;;) {
+        int result = deflate(stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            return fail("Deflate failed");
+        }
+        if (stream->avail_out == 0) {
+            // Output buffer full: one IDAT chunk
+            if (!writeChunk("IDAT", m_output.data(), m_output.size())) {
+                return false;
+            }
+            stream->next_out = m_output.data();
+            stream->avail_out = static_cast<uInt>(m_output.size());
+            continue;
+        }
+        if (flush == Z_FINISH ? result == Z_STREAM_END : stream->avail_in == 0) {
+            return true;
+        }
+    }
+}
+
+bool PNGEncoder::writeRow(const uint8_t* rgba) {
+    if (!m_stream || !rgba) {
+        m_error = m_stream ? "Null PNG row" : "PNG encoder is not open";
+        return false;
+    }
+    if (m_rowsWritten >= m_height) {
+        m_error = "Too many PNG rows";
+        return false;
+    }
+
+    // Try all five filters; keep the one with the smallest sum of |signed byte|
+    const size_t size = size_t(m_width) * 4;
+    const size_t stride = size + 1;
+    const uint8_t* up = m_previous.data();
+    size_t best = 0;
+    uint64_t bestScore = UINT64_MAX;
+    for (int filter = 0; filter < 5; filter++) {
+        uint8_t* out = m_filtered.data() + filter * stride;
+        out[0] = static_cast<uint8_t>(filter);
+        uint64_t score = 0;
+        for (size_t i = 0; i < size; i++) {
+            int left = i >= 4 ? rgba[i - 4] : 0;
+            int upLeft = i >= 4 ? up[i - 4] : 0;
+            int predicted;
+            switch (filter) {
+                case 0: predicted = 0; break;
+                case 1: predicted = left; break;
+                case 2: predicted = up[i]; break;
+                case 3: predicted = (left + up[i]) >> 1; break;
+                default: predicted = paeth(left, up[i], upLeft); break;
+            }
+            uint8_t value = uint8_t(rgba[i] - predicted);
+            out[i + 1] = value;
+            score += std::abs(int(int8_t(value)));
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            best = size_t(filter);
+        }
+    }
+
+    if (!deflateRow(m_filtered.data() + best * stride, stride, Z_NO_FLUSH)) {
+        return false;
+    }
+    std::memcpy(m_previous.data(), rgba, size);
+    m_rowsWritten++;
+    return true;
+}
+
+bool PNGEncoder::finish() {
+    if (!m_stream) {
+        m_error = "PNG encoder is not open";
+        return false;
+    }
+    if (m_rowsWritten != m_height) {
+        return fail("PNG is missing rows");
+    }
+    if (!deflateRow(nullptr, 0, Z_FINISH)) {
+        return false;
+    }
+    z_stream* stream = static_cast<z_stream*>(m_stream);
+    size_t pending = m_output.size() - stream->avail_out;
+    if (pending > 0 && !writeChunk("IDAT", m_output.data(), pending)) {
+        return false;
+    }
+    if (!writeChunk("IEND", nullptr, 0)) {
+        return false;
+    }
+    m_file.flush();
+    bool ok = m_file.good();
+    release();
+    return ok || fail("Failed to write PNG file");
+}
+
+} // namespace SPRED
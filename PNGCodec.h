@@ -0,0 +1,156 @@
+//
+//  PNGCodec.h
+//  SPRED - Sprite Editor
+//
+//  Portable streaming PNG decoder and encoder (zlib only)
+//
+
+#ifndef SPRED_PNG_CODEC_H
+#define SPRED_PNG_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace SPRED {
+
+/// PNGDecoder - Reads a PNG file one row at a time as 8-bit RGBA
+///
+/// Only the compressed input buffer and two filtered scanlines are held, so
+/// a huge source never needs a second full-size buffer next to the caller's
+/// output. Every color type and bit depth of the PNG specification is
+/// accepted; 16-bit samples keep their high byte and tRNS transparency is
+/// applied. Interlaced files cannot be read row by row, so readRow() refuses
+/// them; readImage() handles both by scattering Adam7 passes straight into
+/// the caller's buffer.
+///
+/// Usage:
+///   PNGDecoder decoder;
+///   if (decoder.open("big.png")) {
+///       std::vector<uint8_t> row(decoder.getWidth() * 4);
+///       for (int y = 0; y < decoder.getHeight(); y++) {
+///           if (!decoder.readRow(row.data())) break;
+///           consume(y, row.data());
+///       }
+///   }
+class PNGDecoder {
+public:
+    /// Largest accepted width or height
+    static constexpr int MAX_DIMENSION = 1 << 16;
+
+    PNGDecoder();
+    ~PNGDecoder();
+    PNGDecoder(const PNGDecoder&) = delete;
+    PNGDecoder& operator=(const PNGDecoder&) = delete;
+
+    /// Read the header chunks up to the first IDAT
+    /// @return false if the file is missing or not a supported PNG
+    bool open(const std::string& filename);
+
+    /// Release the file and decompressor
+    void close();
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    bool isInterlaced() const { return m_interlaced; }
+
+    /// Decode the next row (non-interlaced files only)
+    /// @param rgba Output pixels (getWidth × 4 bytes)
+    /// @return false on corrupt data, past the last row, or for interlaced files
+    bool readRow(uint8_t* rgba);
+
+    /// Decode the whole image (all rows not yet read, or every pass if interlaced)
+    /// @param rgba Output pixels, top-left first
+    /// @param stride Bytes between output rows (at least getWidth × 4)
+    bool readImage(uint8_t* rgba, size_t stride);
+
+    /// Reason the last call failed
+    const std::string& getLastError() const { return m_error; }
+
+private:
+    std::ifstream m_file;
+    std::string m_error;
+    int m_width;
+    int m_height;
+    int m_bitDepth;
+    int m_colorType;
+    int m_channels;
+    bool m_interlaced;
+    int m_nextRow;
+    bool m_streamReady;
+
+    uint8_t m_palette[256 * 4];             // RGBA, alpha from tRNS
+    bool m_hasTransparentKey;
+    uint16_t m_transparentKey[3];           // Gray or RGB sample that reads as transparent
+
+    void* m_stream;                         // z_stream, kept out of this header
+    uint32_t m_idatRemaining;
+    uint32_t m_idatCRC;
+    std::vector<uint8_t> m_input;
+    std::vector<uint8_t> m_scanline;        // Filter byte + current row
+    std::vector<uint8_t> m_previous;        // Filter byte + previous row (zeros at a pass start)
+
+    bool fail(const std::string& error);
+    bool readChunkHeader(uint32_t& length, char type[4]);
+    bool nextIDAT();
+    bool inflateBytes(uint8_t* dst, size_t count);
+    bool readScanline(int pixelCount);
+    void convertRow(const uint8_t* raw, int pixelCount, uint8_t* rgba, size_t pixelStep) const;
+    size_t rowBytes(int pixelCount) const { return (size_t(pixelCount) * m_channels * m_bitDepth + 7) / 8; }
+};
+
+/// PNGEncoder - Writes 8-bit RGBA PNG files one row at a time
+///
+/// Each row gets the PNG filter with the smallest sum of absolute
+/// differences (the usual heuristic) and is deflated straight into IDAT
+/// chunks, so nothing but the previous row is buffered.
+///
+/// Usage:
+///   PNGEncoder encoder;
+///   encoder.open("out.png", width, height);
+///   for (int y = 0; y < height; y++) encoder.writeRow(rgba + y * width * 4);
+///   bool ok = encoder.finish();
+class PNGEncoder {
+public:
+    PNGEncoder();
+    ~PNGEncoder();
+    PNGEncoder(const PNGEncoder&) = delete;
+    PNGEncoder& operator=(const PNGEncoder&) = delete;
+
+    /// Create the file and write the header
+    /// @param compressionLevel zlib level (1 = fastest, 9 = smallest)
+    bool open(const std::string& filename, int width, int height, int compressionLevel = 6);
+
+    /// Append the next row
+    /// @param rgba Input pixels (width × 4 bytes)
+    bool writeRow(const uint8_t* rgba);
+
+    /// Flush the remaining data and write IEND
+    /// @return false if any row was missing or a write failed
+    bool finish();
+
+    /// Reason the last call failed
+    const std::string& getLastError() const { return m_error; }
+
+private:
+    std::ofstream m_file;
+    std::string m_error;
+    int m_width;
+    int m_height;
+    int m_rowsWritten;
+    void* m_stream;                         // z_stream
+    std::vector<uint8_t> m_output;
+    std::vector<uint8_t> m_previous;
+    std::vector<uint8_t> m_filtered;        // Candidate rows, filter byte first
+
+    bool fail(const std::string& error);
+    bool writeChunk(const char type[4], const uint8_t* data, size_t size);
+    bool deflateRow(const uint8_t* data, size_t size, int flush);
+    void release();
+};
+
+} // namespace SPRED
+
+#endif // SPRED_PNG_CODEC_H
@@ -20,6 +20,7 @@ enum class PNGScalingMethod {
     vImage,         // Accelerate framework (SIMD-optimized, fastest)
     ImageIO,        // ImageIO + CoreGraphics (efficient, metadata-aware)
     CoreImage,      // Core Image filters (GPU-accelerated, highest quality)
+    AreaAverage,    // Portable SIMD box filter (exact coverage, premultiplied alpha)
     Default = vImage
 };
 
@@ -118,6 +119,8 @@ public:
                               int numColors, std::vector<Color>& outColors);
     
     /// Find closest color in palette
+    /// @return Sprite palette index: 0 for transparent pixels (alpha below 128),
+    ///         otherwise 2 + the position of the nearest color (ties go to the earlier one)
     static int findClosestColor(const Color& pixel,
                                const std::vector<Color>& palette);
     
@@ -130,7 +133,7 @@ public:
     /// @param targetWidth Target width
     /// @param targetHeight Target height
     /// @param outRGBA Output RGBA buffer (must be pre-allocated)
-    /// @param method Scaling method to use (default: vImage)
+    /// @param method Scaling method to use (default: vImage; portable builds always use AreaAverage)
     /// @param filter Optional preprocessing filter (default: None)
     /// @return true if successful
     static bool resizePNG(const uint8_t* sourceRGBA, int sourceWidth, int sourceHeight,
@@ -159,6 +162,23 @@ public:
                                     std::vector<uint8_t>& outRGBA,
                                     PNGFilter filter = PNGFilter::None);
     
+    /// Resize PNG by area averaging - portable, SIMD optimized, available on every platform
+    /// Each target pixel is the coverage-weighted mean of the source pixels under it,
+    /// computed on premultiplied alpha so transparent pixels do not darken edges.
+    /// The source region runs from the offset to the right/bottom edge of the source.
+    static bool resizePNG_AreaAverage(const uint8_t* sourceRGBA, int sourceWidth, int sourceHeight,
+                                      int sourceOffsetX, int sourceOffsetY,
+                                      int targetWidth, int targetHeight,
+                                      std::vector<uint8_t>& outRGBA);
+    
+    /// Area-average a region of a larger image, read in place
+    /// @param regionRGBA Top-left pixel of the region
+    /// @param stride Bytes between source rows (at least regionWidth × 4)
+    static bool resizeRegion_AreaAverage(const uint8_t* regionRGBA, size_t stride,
+                                         int regionWidth, int regionHeight,
+                                         int targetWidth, int targetHeight,
+                                         std::vector<uint8_t>& outRGBA);
+    
     /// Resize PNG using NSImage (original method)
     static bool resizePNG_NSImage(const uint8_t* sourceRGBA, int sourceWidth, int sourceHeight,
                                   int sourceOffsetX, int sourceOffsetY,
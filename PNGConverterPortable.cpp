@@ -0,0 +1,627 @@
+//
+//  PNGConverterPortable.cpp
+//  SPRED - Sprite Editor
+//
+//  Portable PNGConverter backends: area-average scaling on every platform;
+//  file load/save, palette extraction and method dispatch for builds without
+//  Apple frameworks
+//
+//  PNGConverter.mm implements importPNG, exportPNG, loadPNGFile,
+//  loadPNGFile_ImageIO, savePNGFile, the palette extraction helpers,
+//  resizePNG and the framework scaling methods. Builds without the Apple
+//  frameworks get all of them from this file instead; it is selected by default off Apple platforms, or with
+//  -DSPRED_PNG_PORTABLE=1 when PNGConverter.mm is built with the same flag.
+//
+
+#include "PNGConverter.h"
+#include "PNGCodec.h"
+#include "PaletteExpand.h"
+#include "PaletteMapper.h"
+#include "SpriteScale.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRED_AREA_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPRED_AREA_NEON 1
+#endif
+
+#ifndef SPRED_PNG_PORTABLE
+#if defined(__APPLE__)
+#define SPRED_PNG_PORTABLE 0
+#else
+#define SPRED_PNG_PORTABLE 1
+#endif
+#endif
+
+namespace SPRED {
+
+namespace {
+
+/// Source pixels under each target pixel along one axis, with coverage weights
+struct AreaWeights {
+    std::vector<int> first;         // First source pixel per target pixel
+    std::vector<int> count;         // Source pixels per target pixel
+    std::vector<int> start;         // Into weights
+    std::vector<float> weights;     // Coverage / scale; each target pixel's weights sum to 1
+};
+
+void buildAreaWeights(int sourceSize, int targetSize, AreaWeights& out) {
+    const double scale = double(sourceSize) / targetSize;
+    out.first.resize(targetSize);
+    out.count.resize(targetSize);
+    out.start.resize(targetSize);
+    out.weights.clear();
+    for (int t = 0; t < targetSize; t++) {
+        const double a = t * scale;
+        const double b = (t + 1) * scale;
+        const int j0 = std::min(sourceSize - 1, static_cast<int>(a));
+        const int j1 = std::min(sourceSize, static_cast<int>(std::ceil(b)));
+        out.first[t] = j0;
+        out.start[t] = static_cast<int>(out.weights.size());
+        for (int j = j0; j < j1; j++) {
+            double covered = std::min(b, double(j + 1)) - std::max(a, double(j));
+            out.weights.push_back(static_cast<float>(std::max(0.0, covered) / scale));
+        }
+        out.count[t] = static_cast<int>(out.weights.size()) - out.start[t];
+    }
+}
+
+// Four float lanes (premultiplied R, G, B and alpha) per pixel
+#if defined(SPRED_AREA_SSE2)
+typedef __m128 Lanes;
+
+inline Lanes lanesZero() { return _mm_setzero_ps(); }
+inline Lanes lanesLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void lanesStore(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Lanes lanesMultiplyAdd(Lanes sum, Lanes v, float w) { return _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(w))); }
+
+/// (r·a, g·a, b·a, a) from one RGBA8 pixel
+inline Lanes lanesPremultiplied(const uint8_t* pixel) {
+    int32_t bits;
+    std::memcpy(&bits, pixel, 4);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+    __m128 rgba = _mm_cvtepi32_ps(wide);
+    __m128 alpha = _mm_shuffle_ps(rgba, rgba, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 oneW = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    return _mm_mul_ps(rgba, _mm_or_ps(_mm_and_ps(alpha, rgbMask), oneW));
+}
+#elif defined(SPRED_AREA_NEON)
+typedef float32x4_t Lanes;
+
+inline Lanes lanesZero() { return vdupq_n_f32(0.0f); }
+inline Lanes lanesLoad(const float* p) { return vld1q_f32(p); }
+inline void lanesStore(float* p, Lanes v) { vst1q_f32(p, v); }
+inline Lanes lanesMultiplyAdd(Lanes sum, Lanes v, float w) { return vmlaq_n_f32(sum, v, w); }
+
+inline Lanes lanesPremultiplied(const uint8_t* pixel) {
+    uint32_t bits;
+    std::memcpy(&bits, pixel, 4);
+    uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+    float32x4_t rgba = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)));
+    float32x4_t alpha = vsetq_lane_f32(1.0f, vdupq_laneq_f32(rgba, 3), 3);
+    return vmulq_f32(rgba, alpha);
+}
+#else
+struct Lanes {
+    float v[4];
+};
+
+inline Lanes lanesZero() { return Lanes{{0.0f, 0.0f, 0.0f, 0.0f}}; }
+inline Lanes lanesLoad(const float* p) { return Lanes{{p[0], p[1], p[2], p[3]}}; }
+inline void lanesStore(float* p, Lanes v) { std::memcpy(p, v.v, sizeof(v.v)); }
+inline Lanes lanesMultiplyAdd(Lanes sum, Lanes v, float w) {
+    for (int i = 0; i < 4; i++) {
+        sum.v[i] += v.v[i] * w;
+    }
+    return sum;
+}
+
+inline Lanes lanesPremultiplied(const uint8_t* pixel) {
+    float a = pixel[3];
+    return Lanes{{pixel[0] * a, pixel[1] * a, pixel[2] * a, a}};
+}
+#endif
+
+/// Premultiplied horizontal coverage sums of one source row (4 floats per target pixel)
+void reduceRow(const uint8_t* row, const AreaWeights& weightsX, int targetWidth, float* out) {
+    for (int t = 0; t < targetWidth; t++) {
+        const uint8_t* pixel = row + size_t(weightsX.first[t]) * 4;
+        const float* weight = &weightsX.weights[weightsX.start[t]];
+        Lanes sum = lanesZero();
+        for (int k = 0; k < weightsX.count[t]; k++, pixel += 4) {
+            sum = lanesMultiplyAdd(sum, lanesPremultiplied(pixel), weight[k]);
+        }
+        lanesStore(out + size_t(t) * 4, sum);
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Area-average scaling
+// ============================================================================
+
+bool PNGConverter::resizePNG_AreaAverage(const uint8_t* sourceRGBA, int sourceWidth, int sourceHeight,
+                                         int sourceOffsetX, int sourceOffsetY,
+                                         int targetWidth, int targetHeight,
+                                         std::vector<uint8_t>& outRGBA) {
+    if (!sourceRGBA || sourceWidth <= 0 || sourceHeight <= 0 ||
+        sourceOffsetX < 0 || sourceOffsetX >= sourceWidth || sourceOffsetY < 0 || sourceOffsetY >= sourceHeight) {
+        return false;
+    }
+    const size_t stride = size_t(sourceWidth) * 4;
+    return resizeRegion_AreaAverage(sourceRGBA + size_t(sourceOffsetY) * stride + size_t(sourceOffsetX) * 4, stride,
+                                    sourceWidth - sourceOffsetX, sourceHeight - sourceOffsetY,
+                                    targetWidth, targetHeight, outRGBA);
+}
+
+bool PNGConverter::resizeRegion_AreaAverage(const uint8_t* region, size_t stride,
+                                            int regionWidth, int regionHeight,
+                                            int targetWidth, int targetHeight,
+                                            std::vector<uint8_t>& outRGBA) {
+    if (!region || regionWidth <= 0 || regionHeight <= 0 || stride < size_t(regionWidth) * 4 ||
+        targetWidth <= 0 || targetHeight <= 0 ||
+        targetWidth > PNGDecoder::MAX_DIMENSION || targetHeight > PNGDecoder::MAX_DIMENSION) {
+        return false;
+    }
+
+    AreaWeights weightsX;
+    AreaWeights weightsY;
+    buildAreaWeights(regionWidth, targetWidth, weightsX);
+    buildAreaWeights(regionHeight, targetHeight, weightsY);
+
+    // One accumulator row; consecutive target rows share their boundary source
+    // row, so the last reduced row is kept
+    const size_t rowFloats = size_t(targetWidth) * 4;
+    std::vector<float> accumulator(rowFloats);
+    std::vector<float> reduced(rowFloats);
+    int reducedRow = -1;
+
+    outRGBA.resize(size_t(targetWidth) * targetHeight * 4);
+    for (int ty = 0; ty < targetHeight; ty++) {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+        for (int k = 0; k < weightsY.count[ty]; k++) {
+            const int sy = weightsY.first[ty] + k;
+            if (sy != reducedRow) {
+                reduceRow(region + size_t(sy) * stride, weightsX, targetWidth, reduced.data());
+                reducedRow = sy;
+            }
+            const float weight = weightsY.weights[weightsY.start[ty] + k];
+            for (size_t i = 0; i < rowFloats; i += 4) {
+                lanesStore(&accumulator[i], lanesMultiplyAdd(lanesLoad(&accumulator[i]),
+                                                             lanesLoad(&reduced[i]), weight));
+            }
+        }
+
+        // Un-premultiply; fully transparent results stay (0, 0, 0, 0)
+        uint8_t* out = outRGBA.data() + size_t(ty) * rowFloats;
+        for (int tx = 0; tx < targetWidth; tx++, out += 4) {
+            const float* sum = &accumulator[size_t(tx) * 4];
+            const float alpha = sum[3];
+            if (alpha < 0.5f) {
+                std::memset(out, 0, 4);
+                continue;
+            }
+            const float inverse = 1.0f / alpha;
+            for (int c = 0; c < 3; c++) {
+                out[c] = static_cast<uint8_t>(std::min(255.0f, sum[c] * inverse + 0.5f));
+            }
+            out[3] = static_cast<uint8_t>(std::min(255.0f, alpha + 0.5f));
+        }
+    }
+    return true;
+}
+
+} // namespace SPRED
+
+#if SPRED_PNG_PORTABLE
+
+namespace SPRED {
+
+// ============================================================================
+// Whole-file import/export
+// ============================================================================
+
+bool PNGConverter::importPNG(const std::string& filename,
+                             int maxWidth, int maxHeight,
+                             int& outWidth, int& outHeight,
+                             uint8_t* outPixels,
+                             uint8_t* outPalette) {
+    if (!outPixels || !outPalette || maxWidth <= 0 || maxHeight <= 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> rgba;
+    int width, height;
+    if (!loadPNGFile(filename, rgba, width, height)) {
+        return false;
+    }
+
+    // Shrink to fit, keeping the aspect ratio; images that already fit keep their size
+    int targetWidth = width;
+    int targetHeight = height;
+    if (targetWidth > maxWidth || targetHeight > maxHeight) {
+        if (int64_t(width) * maxHeight > int64_t(height) * maxWidth) {
+            targetWidth = maxWidth;
+            targetHeight = std::max(1, static_cast<int>(int64_t(height) * maxWidth / width));
+        } else {
+            targetHeight = maxHeight;
+            targetWidth = std::max(1, static_cast<int>(int64_t(width) * maxHeight / height));
+        }
+        std::vector<uint8_t> resized;
+        if (!resizePNG_AreaAverage(rgba.data(), width, height, 0, 0, targetWidth, targetHeight, resized)) {
+            return false;
+        }
+        rgba.swap(resized);
+    }
+
+    // Quantize to 4 bits per channel, the precision PaletteMapper works at
+    const int pixelCount = targetWidth * targetHeight;
+    for (size_t i = 0; i < rgba.size(); i += 4) {
+        rgba[i + 0] &= 0xF0;
+        rgba[i + 1] &= 0xF0;
+        rgba[i + 2] &= 0xF0;
+    }
+
+    // 0 = transparent, 1 = opaque black, 2-15 = extracted colors (grey filler)
+    std::vector<Color> colors;
+    extractPalette(rgba.data(), pixelCount, 14, colors);
+    const Color fixed[2] = {Color(0, 0, 0, 0), Color(0, 0, 0, 255)};
+    for (int i = 0; i < 16; i++) {
+        Color color = i < 2 ? fixed[i] : size_t(i - 2) < colors.size() ? colors[i - 2] : Color(128, 128, 128);
+        outPalette[i * 4 + 0] = color.r;
+        outPalette[i * 4 + 1] = color.g;
+        outPalette[i * 4 + 2] = color.b;
+        outPalette[i * 4 + 3] = i == 0 ? 0 : 255;
+    }
+
+    mapToPalette(rgba.data(), pixelCount, colors, outPixels);
+    outWidth = targetWidth;
+    outHeight = targetHeight;
+    return true;
+}
+
+bool PNGConverter::exportPNG(const std::string& filename,
+                             int width, int height,
+                             const uint8_t* pixels,
+                             const uint8_t* palette,
+                             int scale) {
+    if (!pixels || !palette || width <= 0 || height <= 0 || scale < 1 ||
+        int64_t(width) * scale > PNGDecoder::MAX_DIMENSION || int64_t(height) * scale > PNGDecoder::MAX_DIMENSION) {
+        return false;
+    }
+
+    PNGEncoder encoder;
+    if (!encoder.open(filename, width * scale, height * scale)) {
+        return false;
+    }
+
+    // One source row at a time: expand, widen, then write it scale times
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    PaletteExpand::buildTable(palette, SurfaceFormat::RGBA, table);
+    std::vector<uint8_t> row(size_t(width) * 4);
+    std::vector<uint8_t> scaled(size_t(width) * scale * 4);
+    for (int y = 0; y < height; y++) {
+        PaletteExpand::expandRow(pixels + size_t(y) * width, width, table, row.data());
+        SpriteScale::scaleRow(row.data(), width, scale, scaled.data());
+        for (int s = 0; s < scale; s++) {
+            if (!encoder.writeRow(scaled.data())) {
+                return false;
+            }
+        }
+    }
+    return encoder.finish();
+}
+
+void PNGConverter::mapToPalette(const uint8_t* rgba, int pixelCount,
+                                const std::vector<Color>& colors,
+                                uint8_t* outIndices) {
+    // Exact for quantized pixels; anything else is quantized by the lookup
+    PaletteMapper mapper;
+    mapper.build(colors, 2);
+    mapper.map(rgba, size_t(pixelCount), outIndices);
+}
+
+// ============================================================================
+// File load/save
+// ============================================================================
+
+bool PNGConverter::loadPNGFile(const std::string& filename,
+                               std::vector<uint8_t>& rgba,
+                               int& width, int& height) {
+    PNGDecoder decoder;
+    if (!decoder.open(filename)) {
+        return false;
+    }
+    // Rows are decoded straight into the result; no intermediate image
+    rgba.resize(size_t(decoder.getWidth()) * decoder.getHeight() * 4);
+    if (!decoder.readImage(rgba.data(), size_t(decoder.getWidth()) * 4)) {
+        rgba.clear();
+        return false;
+    }
+    width = decoder.getWidth();
+    height = decoder.getHeight();
+    return true;
+}
+
+bool PNGConverter::loadPNGFile_ImageIO(const std::string& filename,
+                                       std::vector<uint8_t>& rgba,
+                                       int& width, int& height) {
+    return loadPNGFile(filename, rgba, width, height);
+}
+
+bool PNGConverter::savePNGFile(const std::string& filename,
+                               const uint8_t* rgba,
+                               int width, int height) {
+    if (!rgba) {
+        return false;
+    }
+    PNGEncoder encoder;
+    if (!encoder.open(filename, width, height)) {
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        if (!encoder.writeRow(rgba + size_t(y) * width * 4)) {
+            return false;
+        }
+    }
+    return encoder.finish();
+}
+
+// ============================================================================
+// Palette extraction (median cut)
+// ============================================================================
+
+void PNGConverter::extractPalette(const uint8_t* rgba, int pixelCount,
+                                  int numColors, std::vector<Color>& outColors) {
+    outColors.clear();
+    if (!rgba || pixelCount <= 0 || numColors <= 0) {
+        return;
+    }
+
+    std::vector<ColorEntry> histogram;
+    buildHistogram(rgba, pixelCount, histogram);
+    if (histogram.empty()) {
+        return;
+    }
+
+    // Few enough distinct colors: use them as they are, most common first
+    if (histogram.size() <= size_t(numColors)) {
+        std::stable_sort(histogram.begin(), histogram.end(),
+                         [](const ColorEntry& a, const ColorEntry& b) { return a.count > b.count; });
+        for (const ColorEntry& entry : histogram) {
+            outColors.push_back(entry.color);
+        }
+        return;
+    }
+
+    int depth = 0;
+    while ((1 << depth) < numColors) {
+        depth++;
+    }
+    medianCut(histogram, depth, outColors);
+
+    // A full cut can give more leaves than requested (16 for 14): merge the
+    // closest pairs until the count fits
+    while (outColors.size() > size_t(numColors)) {
+        size_t bestA = 0;
+        size_t bestB = 1;
+        int bestDistance = INT_MAX;
+        for (size_t a = 0; a < outColors.size(); a++) {
+            for (size_t b = a + 1; b < outColors.size(); b++) {
+                int distance = outColors[a].distanceTo(outColors[b]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        Color& merged = outColors[bestA];
+        const Color& other = outColors[bestB];
+        merged = Color(static_cast<uint8_t>((merged.r + other.r + 1) / 2),
+                       static_cast<uint8_t>((merged.g + other.g + 1) / 2),
+                       static_cast<uint8_t>((merged.b + other.b + 1) / 2));
+        outColors.erase(outColors.begin() + bestB);
+    }
+}
+
+int PNGConverter::findClosestColor(const Color& pixel,
+                                   const std::vector<Color>& palette) {
+    // Sprite palette layout: 0 = transparent, 1 = black, 2+ = extracted colors
+    if (pixel.isTransparent() || palette.empty()) {
+        return 0;
+    }
+    int best = 0;
+    int bestDistance = INT_MAX;
+    for (size_t i = 0; i < palette.size(); i++) {
+        int distance = pixel.distanceTo(palette[i]);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = static_cast<int>(i);
+        }
+    }
+    return best + 2;
+}
+
+void PNGConverter::buildHistogram(const uint8_t* rgba, int pixelCount,
+                                  std::vector<ColorEntry>& histogram) {
+    histogram.clear();
+
+    // Sort packed RGB keys of the opaque pixels, then count equal runs
+    std::vector<uint32_t> keys;
+    keys.reserve(pixelCount);
+    for (int i = 0; i < pixelCount; i++) {
+        const uint8_t* p = rgba + size_t(i) * 4;
+        if (p[3] >= 128) {
+            keys.push_back((uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2]);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t i = 0; i < keys.size();) {
+        size_t run = i + 1;
+        while (run < keys.size() && keys[run] == keys[i]) {
+            run++;
+        }
+        histogram.emplace_back(Color(static_cast<uint8_t>(keys[i] >> 16),
+                                     static_cast<uint8_t>(keys[i] >> 8),
+                                     static_cast<uint8_t>(keys[i])),
+                               static_cast<int>(run - i));
+        i = run;
+    }
+}
+
+void PNGConverter::medianCut(std::vector<ColorEntry>& colors,
+                             int depth, std::vector<Color>& palette) {
+    if (colors.empty()) {
+        return;
+    }
+    if (depth <= 0 || colors.size() == 1) {
+        palette.push_back(getRepresentativeColor(colors));
+        return;
+    }
+
+    // Split along the channel with the widest range
+    int low[3] = {255, 255, 255};
+    int high[3] = {0, 0, 0};
+    for (const ColorEntry& entry : colors) {
+        const int channels[3] = {entry.color.r, entry.color.g, entry.color.b};
+        for (int c = 0; c < 3; c++) {
+            low[c] = std::min(low[c], channels[c]);
+            high[c] = std::max(high[c], channels[c]);
+        }
+    }
+    int channel = 0;
+    for (int c = 1; c < 3; c++) {
+        if (high[c] - low[c] > high[channel] - low[channel]) {
+            channel = c;
+        }
+    }
+    auto component = [channel](const Color& color) {
+        return channel == 0 ? color.r : channel == 1 ? color.g : color.b;
+    };
+    std::stable_sort(colors.begin(), colors.end(), [&](const ColorEntry& a, const ColorEntry& b) {
+        return component(a.color) < component(b.color);
+    });
+
+    // Weighted median: half the pixels on each side, at least one color each
+    int64_t total = 0;
+    for (const ColorEntry& entry : colors) {
+        total += entry.count;
+    }
+    int64_t running = 0;
+    size_t split = 0;
+    while (split < colors.size() && running * 2 < total) {
+        running += colors[split++].count;
+    }
+    split = std::max<size_t>(1, std::min(split, colors.size() - 1));
+
+    std::vector<ColorEntry> upper(colors.begin() + split, colors.end());
+    colors.erase(colors.begin() + split, colors.end());
+    medianCut(colors, depth - 1, palette);
+    medianCut(upper, depth - 1, palette);
+}
+
+Color PNGConverter::getRepresentativeColor(const std::vector<ColorEntry>& colors) {
+    // Pixel-count weighted mean
+    int64_t sum[3] = {0, 0, 0};
+    int64_t total = 0;
+    for (const ColorEntry& entry : colors) {
+        sum[0] += int64_t(entry.color.r) * entry.count;
+        sum[1] += int64_t(entry.color.g) * entry.count;
+        sum[2] += int64_t(entry.color.b) * entry.count;
+        total += entry.count;
+    }
+    if (total == 0) {
+        return Color();
+    }
+    return Color(static_cast<uint8_t>((sum[0] + total / 2) / total),
+                 static_cast<uint8_t>((sum[1] + total / 2) / total),
+                 static_cast<uint8_t>((sum[2] + total / 2) / total));
+}
+
+// ============================================================================
+// Scaling dispatch (only the portable method exists without the frameworks,
+// so Default and the framework methods all resolve to AreaAverage)
+// ============================================================================
+
+bool PNGConverter::resizePNG(const uint8_t* sourceRGBA, int sourceWidth, int sourceHeight,
+                             int sourceOffsetX, int sourceOffsetY,
+                             int targetWidth, int targetHeight,
+                             std::vector<uint8_t>& outRGBA,
+                             PNGScalingMethod method,
+                             PNGFilter filter) {
+    (void)method;
+    (void)filter;
+    return resizePNG_AreaAverage(sourceRGBA, sourceWidth, sourceHeight, sourceOffsetX, sourceOffsetY,
+                                 targetWidth, targetHeight, outRGBA);
+}
+
+bool PNGConverter::resizePNG_vImage(const uint8_t*, int, int, int, int, int, int, std::vector<uint8_t>&) {
+    return false;
+}
+
+bool PNGConverter::resizePNG_ImageIO(const uint8_t*, int, int, int, int, int, int, std::vector<uint8_t>&) {
+    return false;
+}
+
+bool PNGConverter::resizePNG_CoreImage(const uint8_t*, int, int, int, int, int, int, std::vector<uint8_t>&,
+                                       PNGFilter) {
+    return false;
+}
+
+bool PNGConverter::resizePNG_NSImage(const uint8_t*, int, int, int, int, int, int, std::vector<uint8_t>&) {
+    return false;
+}
+
+bool PNGConverter::benchmarkScalingMethods(const uint8_t* sourceRGBA,
+                                           int sourceWidth, int sourceHeight,
+                                           int targetWidth, int targetHeight,
+                                           std::vector<ScalingBenchmark>& results) {
+    results.clear();
+    const PNGScalingMethod methods[] = {PNGScalingMethod::AreaAverage};
+    const char* names[] = {"AreaAverage"};
+    const char* files[] = {"/tmp/spred_resized_area.png"};
+
+    bool anySuccess = false;
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        std::vector<uint8_t> output;
+        auto start = std::chrono::high_resolution_clock::now();
+        bool success = resizePNG(sourceRGBA, sourceWidth, sourceHeight, 0, 0,
+                                 targetWidth, targetHeight, output, methods[i]);
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+        ScalingBenchmark result;
+        result.method = methods[i];
+        result.timeSeconds = elapsed.count();
+        result.memoryBytes = output.size();
+        result.success = success;
+        results.push_back(result);
+
+        std::cout << "  " << std::left << std::setw(12) << names[i] << std::right;
+        if (success) {
+            std::cout << std::fixed << std::setprecision(3) << (elapsed.count() * 1000.0) << " ms\n";
+            savePNGFile(files[i], output.data(), targetWidth, targetHeight);
+            anySuccess = true;
+        } else {
+            std::cout << "FAILED\n";
+        }
+    }
+    return anySuccess;
+}
+
+} // namespace SPRED
+
+#endif // SPRED_PNG_PORTABLE
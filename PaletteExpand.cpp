@@ -0,0 +1,226 @@
+//
+//  PaletteExpand.cpp
+//  SPRED - Sprite Editor
+//
+//  Expansion of 4-bit palette indices to 32-bit color surfaces
+//
+
+#include "PaletteExpand.h"
+#include "NibblePacking.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPRED_EXPAND_X86 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPRED_EXPAND_NEON 1
+#endif
+
+namespace SPRED {
+
+namespace {
+
+using ExpandKernel = void (*)(const uint8_t*, size_t, const uint32_t*, uint8_t*);
+
+// Every kernel maps indices of 16 and above to entry 0 and leaves the
+// remainder of a row to the scalar reference.
+
+#if defined(SPRED_EXPAND_X86)
+
+/// SSSE3: the table is split into four 16-byte planes (R, G, B, A in surface
+/// order) and each plane is one pshufb lookup for 16 pixels
+__attribute__((target("ssse3")))
+void expandRowSSSE3(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst) {
+    alignas(16) uint8_t planes[4][16];
+    const uint8_t* entries = reinterpret_cast<const uint8_t*>(table);
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) {
+            planes[c][i] = entries[i * 4 + c];
+        }
+    }
+    const __m128i plane0 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[0]));
+    const __m128i plane1 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[1]));
+    const __m128i plane2 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[2]));
+    const __m128i plane3 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[3]));
+    const __m128i maxIndex = _mm_set1_epi8(15);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+        __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(index, maxIndex), index);
+        index = _mm_and_si128(index, inRange);
+
+        __m128i c0 = _mm_shuffle_epi8(plane0, index);
+        __m128i c1 = _mm_shuffle_epi8(plane1, index);
+        __m128i c2 = _mm_shuffle_epi8(plane2, index);
+        __m128i c3 = _mm_shuffle_epi8(plane3, index);
+
+        __m128i lo01 = _mm_unpacklo_epi8(c0, c1);
+        __m128i hi01 = _mm_unpackhi_epi8(c0, c1);
+        __m128i lo23 = _mm_unpacklo_epi8(c2, c3);
+        __m128i hi23 = _mm_unpackhi_epi8(c2, c3);
+
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi01, hi23));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi01, hi23));
+    }
+
+    PaletteExpand::expandRowScalar(indices + i, count - i, table, dst + i * 4);
+}
+
+/// AVX2: whole 32-bit entries are looked up with vpermd, entries 0-7 and
+/// 8-15 from separate registers and blended on index bit 3
+__attribute__((target("avx2")))
+void expandRowAVX2(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst) {
+    const __m256i tableLow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table));
+    const __m256i tableHigh = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + 8));
+    const __m256i maxIndex = _mm256_set1_epi32(15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i));
+        __m256i index = _mm256_cvtepu8_epi32(bytes);
+        index = _mm256_andnot_si256(_mm256_cmpgt_epi32(index, maxIndex), index);
+
+        __m256i low = _mm256_permutevar8x32_epi32(tableLow, index);
+        __m256i high = _mm256_permutevar8x32_epi32(tableHigh, index);
+        __m256i useHigh = _mm256_slli_epi32(index, 28);   // Bit 3 into the sign bit
+        __m256i color = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(low),
+                                                             _mm256_castsi256_ps(high),
+                                                             _mm256_castsi256_ps(useHigh)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), color);
+    }
+
+    PaletteExpand::expandRowScalar(indices + i, count - i, table, dst + i * 4);
+}
+
+#elif defined(SPRED_EXPAND_NEON)
+
+/// NEON (AArch64): four tbl lookups into the byte planes, then an interleaving store
+void expandRowNEON(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst) {
+    uint8x16x4_t planes = vld4q_u8(reinterpret_cast<const uint8_t*>(table));  // De-interleaves the bytes
+    const uint8x16_t limit = vdupq_n_u8(16);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t index = vld1q_u8(indices + i);
+        index = vandq_u8(index, vcltq_u8(index, limit));
+
+        uint8x16x4_t color;
+        color.val[0] = vqtbl1q_u8(planes.val[0], index);
+        color.val[1] = vqtbl1q_u8(planes.val[1], index);
+        color.val[2] = vqtbl1q_u8(planes.val[2], index);
+        color.val[3] = vqtbl1q_u8(planes.val[3], index);
+        vst4q_u8(dst + i * 4, color);
+    }
+
+    PaletteExpand::expandRowScalar(indices + i, count - i, table, dst + i * 4);
+}
+
+#endif
+
+struct KernelChoice {
+    ExpandKernel kernel;
+    const char* name;
+};
+
+KernelChoice selectKernel() {
+#if defined(SPRED_EXPAND_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {expandRowAVX2, "AVX2"};
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return {expandRowSSSE3, "SSSE3"};
+    }
+#elif defined(SPRED_EXPAND_NEON)
+    return {expandRowNEON, "NEON"};
+#endif
+    return {PaletteExpand::expandRowScalar, "Scalar"};
+}
+
+const KernelChoice& getKernel() {
+    static const KernelChoice choice = selectKernel();
+    return choice;
+}
+
+} // namespace
+
+void PaletteExpand::buildTable(const uint8_t* palette, SurfaceFormat format, uint32_t* outTable) {
+    bool bgra = format == SurfaceFormat::BGRA || format == SurfaceFormat::PremultipliedBGRA;
+    bool premultiplied = format == SurfaceFormat::PremultipliedRGBA ||
+                         format == SurfaceFormat::PremultipliedBGRA;
+
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint8_t r = palette[i * 4 + 0];
+        uint8_t g = palette[i * 4 + 1];
+        uint8_t b = palette[i * 4 + 2];
+        uint8_t a = palette[i * 4 + 3];
+        if (premultiplied) {
+            r = static_cast<uint8_t>((r * a + 127) / 255);
+            g = static_cast<uint8_t>((g * a + 127) / 255);
+            b = static_cast<uint8_t>((b * a + 127) / 255);
+        }
+
+        uint8_t bytes[4] = {bgra ? b : r, g, bgra ? r : b, a};
+        std::memcpy(&outTable[i], bytes, sizeof(bytes));
+    }
+}
+
+void PaletteExpand::expandRow(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst) {
+    getKernel().kernel(indices, count, table, dst);
+}
+
+void PaletteExpand::expandPackedRow(const uint8_t* packed, size_t count, const uint32_t* table, uint8_t* dst) {
+    // Unpack a chunk at a time into a buffer that stays in L1, then expand it
+    uint8_t indices[PACKED_CHUNK];
+    ExpandKernel kernel = getKernel().kernel;
+    for (size_t i = 0; i < count; i += PACKED_CHUNK) {
+        size_t chunk = count - i < PACKED_CHUNK ? count - i : PACKED_CHUNK;
+        NibblePacking::unpack(packed + i / 2, indices, chunk);
+        kernel(indices, chunk, table, dst + i * 4);
+    }
+}
+
+const char* PaletteExpand::getKernelName() {
+    return getKernel().name;
+}
+
+void PaletteExpand::expandRowScalar(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t index = indices[i];
+        uint32_t color = table[index < TABLE_SIZE ? index : 0];
+        std::memcpy(dst + i * 4, &color, sizeof(color));
+    }
+}
+
+void PaletteExpand::expand(const uint8_t* indices, int width, int height, const uint32_t* table,
+                           uint8_t* dst, size_t dstStride) {
+    if (dstStride == static_cast<size_t>(width) * 4) {
+        expandRow(indices, static_cast<size_t>(width) * height, table, dst);
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        expandRow(indices + y * width, width, table, dst + y * dstStride);
+    }
+}
+
+bool PaletteExpand::expandToSurface(const uint8_t* indices, int width, int height, const uint8_t* palette,
+                                    const SpriteSurface& surface, int x, int y) {
+    if (!surface.pixels || x < 0 || y < 0 ||
+        x + width > surface.width || y + height > surface.height ||
+        surface.stride < static_cast<size_t>(surface.width) * 4) {
+        return false;
+    }
+
+    uint32_t table[TABLE_SIZE];
+    buildTable(palette, surface.format, table);
+    expand(indices, width, height, table,
+           surface.pixels + y * surface.stride + static_cast<size_t>(x) * 4, surface.stride);
+    return true;
+}
+
+} // namespace SPRED
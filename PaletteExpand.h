@@ -0,0 +1,86 @@
+//
+//  PaletteExpand.h
+//  SPRED - Sprite Editor
+//
+//  Expansion of 4-bit palette indices to 32-bit color surfaces
+//
+
+#ifndef SPRED_PALETTE_EXPAND_H
+#define SPRED_PALETTE_EXPAND_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPRED {
+
+/// Byte order of 32-bit surface pixels
+enum class SurfaceFormat : uint8_t {
+    RGBA,               // R, G, B, A in memory
+    BGRA,               // B, G, R, A in memory (Metal/D3D default swapchain order)
+    PremultipliedRGBA,  // RGBA with color scaled by alpha
+    PremultipliedBGRA   // BGRA with color scaled by alpha
+};
+
+/// Caller-owned 32-bit destination (upload staging buffer, sprite sheet, ...)
+struct SpriteSurface {
+    uint8_t* pixels = nullptr;      // Top-left pixel
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;              // Bytes between rows (at least width × 4)
+    SurfaceFormat format = SurfaceFormat::RGBA;
+};
+
+/// PaletteExpand - Index-to-color conversion through a 16-entry table
+///
+/// The table holds each palette color already in the surface byte order
+/// (and premultiplied if requested), so expanding is one lookup per pixel.
+/// Indices of 16 and above map to entry 0, as in SpriteData::getRGBAPixels.
+///
+/// A 16-entry table fits a byte-shuffle lookup exactly, so rows are expanded
+/// with pshufb (SSSE3), vpermd (AVX2) or tbl (NEON). The kernel is picked
+/// once at runtime from the CPU features, so one binary runs everywhere.
+class PaletteExpand {
+public:
+    /// Number of entries in an expansion table
+    static constexpr int TABLE_SIZE = 16;
+
+    /// Build an expansion table
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @param format Surface byte order
+    /// @param outTable Output table (TABLE_SIZE entries, memory order of the surface)
+    static void buildTable(const uint8_t* palette, SurfaceFormat format, uint32_t* outTable);
+
+    /// Expand one row of indices with the fastest kernel this CPU supports
+    /// @param dst Output pixels (count × 4 bytes, no alignment requirement)
+    static void expandRow(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst);
+
+    /// Expand one row of nibble-packed indices (see NibblePacking.h)
+    /// @param packed Input indices (packedSize(count) bytes, starting on an even pixel)
+    /// @param dst Output pixels (count × 4 bytes)
+    static void expandPackedRow(const uint8_t* packed, size_t count, const uint32_t* table, uint8_t* dst);
+
+    /// Portable one-pixel-at-a-time loop; the reference the SIMD kernels must match
+    static void expandRowScalar(const uint8_t* indices, size_t count, const uint32_t* table, uint8_t* dst);
+
+    /// Name of the kernel chosen at runtime ("AVX2", "SSSE3", "NEON" or "Scalar")
+    static const char* getKernelName();
+
+    /// Expand a width × height block of indices into a surface region
+    /// @param dst Top-left destination pixel
+    /// @param dstStride Bytes between destination rows
+    static void expand(const uint8_t* indices, int width, int height, const uint32_t* table,
+                       uint8_t* dst, size_t dstStride);
+
+    /// Write a block of indices into a surface at (x, y)
+    /// @return false if the block does not fit inside the surface
+    static bool expandToSurface(const uint8_t* indices, int width, int height, const uint8_t* palette,
+                                const SpriteSurface& surface, int x, int y);
+
+private:
+    /// Pixels unpacked per step by expandPackedRow (even, so chunks start on a byte)
+    static constexpr size_t PACKED_CHUNK = 256;
+};
+
+} // namespace SPRED
+
+#endif // SPRED_PALETTE_EXPAND_H
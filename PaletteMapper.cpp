@@ -0,0 +1,179 @@
+//
+//  PaletteMapper.cpp
+//  SPRED - Sprite Editor
+//
+//  Nearest-color lookup table implementation
+//
+
+#include "PaletteMapper.h"
+#include <climits>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRED_MAPPER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPRED_MAPPER_NEON 1
+#endif
+
+namespace SPRED {
+
+namespace {
+
+/// Squared distance from each of the 16 quantized levels (0, 16, ... 240) to
+/// one palette color, per channel
+struct ChannelDistances {
+    int32_t r[16];
+    int32_t g[16];
+    alignas(16) int32_t b[16];
+};
+
+void computeDistances(const Color& color, ChannelDistances& out) {
+    for (int level = 0; level < 16; level++) {
+        int value = level << 4;
+        out.r[level] = (value - color.r) * (value - color.r);
+        out.g[level] = (value - color.g) * (value - color.g);
+        out.b[level] = (value - color.b) * (value - color.b);
+    }
+}
+
+// Each kernel fills one table row: the 16 blue levels for a fixed red and
+// green level. The distance for blue level k to color i is
+// r[i] + g[i] + b[i][k], so a row needs one broadcast add and one
+// compare-and-select per color for all 16 cells at once. Only a strictly
+// smaller distance replaces the best so far, which keeps the earlier color
+// on ties exactly as a linear search does.
+
+#if defined(SPRED_MAPPER_SSE2)
+
+void buildRow(const ChannelDistances* distances, int count, int red, int green, uint8_t* out) {
+    __m128i best[4];
+    __m128i bestIndex[4];
+    for (int k = 0; k < 4; k++) {
+        best[k] = _mm_set1_epi32(INT_MAX);
+        bestIndex[k] = _mm_setzero_si128();
+    }
+    for (int i = 0; i < count; i++) {
+        const ChannelDistances& d = distances[i];
+        const __m128i base = _mm_set1_epi32(d.r[red] + d.g[green]);
+        const __m128i index = _mm_set1_epi32(i);
+        for (int k = 0; k < 4; k++) {
+            __m128i distance = _mm_add_epi32(base, _mm_load_si128(reinterpret_cast<const __m128i*>(d.b + k * 4)));
+            __m128i closer = _mm_cmplt_epi32(distance, best[k]);
+            best[k] = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best[k]));
+            bestIndex[k] = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, bestIndex[k]));
+        }
+    }
+    // Indices are below 256: two saturating packs narrow 16 lanes to bytes
+    __m128i lo = _mm_packs_epi32(bestIndex[0], bestIndex[1]);
+    __m128i hi = _mm_packs_epi32(bestIndex[2], bestIndex[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+}
+
+const char* const BUILD_KERNEL_NAME = "SSE2";
+
+#elif defined(SPRED_MAPPER_NEON)
+
+void buildRow(const ChannelDistances* distances, int count, int red, int green, uint8_t* out) {
+    int32x4_t best[4];
+    uint32x4_t bestIndex[4];
+    for (int k = 0; k < 4; k++) {
+        best[k] = vdupq_n_s32(INT_MAX);
+        bestIndex[k] = vdupq_n_u32(0);
+    }
+    for (int i = 0; i < count; i++) {
+        const ChannelDistances& d = distances[i];
+        const int32x4_t base = vdupq_n_s32(d.r[red] + d.g[green]);
+        const uint32x4_t index = vdupq_n_u32(static_cast<uint32_t>(i));
+        for (int k = 0; k < 4; k++) {
+            int32x4_t distance = vaddq_s32(base, vld1q_s32(d.b + k * 4));
+            uint32x4_t closer = vcltq_s32(distance, best[k]);
+            best[k] = vbslq_s32(closer, distance, best[k]);
+            bestIndex[k] = vbslq_u32(closer, index, bestIndex[k]);
+        }
+    }
+    uint16x8_t lo = vcombine_u16(vmovn_u32(bestIndex[0]), vmovn_u32(bestIndex[1]));
+    uint16x8_t hi = vcombine_u16(vmovn_u32(bestIndex[2]), vmovn_u32(bestIndex[3]));
+    vst1q_u8(out, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+}
+
+const char* const BUILD_KERNEL_NAME = "NEON";
+
+#else
+
+void buildRow(const ChannelDistances* distances, int count, int red, int green, uint8_t* out) {
+    int32_t best[16];
+    uint8_t bestIndex[16];
+    for (int k = 0; k < 16; k++) {
+        best[k] = INT_MAX;
+        bestIndex[k] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        const ChannelDistances& d = distances[i];
+        const int32_t base = d.r[red] + d.g[green];
+        for (int k = 0; k < 16; k++) {
+            int32_t distance = base + d.b[k];
+            if (distance < best[k]) {
+                best[k] = distance;
+                bestIndex[k] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+    std::memcpy(out, bestIndex, 16);
+}
+
+const char* const BUILD_KERNEL_NAME = "Scalar";
+
+#endif
+
+} // namespace
+
+PaletteMapper::PaletteMapper() : m_transparentIndex(0) {
+    std::memset(m_table, 0, sizeof(m_table));
+}
+
+const char* PaletteMapper::getKernelName() {
+    return BUILD_KERNEL_NAME;
+}
+
+bool PaletteMapper::build(const Color* colors, int count, int firstIndex, uint8_t transparentIndex) {
+    if (count < 0 || firstIndex < 0 || (count > 0 && !colors) || firstIndex + count > 256) {
+        return false;
+    }
+    m_transparentIndex = transparentIndex;
+    if (count == 0) {
+        std::memset(m_table, transparentIndex, sizeof(m_table));
+        return true;
+    }
+
+    std::vector<ChannelDistances> distances(count);
+    for (int i = 0; i < count; i++) {
+        computeDistances(colors[i], distances[i]);
+    }
+
+    for (int red = 0; red < 16; red++) {
+        for (int green = 0; green < 16; green++) {
+            buildRow(distances.data(), count, red, green, m_table + (red << 8) + (green << 4));
+        }
+    }
+    if (firstIndex != 0) {
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            m_table[i] = static_cast<uint8_t>(m_table[i] + firstIndex);
+        }
+    }
+    return true;
+}
+
+void PaletteMapper::map(const uint8_t* rgba, size_t pixelCount, uint8_t* outIndices) const {
+    // Branch-free alpha test: transparency is data dependent and mispredicts badly
+    const uint8_t transparent = m_transparentIndex;
+    for (size_t i = 0; i < pixelCount; i++) {
+        const uint8_t* pixel = rgba + i * 4;
+        uint8_t index = m_table[((pixel[0] >> 4) << 8) | (pixel[1] & 0xF0) | (pixel[2] >> 4)];
+        uint8_t opaque = static_cast<uint8_t>(0 - (pixel[3] >> 7));
+        outIndices[i] = static_cast<uint8_t>(transparent ^ ((index ^ transparent) & opaque));
+    }
+}
+
+} // namespace SPRED
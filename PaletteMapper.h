@@ -0,0 +1,81 @@
+//
+//  PaletteMapper.h
+//  SPRED - Sprite Editor
+//
+//  Nearest-color lookup table for mapping RGBA pixels to palette indices
+//
+
+#ifndef SPRED_PALETTE_MAPPER_H
+#define SPRED_PALETTE_MAPPER_H
+
+#include "PNGConverter.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPRED {
+
+/// PaletteMapper - Exact 16x16x16 -> palette index table
+///
+/// Import quantizes every channel to its top 4 bits before matching, so only
+/// 4096 distinct colors ever reach the palette search. build() runs that
+/// search once per palette for all of them (the same squared RGB distance as
+/// Color::distanceTo, ties going to the earlier color), after which mapping
+/// is one table lookup per pixel regardless of palette size.
+///
+/// Pixels with alpha below 128 (Color::isTransparent) map to the transparent
+/// index; opaque pixels map to firstIndex plus the position of their nearest
+/// palette color.
+///
+/// Usage:
+///   PaletteMapper mapper;
+///   mapper.build(extractedColors, 2);     // Colors become indices 2, 3, ...
+///   mapper.map(rgba, width * height, indices);
+class PaletteMapper {
+public:
+    /// Table entries, one per 4-bit R, G, B combination
+    static constexpr int TABLE_SIZE = 4096;
+
+    PaletteMapper();
+
+    /// Build the table for a palette
+    /// @param colors Palette colors (alpha ignored); an empty palette maps
+    ///               everything to the transparent index
+    /// @param count Number of colors
+    /// @param firstIndex Index written for colors[0]
+    /// @param transparentIndex Index written for transparent pixels
+    /// @return false if firstIndex + count does not fit in a byte (the table is left unchanged)
+    bool build(const Color* colors, int count, int firstIndex = 0, uint8_t transparentIndex = 0);
+    bool build(const std::vector<Color>& colors, int firstIndex = 0, uint8_t transparentIndex = 0) {
+        return build(colors.data(), static_cast<int>(colors.size()), firstIndex, transparentIndex);
+    }
+
+    /// Index for a color; the low 4 bits of each channel are ignored
+    uint8_t lookup(uint8_t r, uint8_t g, uint8_t b) const {
+        return m_table[((r >> 4) << 8) | (g & 0xF0) | (b >> 4)];
+    }
+
+    /// Index for a pixel, including the transparency test
+    uint8_t map(const Color& pixel) const {
+        return pixel.isTransparent() ? m_transparentIndex : lookup(pixel.r, pixel.g, pixel.b);
+    }
+
+    /// Map RGBA pixels to indices
+    /// @param rgba Input pixels (pixelCount × 4 bytes)
+    /// @param outIndices One index per pixel
+    void map(const uint8_t* rgba, size_t pixelCount, uint8_t* outIndices) const;
+
+    uint8_t getTransparentIndex() const { return m_transparentIndex; }
+    const uint8_t* getTable() const { return m_table; }
+
+    /// Name of the build kernel chosen at compile time ("SSE2", "NEON" or "Scalar")
+    static const char* getKernelName();
+
+private:
+    uint8_t m_table[TABLE_SIZE];
+    uint8_t m_transparentIndex;
+};
+
+} // namespace SPRED
+
+#endif // SPRED_PALETTE_MAPPER_H
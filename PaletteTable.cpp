@@ -0,0 +1,56 @@
+//
+//  PaletteTable.cpp
+//  SPRED - Sprite Editor
+//
+//  Palette table implementation
+//
+
+#include "PaletteTable.h"
+#include "PaletteLibrary.h"
+
+using namespace SuperTerminal;
+
+namespace SPRED {
+
+PaletteTable::PaletteTable(SurfaceFormat format)
+    : m_format(format)
+{
+}
+
+uint16_t PaletteTable::add(const uint8_t* palette) {
+    size_t id = getCount();
+    if (!palette || id >= INVALID_ID) {
+        return INVALID_ID;
+    }
+    m_tables.resize(m_tables.size() + PaletteExpand::TABLE_SIZE);
+    PaletteExpand::buildTable(palette, m_format, &m_tables[id * PaletteExpand::TABLE_SIZE]);
+    return static_cast<uint16_t>(id);
+}
+
+uint16_t PaletteTable::addStandard(uint8_t standardID) {
+    uint8_t palette[64];
+    if (!StandardPaletteLibrary::copyPaletteRGBA(standardID, palette)) {
+        return INVALID_ID;
+    }
+    return add(palette);
+}
+
+bool PaletteTable::addStandardPalettes() {
+    if (!StandardPaletteLibrary::isInitialized() || getCount() + STANDARD_PALETTE_COUNT > INVALID_ID) {
+        return false;
+    }
+    for (int id = 0; id < STANDARD_PALETTE_COUNT; id++) {
+        addStandard(static_cast<uint8_t>(id));
+    }
+    return true;
+}
+
+bool PaletteTable::set(uint16_t id, const uint8_t* palette) {
+    if (!palette || id >= getCount()) {
+        return false;
+    }
+    PaletteExpand::buildTable(palette, m_format, &m_tables[size_t(id) * PaletteExpand::TABLE_SIZE]);
+    return true;
+}
+
+} // namespace SPRED
@@ -0,0 +1,78 @@
+//
+//  PaletteTable.h
+//  SPRED - Sprite Editor
+//
+//  ID-addressed expansion tables for palette-swapped sprite instances
+//
+
+#ifndef SPRED_PALETTE_TABLE_H
+#define SPRED_PALETTE_TABLE_H
+
+#include "PaletteExpand.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPRED {
+
+/// PaletteTable - Palettes stored once as 16-entry lookup tables
+///
+/// Each palette is kept only in expanded form (PaletteExpand::buildTable in
+/// the table's surface format), so a palette costs 64 bytes and is applied
+/// per pixel at blit time. Drawing N color variants of a sprite then needs
+/// one copy of its indices plus N palette IDs, instead of N recolored
+/// copies each expanded to RGBA.
+///
+/// Usage:
+///   PaletteTable palettes(SurfaceFormat::BGRA);
+///   palettes.addStandardPalettes();                   // IDs 0-31
+///   uint16_t red = palettes.add(redTeam.getPaletteData());
+///   PaletteExpand::expand(indices, 16, 16, palettes.getTable(red), dst, stride);
+class PaletteTable {
+public:
+    /// Returned when a palette cannot be added
+    static constexpr uint16_t INVALID_ID = 0xFFFF;
+
+    /// Bytes per stored palette
+    static constexpr size_t ENTRY_SIZE = PaletteExpand::TABLE_SIZE * sizeof(uint32_t);
+
+    explicit PaletteTable(SurfaceFormat format = SurfaceFormat::BGRA);
+
+    /// Add a palette
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @return Palette ID, or INVALID_ID if the table is full
+    uint16_t add(const uint8_t* palette);
+
+    /// Add one palette of the StandardPaletteLibrary
+    /// @param standardID Standard palette ID (0-31)
+    /// @return Palette ID, or INVALID_ID if the library is not loaded
+    uint16_t addStandard(uint8_t standardID);
+
+    /// Add all 32 standard palettes; on an empty table their IDs equal the standard IDs
+    /// @return false if the library is not loaded (nothing is added)
+    bool addStandardPalettes();
+
+    /// Replace a palette (palette animation: every instance using it changes)
+    /// @return false if the ID is invalid
+    bool set(uint16_t id, const uint8_t* palette);
+
+    /// Lookup table of a palette (PaletteExpand::TABLE_SIZE entries)
+    /// @return nullptr if the ID is invalid
+    const uint32_t* getTable(uint16_t id) const {
+        return id < getCount() ? &m_tables[size_t(id) * PaletteExpand::TABLE_SIZE] : nullptr;
+    }
+
+    size_t getCount() const { return m_tables.size() / PaletteExpand::TABLE_SIZE; }
+    size_t getMemoryUsage() const { return m_tables.size() * sizeof(uint32_t); }
+    SurfaceFormat getFormat() const { return m_format; }
+
+    void clear() { m_tables.clear(); }
+
+private:
+    SurfaceFormat m_format;
+    std::vector<uint32_t> m_tables;     // TABLE_SIZE entries per palette
+};
+
+} // namespace SPRED
+
+#endif // SPRED_PALETTE_TABLE_H
@@ -0,0 +1,342 @@
+//
+//  SpriteAtlas.cpp
+//  SPRED - Sprite Editor
+//
+//  Sprite atlas packer implementation
+//
+
+#include "SpriteAtlas.h"
+#include "SpriteData.h"
+#include "SpriteHash.h"
+#include "NibblePacking.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint16_t ATLAS_VERSION = 1;
+constexpr size_t ATLAS_PALETTE_SIZE = 64;
+constexpr int ATLAS_MAX_PAGES = 0xFFFF;
+constexpr size_t ATLAS_MAX_PALETTES = 0xFFFF;     // Table header stores a uint16 count
+
+/// Texel edge as a fraction of the page size, in UNORM16
+uint16_t toUNorm16(int texel, int pageSize) {
+    return static_cast<uint16_t>((uint32_t(texel) * 65535u + uint32_t(pageSize) / 2) / uint32_t(pageSize));
+}
+
+} // anonymous namespace
+
+SpriteAtlasBuilder::SpriteAtlasBuilder(int pageWidth, int pageHeight, int padding)
+    : m_pageWidth(std::min(std::max((pageWidth + 1) & ~1, 2), 65534))
+    , m_pageHeight(std::min(std::max(pageHeight, 1), 65535))
+    , m_padding(std::max(padding, 0))
+{
+}
+
+size_t SpriteAtlasBuilder::add(int width, int height, const uint8_t* pixels, const uint8_t* palette) {
+    m_items.push_back({width, height, pixels, palette, nullptr});
+    return m_items.size() - 1;
+}
+
+size_t SpriteAtlasBuilder::addSprite(const SpriteData& sprite) {
+    m_items.push_back({sprite.getWidth(), sprite.getHeight(), nullptr, sprite.getPaletteData(), &sprite});
+    return m_items.size() - 1;
+}
+
+void SpriteAtlasBuilder::clear() {
+    m_items.clear();
+    m_placements.clear();
+    m_pages.clear();
+    m_palettes.clear();
+    m_paletteIndex.clear();
+    m_stats = AtlasStats();
+}
+
+// ============================================================================
+// Packing
+// ============================================================================
+
+int SpriteAtlasBuilder::findPosition(const Page& page, int width, int height, int& outY) const {
+    // Boxes carry their padding on the right and bottom; the page is widened
+    // by the same amount so a sprite may touch the far edges.
+    const int binWidth = m_pageWidth + m_padding;
+    const int binHeight = m_pageHeight + m_padding;
+    const std::vector<Segment>& skyline = page.skyline;
+
+    int bestSegment = -1;
+    int bestTop = binHeight + 1;
+    for (size_t i = 0; i < skyline.size(); i++) {
+        int x = skyline[i].x;
+        if (x + width > binWidth) {
+            break;
+        }
+
+        // Resting height is the highest segment under the box
+        int y = 0;
+        int remaining = width;
+        for (size_t j = i; remaining > 0; j++) {
+            y = std::max(y, skyline[j].y);
+            remaining -= skyline[j].width;
+        }
+
+        if (y + height <= binHeight && y + height < bestTop) {
+            bestTop = y + height;
+            bestSegment = static_cast<int>(i);
+            outY = y;
+        }
+    }
+    return bestSegment;
+}
+
+void SpriteAtlasBuilder::place(Page& page, int segment, int y, int width, int height) {
+    std::vector<Segment>& skyline = page.skyline;
+    const int x = skyline[segment].x;
+    const int right = x + width;
+
+    // Segments now hidden under the box are removed, a partly covered one is trimmed
+    size_t next = segment;
+    while (next < skyline.size() && skyline[next].x + skyline[next].width <= right) {
+        next++;
+    }
+    if (next < skyline.size() && skyline[next].x < right) {
+        skyline[next].width -= right - skyline[next].x;
+        skyline[next].x = right;
+    }
+    skyline.erase(skyline.begin() + segment, skyline.begin() + next);
+    skyline.insert(skyline.begin() + segment, Segment{x, y + height, width});
+
+    // Merge neighbors at the same height so the skyline stays short
+    size_t first = segment > 0 ? segment - 1 : 0;
+    size_t last = std::min(static_cast<size_t>(segment) + 1, skyline.size() - 1);
+    for (size_t i = last; i > first; i--) {
+        if (skyline[i - 1].y == skyline[i].y) {
+            skyline[i - 1].width += skyline[i].width;
+            skyline.erase(skyline.begin() + i);
+        }
+    }
+}
+
+bool SpriteAtlasBuilder::addPalette(const uint8_t* palette, uint16_t& outID) {
+    uint64_t hash = SpriteHash::hash64(palette, ATLAS_PALETTE_SIZE);
+    std::vector<uint16_t>& candidates = m_paletteIndex[hash];
+    for (uint16_t id : candidates) {
+        if (std::memcmp(m_palettes[id], palette, ATLAS_PALETTE_SIZE) == 0) {
+            outID = id;
+            return true;
+        }
+    }
+    if (m_palettes.size() >= ATLAS_MAX_PALETTES) {
+        return false;
+    }
+    outID = static_cast<uint16_t>(m_palettes.size());
+    m_palettes.push_back(palette);
+    candidates.push_back(outID);
+    return true;
+}
+
+bool SpriteAtlasBuilder::build() {
+    auto start = std::chrono::steady_clock::now();
+    m_placements.clear();
+    m_pages.clear();
+    m_palettes.clear();
+    m_paletteIndex.clear();
+    m_stats = AtlasStats();
+
+    for (const Item& item : m_items) {
+        if (item.width <= 0 || item.height <= 0 || item.width > 255 || item.height > 255 ||
+            item.width > m_pageWidth || item.height > m_pageHeight || !item.palette) {
+            return false;
+        }
+    }
+
+    // Tallest first, then widest: keeps each skyline row close to flat
+    std::vector<uint32_t> order(m_items.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        if (m_items[a].height != m_items[b].height) {
+            return m_items[a].height > m_items[b].height;
+        }
+        return m_items[a].width > m_items[b].width;
+    });
+
+    std::vector<AtlasPlacement> placements(m_items.size());
+    for (uint32_t index : order) {
+        const Item& item = m_items[index];
+        const int width = item.width + m_padding;
+        const int height = item.height + m_padding;
+
+        int y = 0;
+        int segment = -1;
+        size_t pageIndex = 0;
+        for (; pageIndex < m_pages.size(); pageIndex++) {
+            segment = findPosition(m_pages[pageIndex], width, height, y);
+            if (segment >= 0) {
+                break;
+            }
+        }
+        if (segment < 0) {
+            if (m_pages.size() >= ATLAS_MAX_PAGES) {
+                m_pages.clear();
+                return false;
+            }
+            m_pages.emplace_back();
+            m_pages.back().skyline.push_back({0, 0, m_pageWidth + m_padding});
+            pageIndex = m_pages.size() - 1;
+            segment = findPosition(m_pages[pageIndex], width, height, y);
+        }
+
+        Page& page = m_pages[pageIndex];
+        AtlasPlacement& placement = placements[index];
+        placement.page = static_cast<uint16_t>(pageIndex);
+        placement.x = static_cast<uint16_t>(page.skyline[segment].x);
+        placement.y = static_cast<uint16_t>(y);
+        placement.width = static_cast<uint8_t>(item.width);
+        placement.height = static_cast<uint8_t>(item.height);
+        place(page, segment, y, width, height);
+
+        uint64_t area = uint64_t(item.width) * item.height;
+        page.spritePixels += area;
+        m_stats.spritePixels += area;
+    }
+
+    // Palettes are numbered in add order so the table does not depend on packing order
+    for (size_t i = 0; i < m_items.size(); i++) {
+        if (!addPalette(m_items[i].palette, placements[i].palette)) {
+            m_pages.clear();
+            m_palettes.clear();
+            m_paletteIndex.clear();
+            return false;
+        }
+    }
+
+    m_placements.swap(placements);
+    m_stats.spriteCount = m_items.size();
+    m_stats.pageCount = m_pages.size();
+    m_stats.paletteCount = m_palettes.size();
+    m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+const AtlasPlacement* SpriteAtlasBuilder::getPlacement(size_t index) const {
+    return index < m_placements.size() ? &m_placements[index] : nullptr;
+}
+
+double SpriteAtlasBuilder::getPageOccupancy(int page) const {
+    if (page < 0 || page >= getPageCount()) {
+        return 0.0;
+    }
+    return double(m_pages[page].spritePixels) / (double(m_pageWidth) * m_pageHeight);
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+bool SpriteAtlasBuilder::buildIndexedPage(int page, std::vector<uint8_t>& out) const {
+    if (page < 0 || page >= getPageCount()) {
+        return false;
+    }
+
+    // Compose byte-per-pixel, then pack the whole page in place
+    const size_t pixelCount = size_t(m_pageWidth) * m_pageHeight;
+    out.assign(pixelCount, 0);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    for (size_t i = 0; i < m_placements.size(); i++) {
+        const AtlasPlacement& placement = m_placements[i];
+        if (placement.page != page) {
+            continue;
+        }
+        const Item& item = m_items[i];
+        const uint8_t* pixels = item.sprite ? item.sprite->getUnpackedPixels(scratch) : item.pixels;
+        for (int row = 0; row < item.height; row++) {
+            std::memcpy(&out[size_t(placement.y + row) * m_pageWidth + placement.x],
+                        pixels + size_t(row) * item.width, item.width);
+        }
+    }
+    NibblePacking::pack(out.data(), out.data(), pixelCount);
+    out.resize(NibblePacking::packedSize(pixelCount));
+    return true;
+}
+
+bool SpriteAtlasBuilder::buildRGBAPage(int page, SurfaceFormat format, std::vector<uint8_t>& out) const {
+    if (page < 0 || page >= getPageCount()) {
+        return false;
+    }
+
+    const size_t stride = size_t(m_pageWidth) * 4;
+    out.assign(stride * m_pageHeight, 0);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    for (size_t i = 0; i < m_placements.size(); i++) {
+        const AtlasPlacement& placement = m_placements[i];
+        if (placement.page != page) {
+            continue;
+        }
+        const Item& item = m_items[i];
+        const uint8_t* pixels = item.sprite ? item.sprite->getUnpackedPixels(scratch) : item.pixels;
+        PaletteExpand::buildTable(item.palette, format, table);
+        PaletteExpand::expand(pixels, item.width, item.height, table,
+                              &out[placement.y * stride + size_t(placement.x) * 4], stride);
+    }
+    return true;
+}
+
+void SpriteAtlasBuilder::buildTable(AtlasPageFormat pageFormat, std::vector<uint8_t>& out) const {
+    AtlasTableHeader header = {};
+    std::memcpy(header.magic, "SPTA", 4);
+    header.version = ATLAS_VERSION;
+    header.entrySize = sizeof(AtlasTableEntry);
+    header.pageWidth = static_cast<uint16_t>(m_pageWidth);
+    header.pageHeight = static_cast<uint16_t>(m_pageHeight);
+    header.pageCount = static_cast<uint16_t>(m_pages.size());
+    header.paletteCount = static_cast<uint16_t>(m_palettes.size());
+    header.entryCount = static_cast<uint32_t>(m_placements.size());
+    header.pageFormat = static_cast<uint8_t>(pageFormat);
+
+    out.resize(sizeof(header) + m_palettes.size() * ATLAS_PALETTE_SIZE +
+               m_placements.size() * sizeof(AtlasTableEntry));
+    uint8_t* dst = out.data();
+    std::memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+
+    for (const uint8_t* palette : m_palettes) {
+        std::memcpy(dst, palette, ATLAS_PALETTE_SIZE);
+        dst += ATLAS_PALETTE_SIZE;
+    }
+
+    for (const AtlasPlacement& placement : m_placements) {
+        AtlasTableEntry entry = {};
+        entry.page = placement.page;
+        entry.palette = placement.palette;
+        entry.x = placement.x;
+        entry.y = placement.y;
+        entry.width = placement.width;
+        entry.height = placement.height;
+        entry.u0 = toUNorm16(placement.x, m_pageWidth);
+        entry.v0 = toUNorm16(placement.y, m_pageHeight);
+        entry.u1 = toUNorm16(placement.x + placement.width, m_pageWidth);
+        entry.v1 = toUNorm16(placement.y + placement.height, m_pageHeight);
+        std::memcpy(dst, &entry, sizeof(entry));
+        dst += sizeof(entry);
+    }
+}
+
+bool SpriteAtlasBuilder::writeTable(const std::string& filename, AtlasPageFormat pageFormat) const {
+    std::vector<uint8_t> image;
+    buildTable(pageFormat, image);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return file.good();
+}
+
+} // namespace SPRED
@@ -0,0 +1,230 @@
+//
+//  SpriteAtlas.h
+//  SPRED - Sprite Editor
+//
+//  Packs many sprites into shared texture pages for the runtime sprite layer
+//
+
+#ifndef SPRED_SPRITE_ATLAS_H
+#define SPRED_SPRITE_ATLAS_H
+
+#include "PaletteExpand.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// SPRTA Atlas Table Format
+/// ========================
+///
+/// Everything the runtime needs to draw from the atlas pages, in one file
+/// that is loaded with a single read. Pages are written separately (see
+/// SpriteAtlasBuilder::buildIndexedPage / buildRGBAPage).
+///
+/// Header (24 bytes):
+/// ------------------
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 4    | char[4] | Magic: "SPTA"
+/// 0x04   | 2    | uint16  | Version (1)
+/// 0x06   | 2    | uint16  | Entry size (20)
+/// 0x08   | 2    | uint16  | Page width
+/// 0x0A   | 2    | uint16  | Page height
+/// 0x0C   | 2    | uint16  | Page count
+/// 0x0E   | 2    | uint16  | Palette count
+/// 0x10   | 4    | uint32  | Entry count
+/// 0x14   | 1    | uint8   | Page format (0 = 4-bit indexed, 1 = RGBA, 2 = BGRA, 3/4 = premultiplied)
+/// 0x15   | 3    | uint8[] | Reserved (0)
+///
+/// Followed by palette count × 64-byte RGBA palettes (deduplicated), then
+/// one entry per sprite, in the order the sprites were added:
+///
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 2    | uint16  | Page
+/// 0x02   | 2    | uint16  | Palette index (indexed pages look colors up here)
+/// 0x04   | 2    | uint16  | X (texels)
+/// 0x06   | 2    | uint16  | Y (texels)
+/// 0x08   | 1    | uint8   | Width
+/// 0x09   | 1    | uint8   | Height
+/// 0x0A   | 2    | uint16  | Reserved (0)
+/// 0x0C   | 8    | uint16  | U0, V0, U1, V1 (texel edges / page size, UNORM16)
+///
+/// 4-bit indexed pages are NibblePacking rows (page width / 2 bytes each);
+/// index 0 is transparent and fills the padding between sprites.
+
+/// Atlas table header as stored in the file
+struct AtlasTableHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t entrySize;
+    uint16_t pageWidth;
+    uint16_t pageHeight;
+    uint16_t pageCount;
+    uint16_t paletteCount;
+    uint32_t entryCount;
+    uint8_t pageFormat;
+    uint8_t reserved[3];
+};
+
+/// Atlas table entry as stored in the file
+struct AtlasTableEntry {
+    uint16_t page;
+    uint16_t palette;
+    uint16_t x;
+    uint16_t y;
+    uint8_t width;
+    uint8_t height;
+    uint16_t reserved;
+    uint16_t u0;
+    uint16_t v0;
+    uint16_t u1;
+    uint16_t v1;
+};
+
+static_assert(sizeof(AtlasTableHeader) == 24, "SPRTA header must be 24 bytes");
+static_assert(sizeof(AtlasTableEntry) == 20, "SPRTA entries must be 20 bytes");
+
+/// Page pixel format recorded in the atlas table
+enum class AtlasPageFormat : uint8_t {
+    Indexed4 = 0,           // Nibble-packed palette indices
+    RGBA = 1,
+    BGRA = 2,
+    PremultipliedRGBA = 3,
+    PremultipliedBGRA = 4
+};
+
+/// Where one sprite landed
+struct AtlasPlacement {
+    uint16_t page;
+    uint16_t x;
+    uint16_t y;
+    uint8_t width;
+    uint8_t height;
+    uint16_t palette;       // Index into the deduplicated palette list
+};
+
+/// Results of the last build
+struct AtlasStats {
+    size_t spriteCount = 0;
+    size_t pageCount = 0;
+    size_t paletteCount = 0;
+    uint64_t spritePixels = 0;      // Sum of sprite areas
+    double seconds = 0.0;           // Packing time
+
+    /// Fraction of all page area covered by sprites
+    double getOccupancy(int pageWidth, int pageHeight) const {
+        uint64_t area = uint64_t(pageWidth) * pageHeight * pageCount;
+        return area > 0 ? double(spritePixels) / area : 0.0;
+    }
+};
+
+/// SpriteAtlasBuilder - Skyline packer for sprite pages
+///
+/// Sprites are sorted tallest first and placed bottom-left on a skyline
+/// (the top edge of everything placed so far). Each sprite goes to the
+/// first page it fits on, so small sprites fill gaps on earlier pages.
+///
+/// Usage:
+///   SpriteAtlasBuilder atlas(1024, 1024);
+///   for (const SpriteData& sprite : sprites) atlas.addSprite(sprite);
+///   atlas.build();
+///   atlas.writeTable("sprites.spta", AtlasPageFormat::Indexed4);
+///   for (int page = 0; page < atlas.getPageCount(); page++) atlas.buildIndexedPage(page, pixels);
+class SpriteAtlasBuilder {
+public:
+    /// @param pageWidth Page width in texels (rounded up to even, at most 65534)
+    /// @param pageHeight Page height in texels (at most 65535)
+    /// @param padding Transparent texels kept right of and below each sprite
+    explicit SpriteAtlasBuilder(int pageWidth = 1024, int pageHeight = 1024, int padding = 1);
+
+    /// Queue a sprite (pixels and palette must stay valid until pages are built)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @return Sprite index (entry order in the table)
+    size_t add(int width, int height, const uint8_t* pixels, const uint8_t* palette);
+
+    /// Queue a SpriteData (must stay valid until pages are built)
+    size_t addSprite(const SpriteData& sprite);
+
+    /// Pack every queued sprite
+    /// @return false if a sprite is larger than a page, or the pages or
+    ///         distinct palettes would exceed the table's 16-bit counts
+    bool build();
+
+    /// Placement of a sprite after build()
+    /// @return nullptr if the index is invalid or build() has not succeeded
+    const AtlasPlacement* getPlacement(size_t index) const;
+
+    int getPageCount() const { return static_cast<int>(m_pages.size()); }
+    int getPageWidth() const { return m_pageWidth; }
+    int getPageHeight() const { return m_pageHeight; }
+
+    /// Fraction of one page covered by sprites
+    double getPageOccupancy(int page) const;
+
+    const AtlasStats& getStats() const { return m_stats; }
+
+    /// Build a page as nibble-packed indices (pageWidth / 2 × pageHeight bytes)
+    bool buildIndexedPage(int page, std::vector<uint8_t>& out) const;
+
+    /// Build a page as 32-bit pixels (pageWidth × 4 × pageHeight bytes)
+    bool buildRGBAPage(int page, SurfaceFormat format, std::vector<uint8_t>& out) const;
+
+    /// Build the SPRTA table image
+    /// @param pageFormat Format the pages are emitted in (recorded for the runtime)
+    void buildTable(AtlasPageFormat pageFormat, std::vector<uint8_t>& out) const;
+
+    /// Write the SPRTA table with a single write call
+    bool writeTable(const std::string& filename, AtlasPageFormat pageFormat) const;
+
+    size_t getQueuedCount() const { return m_items.size(); }
+    void clear();
+
+private:
+    struct Item {
+        int width;
+        int height;
+        const uint8_t* pixels;
+        const uint8_t* palette;
+        const SpriteData* sprite;   // Set for addSprite; pixels resolved when pages are built
+    };
+
+    /// Horizontal run of the skyline at height y
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Page {
+        std::vector<Segment> skyline;
+        uint64_t spritePixels = 0;
+    };
+
+    int m_pageWidth;
+    int m_pageHeight;
+    int m_padding;
+    std::vector<Item> m_items;
+    std::vector<AtlasPlacement> m_placements;
+    std::vector<Page> m_pages;
+    std::vector<const uint8_t*> m_palettes;
+    std::unordered_map<uint64_t, std::vector<uint16_t>> m_paletteIndex;
+    AtlasStats m_stats;
+
+    /// Lowest position on a page for a padded width × height box
+    /// @return Skyline segment the box starts on, or -1 if it does not fit
+    int findPosition(const Page& page, int width, int height, int& outY) const;
+    void place(Page& page, int segment, int y, int width, int height);
+    /// @return false once the palette table is full
+    bool addPalette(const uint8_t* palette, uint16_t& outID);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_ATLAS_H
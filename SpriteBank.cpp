@@ -0,0 +1,428 @@
+//
+//  SpriteBank.cpp
+//  SPRED - Sprite Editor
+//
+//  SPRTB sprite bank container implementation
+//
+
+#include "SpriteBank.h"
+#include "SpriteCompression.h"
+#include "SpriteData.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint16_t BANK_VERSION = 1;
+constexpr uint32_t BANK_HEADER_SIZE = 32;
+
+struct BankHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t entryCount;
+    uint32_t indexOffset;
+    uint32_t namesOffset;
+    uint32_t namesSize;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+};
+
+static_assert(sizeof(BankHeader) == BANK_HEADER_SIZE, "SPRTB header must be 32 bytes");
+
+/// Read width, height, palette mode and version from a SPRTZ file image
+bool peekSPRTZ(const uint8_t* data, size_t size, SpriteBankEntry& entry) {
+    if (size < 17 || data[0] != 'S' || data[1] != 'P' || data[2] != 'T' || data[3] != 'Z') {
+        return false;
+    }
+
+    uint16_t version;
+    std::memcpy(&version, data + 4, sizeof(version));
+    if (version == 1) {
+        entry.paletteMode = 0xFF;
+    } else if (version == 2 || version == 3) {
+        entry.paletteMode = data[16];
+    } else {
+        return false;
+    }
+
+    entry.version = static_cast<uint8_t>(version);
+    entry.width = data[6];
+    entry.height = data[7];
+    return entry.width > 0 && entry.height > 0;
+}
+
+} // namespace
+
+// =============================================================================
+// SpriteBankReader
+// =============================================================================
+
+SpriteBankReader::~SpriteBankReader() {
+    close();
+}
+
+bool SpriteBankReader::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(BANK_HEADER_SIZE)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(mapped);
+    m_size = static_cast<size_t>(st.st_size);
+    m_mapped = true;
+
+    if (!parse()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SpriteBankReader::openMemory(const uint8_t* data, size_t size) {
+    close();
+
+    if (!data || size < BANK_HEADER_SIZE ||
+        reinterpret_cast<uintptr_t>(data) % alignof(SpriteBankEntry) != 0) {
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_mapped = false;
+
+    if (!parse()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SpriteBankReader::close() {
+    if (m_mapped && m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_entryCount = 0;
+    m_entries = nullptr;
+    m_names = nullptr;
+    m_namesSize = 0;
+}
+
+bool SpriteBankReader::parse() {
+    BankHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+
+    if (header.magic[0] != 'S' || header.magic[1] != 'P' ||
+        header.magic[2] != 'T' || header.magic[3] != 'B') {
+        return false;
+    }
+    if (header.version != BANK_VERSION || header.entrySize != sizeof(SpriteBankEntry)) {
+        return false;
+    }
+
+    // Validate table bounds once so entry access never has to
+    uint64_t indexEnd = uint64_t(header.indexOffset) + uint64_t(header.entryCount) * sizeof(SpriteBankEntry);
+    uint64_t namesEnd = uint64_t(header.namesOffset) + header.namesSize;
+    uint64_t dataEnd = uint64_t(header.dataOffset) + header.dataSize;
+    if (header.indexOffset % alignof(SpriteBankEntry) != 0 ||
+        indexEnd > m_size || namesEnd > m_size || dataEnd > m_size) {
+        return false;
+    }
+    if (header.namesSize > 0 && m_data[header.namesOffset + header.namesSize - 1] != '\0') {
+        return false;
+    }
+
+    m_entries = reinterpret_cast<const SpriteBankEntry*>(m_data + header.indexOffset);
+    m_entryCount = header.entryCount;
+    m_names = reinterpret_cast<const char*>(m_data + header.namesOffset);
+    m_namesSize = header.namesSize;
+
+    for (uint32_t i = 0; i < m_entryCount; i++) {
+        const SpriteBankEntry& entry = m_entries[i];
+        if (entry.offset < header.dataOffset ||
+            uint64_t(entry.offset) + entry.size > dataEnd ||
+            entry.nameOffset >= m_namesSize) {
+            return false;
+        }
+        if (i > 0 && m_entries[i - 1].nameHash >= entry.nameHash) {
+            return false; // Index must be strictly sorted
+        }
+    }
+
+    return true;
+}
+
+const SpriteBankEntry* SpriteBankReader::getEntry(uint32_t index) const {
+    if (index >= m_entryCount) {
+        return nullptr;
+    }
+    return &m_entries[index];
+}
+
+const char* SpriteBankReader::getEntryName(uint32_t index) const {
+    if (index >= m_entryCount) {
+        return nullptr;
+    }
+    return m_names + m_entries[index].nameOffset;
+}
+
+int SpriteBankReader::findEntry(const std::string& name) const {
+    uint64_t hash = SpriteBankWriter::hashName(name);
+
+    const SpriteBankEntry* begin = m_entries;
+    const SpriteBankEntry* end = m_entries + m_entryCount;
+    const SpriteBankEntry* it = std::lower_bound(begin, end, hash,
+        [](const SpriteBankEntry& entry, uint64_t h) { return entry.nameHash < h; });
+
+    if (it == end || it->nameHash != hash) {
+        return -1;
+    }
+    // A name missing from the bank can still share a stored name's hash
+    int index = static_cast<int>(it - begin);
+    return name.compare(getEntryName(index)) == 0 ? index : -1;
+}
+
+bool SpriteBankReader::getPayload(uint32_t index, const uint8_t*& outData, size_t& outSize) const {
+    const SpriteBankEntry* entry = getEntry(index);
+    if (!entry) {
+        return false;
+    }
+    outData = m_data + entry->offset;
+    outSize = entry->size;
+    return true;
+}
+
+bool SpriteBankReader::getEntryInfo(uint32_t index, SPRTZInfo& outInfo) const {
+    const uint8_t* payload;
+    size_t payloadSize;
+    return getPayload(index, payload, payloadSize) &&
+           SpriteCompression::readSPRTZInfo(payload, payloadSize, outInfo);
+}
+
+bool SpriteBankReader::getContentHash(uint32_t index, uint64_t& outHash) const {
+    SPRTZInfo info;
+    if (!getEntryInfo(index, info) || !info.hasContentHash) {
+        return false;
+    }
+    outHash = info.contentHash;
+    return true;
+}
+
+bool SpriteBankReader::validate(std::vector<uint32_t>& outFailedEntries) const {
+    outFailedEntries.clear();
+    for (uint32_t i = 0; i < m_entryCount; i++) {
+        const uint8_t* payload = m_data + m_entries[i].offset;
+        if (!SpriteCompression::validateSPRTZ(payload, m_entries[i].size)) {
+            outFailedEntries.push_back(i);
+        }
+    }
+    return outFailedEntries.empty();
+}
+
+bool SpriteBankReader::decodeEntry(uint32_t index,
+                                   int& outWidth, int& outHeight,
+                                   uint8_t* outPixels,
+                                   uint8_t* outPalette,
+                                   bool& outIsStandard,
+                                   uint8_t& outPaletteID) const {
+    const uint8_t* payload;
+    size_t payloadSize;
+    if (!getPayload(index, payload, payloadSize)) {
+        return false;
+    }
+    return SpriteCompression::decodeSPRTZv2(payload, payloadSize,
+                                            outWidth, outHeight,
+                                            outPixels, outPalette,
+                                            outIsStandard, outPaletteID);
+}
+
+bool SpriteBankReader::decodeEntryToSurface(uint32_t index, const SpriteSurface& surface, int x, int y,
+                                            int& outWidth, int& outHeight) const {
+    const uint8_t* payload;
+    size_t payloadSize;
+    if (!getPayload(index, payload, payloadSize)) {
+        return false;
+    }
+    return SpriteCompression::decodeSPRTZToSurface(payload, payloadSize, surface, x, y,
+                                                   outWidth, outHeight);
+}
+
+// =============================================================================
+// SpriteBankWriter
+// =============================================================================
+
+uint64_t SpriteBankWriter::hashName(const std::string& name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool SpriteBankWriter::addPayload(const std::string& name, const uint8_t* data, size_t size) {
+    SpriteBankEntry entry;
+    if (name.empty() || !data || !peekSPRTZ(data, size, entry)) {
+        return false;
+    }
+
+    uint64_t hash = hashName(name);
+    if (!m_hashes.insert(hash).second) {
+        return false; // Duplicate name (or hash collision)
+    }
+
+    m_items.push_back({name, hash, std::vector<uint8_t>(data, data + size)});
+    return true;
+}
+
+bool SpriteBankWriter::addFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<uint8_t> payload((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+    std::string name = std::filesystem::path(path).stem().string();
+    return addPayload(name, payload.data(), payload.size());
+}
+
+int SpriteBankWriter::addDirectory(const std::string& directory) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory, ec);
+    if (ec) {
+        return -1;
+    }
+
+    // Sort paths so the bank contents do not depend on directory order
+    std::vector<std::string> paths;
+    for (const auto& dirEntry : it) {
+        if (dirEntry.is_regular_file() && dirEntry.path().extension() == ".sprtz") {
+            paths.push_back(dirEntry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    int added = 0;
+    for (const std::string& path : paths) {
+        if (addFile(path)) {
+            added++;
+        }
+    }
+    return added;
+}
+
+bool SpriteBankWriter::addSprite(const std::string& name, const SpriteData& sprite,
+                                 uint8_t standardPaletteID) {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    const uint8_t* pixels = sprite.getUnpackedPixels(scratch);
+
+    std::vector<uint8_t> payload;
+    bool encoded;
+    if (standardPaletteID == 0xFF) {
+        encoded = SpriteCompression::encodeSPRTZv2Custom(payload,
+                                                         sprite.getWidth(), sprite.getHeight(),
+                                                         pixels,
+                                                         sprite.getPaletteData());
+    } else {
+        encoded = SpriteCompression::encodeSPRTZv2Standard(payload,
+                                                           sprite.getWidth(), sprite.getHeight(),
+                                                           pixels,
+                                                           standardPaletteID);
+    }
+    return encoded && addPayload(name, payload.data(), payload.size());
+}
+
+void SpriteBankWriter::build(std::vector<uint8_t>& out) const {
+    std::vector<const Item*> sorted;
+    sorted.reserve(m_items.size());
+    for (const Item& item : m_items) {
+        sorted.push_back(&item);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Item* a, const Item* b) { return a->hash < b->hash; });
+
+    uint32_t namesSize = 0;
+    uint32_t dataSize = 0;
+    for (const Item* item : sorted) {
+        namesSize += static_cast<uint32_t>(item->name.size() + 1);
+        dataSize += static_cast<uint32_t>(item->payload.size());
+    }
+
+    BankHeader header;
+    header.magic[0] = 'S';
+    header.magic[1] = 'P';
+    header.magic[2] = 'T';
+    header.magic[3] = 'B';
+    header.version = BANK_VERSION;
+    header.entrySize = sizeof(SpriteBankEntry);
+    header.entryCount = static_cast<uint32_t>(sorted.size());
+    header.indexOffset = BANK_HEADER_SIZE;
+    header.namesOffset = header.indexOffset + header.entryCount * sizeof(SpriteBankEntry);
+    header.namesSize = namesSize;
+    header.dataOffset = header.namesOffset + namesSize;
+    header.dataSize = dataSize;
+
+    out.assign(header.dataOffset + dataSize, 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    uint32_t nameOffset = 0;
+    uint32_t dataOffset = header.dataOffset;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const Item& item = *sorted[i];
+
+        SpriteBankEntry entry;
+        peekSPRTZ(item.payload.data(), item.payload.size(), entry);
+        entry.nameHash = item.hash;
+        entry.offset = dataOffset;
+        entry.size = static_cast<uint32_t>(item.payload.size());
+        entry.nameOffset = nameOffset;
+        std::memcpy(out.data() + header.indexOffset + i * sizeof(SpriteBankEntry), &entry, sizeof(entry));
+
+        std::memcpy(out.data() + header.namesOffset + nameOffset, item.name.c_str(), item.name.size() + 1);
+        nameOffset += static_cast<uint32_t>(item.name.size() + 1);
+
+        std::memcpy(out.data() + dataOffset, item.payload.data(), item.payload.size());
+        dataOffset += entry.size;
+    }
+}
+
+bool SpriteBankWriter::write(const std::string& filename) const {
+    std::vector<uint8_t> image;
+    build(image);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return file.good();
+}
+
+} // namespace SPRED
@@ -0,0 +1,212 @@
+//
+//  SpriteBank.h
+//  SPRED - Sprite Editor
+//
+//  SPRTB sprite bank container (many SPRTZ payloads in one file)
+//
+
+#ifndef SPRED_SPRITE_BANK_H
+#define SPRED_SPRITE_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+struct SPRTZInfo;
+struct SpriteSurface;
+
+/// SPRTB Format Specification
+/// ===========================
+///
+/// A bank stores complete SPRTZ file images (v1, v2 or v3) back to back behind a
+/// fixed-size index sorted by name hash. The file is designed to be memory
+/// mapped: once open, any entry can be located and decoded without I/O.
+///
+/// Header (32 bytes):
+/// ------------------
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 4    | char[4] | Magic: "SPTB"
+/// 0x04   | 2    | uint16  | Version (1)
+/// 0x06   | 2    | uint16  | Index entry size (24)
+/// 0x08   | 4    | uint32  | Entry count
+/// 0x0C   | 4    | uint32  | Index offset (always 32)
+/// 0x10   | 4    | uint32  | Name table offset
+/// 0x14   | 4    | uint32  | Name table size
+/// 0x18   | 4    | uint32  | Payload data offset
+/// 0x1C   | 4    | uint32  | Payload data size
+///
+/// Index Entry (24 bytes, sorted by ascending name hash):
+/// -------------------------------------------------------
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 8    | uint64  | Name hash (FNV-1a 64)
+/// 0x08   | 4    | uint32  | Payload offset (from start of file)
+/// 0x0C   | 4    | uint32  | Payload size
+/// 0x10   | 1    | uint8   | Width
+/// 0x11   | 1    | uint8   | Height
+/// 0x12   | 1    | uint8   | Palette mode (0-31 standard, 0xFF custom)
+/// 0x13   | 1    | uint8   | SPRTZ version of the payload
+/// 0x14   | 4    | uint32  | Name offset into the name table
+///
+/// Name Table:
+/// -----------
+/// Zero-terminated UTF-8 names, referenced by the index entries.
+
+/// Index entry as stored in the file
+struct SpriteBankEntry {
+    uint64_t nameHash;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t width;
+    uint8_t height;
+    uint8_t paletteMode;
+    uint8_t version;
+    uint32_t nameOffset;
+};
+
+static_assert(sizeof(SpriteBankEntry) == 24, "SPRTB index entries must be 24 bytes");
+
+/// SpriteBankReader - Memory-maps an SPRTB bank and decodes entries in place
+class SpriteBankReader {
+public:
+    SpriteBankReader() = default;
+    ~SpriteBankReader();
+
+    SpriteBankReader(const SpriteBankReader&) = delete;
+    SpriteBankReader& operator=(const SpriteBankReader&) = delete;
+
+    /// Memory-map a bank file and validate its header and index
+    /// @param filename Bank file path
+    /// @return true if successful
+    bool open(const std::string& filename);
+
+    /// Use a bank image that is already in memory (not copied, must outlive the reader)
+    /// @param data Start of the bank image (8-byte aligned; the index is read in place)
+    /// @param size Size of the bank image in bytes
+    /// @return true if successful
+    bool openMemory(const uint8_t* data, size_t size);
+
+    /// Unmap the bank
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    uint32_t getEntryCount() const { return m_entryCount; }
+
+    /// Get index entry
+    /// @param index Entry index (0 to getEntryCount()-1, in name hash order)
+    /// @return Pointer into the mapped index, or nullptr if invalid
+    const SpriteBankEntry* getEntry(uint32_t index) const;
+
+    /// Get entry name
+    /// @return Zero-terminated name, or nullptr if invalid
+    const char* getEntryName(uint32_t index) const;
+
+    /// Find entry by name (binary search on name hash, then a name compare)
+    /// @return Entry index, or -1 if not found
+    int findEntry(const std::string& name) const;
+
+    /// Get the raw SPRTZ file image of an entry
+    /// @return true if successful
+    bool getPayload(uint32_t index, const uint8_t*& outData, size_t& outSize) const;
+
+    /// Read the SPRTZ header of an entry without decoding it
+    /// @return true if successful
+    bool getEntryInfo(uint32_t index, SPRTZInfo& outInfo) const;
+
+    /// Get the content hash stored in an entry's SPRTZ v3 header
+    /// Lets a cache of decoded sprites check it is current without decoding.
+    /// @return true if the entry carries a content hash
+    bool getContentHash(uint32_t index, uint64_t& outHash) const;
+
+    /// Decode and check every entry (content hashes where present)
+    /// @param outFailedEntries Output: indices of entries that fail to decode or match
+    /// @return true if every entry is valid
+    bool validate(std::vector<uint32_t>& outFailedEntries) const;
+
+    /// Decode an entry (no file I/O)
+    /// @param index Entry index
+    /// @param outWidth Output sprite width
+    /// @param outHeight Output sprite height
+    /// @param outPixels Output pixel buffer (must be at least 40×40 = 1600 bytes)
+    /// @param outPalette Output palette buffer (must be 64 bytes)
+    /// @param outIsStandard Output: true if using standard palette, false if custom
+    /// @param outPaletteID Output: standard palette ID (0-31) or 0xFF if custom
+    /// @return true if successful
+    bool decodeEntry(uint32_t index,
+                     int& outWidth, int& outHeight,
+                     uint8_t* outPixels,
+                     uint8_t* outPalette,
+                     bool& outIsStandard,
+                     uint8_t& outPaletteID) const;
+
+    /// Decode an entry straight into a 32-bit surface at (x, y)
+    /// @return true if successful (false if the sprite does not fit)
+    bool decodeEntryToSurface(uint32_t index, const SpriteSurface& surface, int x, int y,
+                              int& outWidth, int& outHeight) const;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+    uint32_t m_entryCount = 0;
+    const SpriteBankEntry* m_entries = nullptr;
+    const char* m_names = nullptr;
+    uint32_t m_namesSize = 0;
+
+    bool parse();
+};
+
+/// SpriteBankWriter - Collects SPRTZ payloads and writes an SPRTB bank
+class SpriteBankWriter {
+public:
+    /// Add a complete SPRTZ file image (v1, v2 or v3)
+    /// @param name Entry name (must be unique within the bank)
+    /// @return true if the payload is a valid SPRTZ image and the name is unused
+    bool addPayload(const std::string& name, const uint8_t* data, size_t size);
+
+    /// Add a .sprtz file, named after its file name without extension
+    bool addFile(const std::string& path);
+
+    /// Add every .sprtz file in a directory (not recursive)
+    /// @return Number of files added, or -1 if the directory cannot be read
+    int addDirectory(const std::string& directory);
+
+    /// Encode and add a sprite as SPRTZ v2
+    /// @param standardPaletteID Standard palette ID (0-31), or 0xFF to embed the sprite palette
+    bool addSprite(const std::string& name, const SpriteData& sprite,
+                   uint8_t standardPaletteID = 0xFF);
+
+    /// Write the bank with a single write call
+    bool write(const std::string& filename) const;
+
+    /// Build the bank image in memory
+    void build(std::vector<uint8_t>& out) const;
+
+    size_t getEntryCount() const { return m_items.size(); }
+    void clear() {
+        m_items.clear();
+        m_hashes.clear();
+    }
+
+    /// FNV-1a 64-bit hash used for entry names
+    static uint64_t hashName(const std::string& name);
+
+private:
+    struct Item {
+        std::string name;
+        uint64_t hash;
+        std::vector<uint8_t> payload;
+    };
+    std::vector<Item> m_items;
+    std::unordered_set<uint64_t> m_hashes;  // Name hashes already added
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_BANK_H
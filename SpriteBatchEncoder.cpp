@@ -0,0 +1,114 @@
+//
+//  SpriteBatchEncoder.cpp
+//  SPRED - Sprite Editor
+//
+//  Batch SPRTZ v3 encoder implementation
+//
+
+#include "SpriteBatchEncoder.h"
+#include "SpriteCompression.h"
+#include "SpriteData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace SPRED {
+
+SpriteBatchEncoder::SpriteBatchEncoder(SPRTZCodec codec, int threadCount)
+    : m_codec(codec)
+    , m_threadCount(threadCount)
+{
+}
+
+void SpriteBatchEncoder::add(const std::string& filename, int width, int height,
+                             const uint8_t* pixels, const uint8_t* palette,
+                             uint8_t standardPaletteID) {
+    m_items.push_back({filename, width, height, pixels, palette, nullptr, standardPaletteID});
+}
+
+void SpriteBatchEncoder::addSprite(const std::string& filename, const SpriteData& sprite,
+                                   uint8_t standardPaletteID) {
+    m_items.push_back({filename, sprite.getWidth(), sprite.getHeight(),
+                       nullptr, sprite.getPaletteData(), &sprite, standardPaletteID});
+}
+
+bool SpriteBatchEncoder::writeFiles() {
+    return run(nullptr);
+}
+
+bool SpriteBatchEncoder::encodeAll(std::vector<std::vector<uint8_t>>& outImages) {
+    outImages.assign(m_items.size(), std::vector<uint8_t>());
+    return run(&outImages);
+}
+
+bool SpriteBatchEncoder::run(std::vector<std::vector<uint8_t>>* outImages) {
+    m_stats = SpriteBatchStats();
+    auto start = std::chrono::steady_clock::now();
+
+    int threadCount = m_threadCount > 0 ? m_threadCount
+                                        : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max(1, std::min(threadCount, static_cast<int>(m_items.size())));
+
+    std::atomic<size_t> next(0);
+    std::vector<SpriteBatchStats> workerStats(threadCount);
+
+    auto worker = [&](SpriteBatchStats& stats) {
+        SpriteCodecContext context;
+        std::vector<uint8_t> arena;     // Reused file image when writing to disk
+        uint8_t scratch[MAX_SPRITE_PIXELS];
+
+        for (size_t i = next++; i < m_items.size(); i = next++) {
+            const Item& item = m_items[i];
+            const uint8_t* pixels = item.sprite ? item.sprite->getUnpackedPixels(scratch) : item.pixels;
+            std::vector<uint8_t>& image = outImages ? (*outImages)[i] : arena;
+
+            bool ok = pixels &&
+                      SpriteCompression::encodeSPRTZv3(image, item.width, item.height, pixels,
+                                                       item.paletteMode, item.palette,
+                                                       m_codec, &context, m_dictionaryID);
+            if (ok && !outImages) {
+                std::ofstream file(item.filename, std::ios::binary);
+                file.write(reinterpret_cast<const char*>(image.data()), image.size());
+                ok = file.good();
+            }
+
+            if (!ok) {
+                if (outImages) {
+                    image.clear();
+                }
+                stats.failedCount++;
+                continue;
+            }
+            stats.spriteCount++;
+            stats.inputBytes += static_cast<uint64_t>(item.width) * item.height;
+            stats.outputBytes += image.size();
+        }
+    };
+
+    if (threadCount == 1) {
+        worker(workerStats[0]);
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back(worker, std::ref(workerStats[t]));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    for (const SpriteBatchStats& stats : workerStats) {
+        m_stats.spriteCount += stats.spriteCount;
+        m_stats.failedCount += stats.failedCount;
+        m_stats.inputBytes += stats.inputBytes;
+        m_stats.outputBytes += stats.outputBytes;
+    }
+    m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return m_stats.failedCount == 0;
+}
+
+} // namespace SPRED
@@ -0,0 +1,112 @@
+//
+//  SpriteBatchEncoder.h
+//  SPRED - Sprite Editor
+//
+//  Batch SPRTZ v3 encoder for re-encoding whole sprite libraries
+//
+
+#ifndef SPRED_SPRITE_BATCH_ENCODER_H
+#define SPRED_SPRITE_BATCH_ENCODER_H
+
+#include "SpriteCodecs.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// Aggregate results of one batch run
+struct SpriteBatchStats {
+    size_t spriteCount = 0;         // Sprites encoded successfully
+    size_t failedCount = 0;         // Sprites that failed to encode or write
+    uint64_t inputBytes = 0;        // Pixel index bytes consumed
+    uint64_t outputBytes = 0;       // SPRTZ file image bytes produced
+    double seconds = 0.0;           // Wall time for the whole run
+
+    /// Pixel throughput in MB/s
+    double getMegabytesPerSecond() const {
+        return seconds > 0.0 ? inputBytes / seconds / (1024.0 * 1024.0) : 0.0;
+    }
+};
+
+/// SpriteBatchEncoder - Encodes many sprites as SPRTZ v3 file images
+///
+/// Each worker owns a SpriteCodecContext (deflate stream reset per sprite) and
+/// an output arena whose capacity is kept, so steady-state encoding does not
+/// allocate. Every file is emitted with a single write.
+///
+/// Usage:
+///   SpriteBatchEncoder encoder(SPRTZCodec::AutoSmallest, 0);
+///   encoder.addSprite("out/ship.sprtz", ship);
+///   encoder.addSprite("out/rock.sprtz", rock, 3);
+///   encoder.writeFiles();
+///   printf("%.1f MB/s\n", encoder.getStats().getMegabytesPerSecond());
+class SpriteBatchEncoder {
+public:
+    /// @param codec Codec or Auto selection mode for every sprite
+    /// @param threadCount Worker threads (0 = hardware concurrency, 1 = encode on the calling thread)
+    explicit SpriteBatchEncoder(SPRTZCodec codec = SPRTZCodec::AutoSmallest, int threadCount = 1);
+
+    /// Queue a sprite (pixels and palette are read during the run and must stay valid)
+    /// @param filename Output path (only used by writeFiles)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param palette Full 64-byte palette (RGBA), only read when standardPaletteID is 0xFF
+    /// @param standardPaletteID Standard palette ID (0-31), or 0xFF to embed the palette
+    void add(const std::string& filename, int width, int height,
+             const uint8_t* pixels, const uint8_t* palette,
+             uint8_t standardPaletteID = 0xFF);
+
+    /// Queue a SpriteData (must stay valid until the run completes)
+    void addSprite(const std::string& filename, const SpriteData& sprite,
+                   uint8_t standardPaletteID = 0xFF);
+
+    /// Encode every queued sprite and write each to its file
+    /// @return true if every sprite was written
+    bool writeFiles();
+
+    /// Encode every queued sprite into memory
+    /// @param outImages Output file images, in queue order (failed sprites are left empty)
+    /// @return true if every sprite was encoded
+    bool encodeAll(std::vector<std::vector<uint8_t>>& outImages);
+
+    /// Statistics for the last run
+    const SpriteBatchStats& getStats() const { return m_stats; }
+
+    size_t getQueuedCount() const { return m_items.size(); }
+    void clear() { m_items.clear(); }
+
+    void setCodec(SPRTZCodec codec) { m_codec = codec; }
+    SPRTZCodec getCodec() const { return m_codec; }
+
+    void setThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+    /// Preset zlib dictionary for every sprite (0 = none, must be registered)
+    void setDictionaryID(uint8_t dictionaryID) { m_dictionaryID = dictionaryID; }
+    uint8_t getDictionaryID() const { return m_dictionaryID; }
+
+private:
+    struct Item {
+        std::string filename;
+        int width;
+        int height;
+        const uint8_t* pixels;
+        const uint8_t* palette;
+        const SpriteData* sprite;   // Set for addSprite; pixels resolved per run
+        uint8_t paletteMode;
+    };
+
+    std::vector<Item> m_items;
+    SPRTZCodec m_codec;
+    int m_threadCount;
+    uint8_t m_dictionaryID = 0;
+    SpriteBatchStats m_stats;
+
+    bool run(std::vector<std::vector<uint8_t>>* outImages);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_BATCH_ENCODER_H
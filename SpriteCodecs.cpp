@@ -0,0 +1,656 @@
+//
+//  SpriteCodecs.cpp
+//  SPRED - Sprite Editor
+//
+//  Pixel payload codecs for SPRTZ v3
+//
+
+#include "SpriteCodecs.h"
+#include "SpriteDictionary.h"
+#include "NibblePacking.h"
+#include "SpriteTrace.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint8_t RLE_LONG_RUN = 0xF0;
+constexpr int LZ_MIN_MATCH = 4;
+constexpr int LZ_MAX_OFFSET = 65535;
+constexpr int LZ_HASH_BITS = 12;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hashLZ(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+void appendLength(std::vector<uint8_t>& out, int remaining) {
+    while (remaining >= 255) {
+        out.push_back(255);
+        remaining -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(remaining));
+}
+
+/// Add LZ-style extension bytes to length
+/// Fails as soon as the total passes limit, so a run of 255s cannot overflow.
+bool readLength(const uint8_t*& in, const uint8_t* end, int limit, int& length) {
+    if (limit < 0 || length < 0) {
+        return false;
+    }
+    size_t total = static_cast<size_t>(length);
+    uint8_t byte;
+    do {
+        if (in >= end) {
+            return false;
+        }
+        byte = *in++;
+        total += byte;
+        if (total > static_cast<size_t>(limit)) {
+            return false;
+        }
+    } while (byte == 255);
+    length = static_cast<int>(total);
+    return true;
+}
+
+/// Parse and validate the span list of a Masked payload
+/// Every span returned lies inside the sprite, so callers can walk the list
+/// without further checks.
+/// @param outSpans Output spans in pixel order (replaced)
+/// @param outPacked Output: start of the packed opaque indices
+/// @return false if the spans overrun the sprite or are malformed
+bool scanMaskedSpans(const uint8_t* payload, size_t payloadSize, int pixelCount,
+                     std::vector<SpriteSpan>& outSpans, const uint8_t*& outPacked) {
+    outSpans.clear();
+    if (pixelCount < 0 || pixelCount > 0xFFFF) {
+        return false;  // SpriteSpan positions are 16-bit
+    }
+
+    const uint8_t* in = payload;
+    const uint8_t* end = payload + payloadSize;
+    int spanCount = 0;
+    if (!readLength(in, end, pixelCount, spanCount)) {
+        return false;
+    }
+    outSpans.reserve(spanCount);
+
+    int position = 0;
+    int total = 0;
+    for (int i = 0; i < spanCount; i++) {
+        int skip = 0;
+        int run = 0;
+        if (!readLength(in, end, pixelCount - position, skip) ||
+            !readLength(in, end, pixelCount - position - skip, run)) {
+            return false;
+        }
+        if (skip < 0 || run <= 0 || (i > 0 && skip == 0)) {
+            return false;
+        }
+        position += skip;
+        outSpans.push_back({static_cast<uint16_t>(position), static_cast<uint16_t>(run),
+                            static_cast<uint16_t>(total)});
+        position += run;
+        total += run;
+    }
+
+    outPacked = in;
+    return static_cast<size_t>(end - in) == NibblePacking::packedSize(total);
+}
+
+void appendSequence(std::vector<uint8_t>& out, const uint8_t* literals, int literalCount,
+                    int offset, int matchLength) {
+    int matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4) |
+                                         (matchCode < 15 ? matchCode : 15));
+    out.push_back(token);
+    if (literalCount >= 15) {
+        appendLength(out, literalCount - 15);
+    }
+    out.insert(out.end(), literals, literals + literalCount);
+
+    if (matchLength > 0) {
+        out.push_back(static_cast<uint8_t>(offset & 0xFF));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15) {
+            appendLength(out, matchCode - 15);
+        }
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// SpriteCodecContext
+// =============================================================================
+
+SpriteCodecContext::~SpriteCodecContext() {
+    if (m_deflate) {
+        deflateEnd(m_deflate);
+        delete m_deflate;
+    }
+}
+
+// =============================================================================
+// Public Interface
+// =============================================================================
+
+bool SpriteCodecs::encode(SPRTZCodec codec, const uint8_t* pixels, int pixelCount,
+                          std::vector<uint8_t>& out, SpriteCodecContext* context,
+                          uint8_t dictionaryID) {
+    SPRED_TRACE_SCOPE(trace, TraceStage::Compress);
+    out.clear();
+
+    bool ok = true;
+    switch (codec) {
+        case SPRTZCodec::Stored:
+            out.assign(pixels, pixels + pixelCount);
+            break;
+        case SPRTZCodec::RLE:
+            encodeRLE(pixels, pixelCount, out);
+            break;
+        case SPRTZCodec::Zlib:
+            ok = encodeZlib(pixels, pixelCount, out, context, dictionaryID);
+            break;
+        case SPRTZCodec::LZ:
+            encodeLZ(pixels, pixelCount, out);
+            break;
+        case SPRTZCodec::Masked:
+            encodeMasked(pixels, pixelCount, out);
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    SPRED_TRACE_BYTES(trace, pixelCount, out.size());
+    return ok;
+}
+
+bool SpriteCodecs::encodeBest(SPRTZCodec codec, const uint8_t* pixels, int pixelCount,
+                              std::vector<uint8_t>& out, SPRTZCodec& outCodec,
+                              SpriteCodecContext* context, uint8_t dictionaryID) {
+    if (codec != SPRTZCodec::AutoSmallest && codec != SPRTZCodec::AutoFastest) {
+        outCodec = codec;
+        return encode(codec, pixels, pixelCount, out, context, dictionaryID);
+    }
+
+    // Candidates in order of decode speed, so ties keep the faster one
+    const SPRTZCodec candidates[] = {SPRTZCodec::Stored, SPRTZCodec::Masked, SPRTZCodec::RLE,
+                                     SPRTZCodec::LZ, SPRTZCodec::Zlib};
+    int candidateCount = codec == SPRTZCodec::AutoFastest ? 4 : 5;
+
+    std::vector<uint8_t> localTrial;
+    std::vector<uint8_t>& trial = context ? context->m_trial : localTrial;
+    bool found = false;
+    for (int i = 0; i < candidateCount; i++) {
+        if (!encode(candidates[i], pixels, pixelCount, trial, context, dictionaryID)) {
+            continue;
+        }
+        if (!found || trial.size() < out.size()) {
+            out.swap(trial);
+            outCodec = candidates[i];
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool SpriteCodecs::decode(SPRTZCodec codec, const uint8_t* payload, size_t payloadSize,
+                          uint8_t* pixels, int pixelCount, uint8_t dictionaryID) {
+    SPRED_TRACE_SCOPE(trace, TraceStage::Decompress);
+    SPRED_TRACE_BYTES(trace, payloadSize, pixelCount);
+
+    switch (codec) {
+        case SPRTZCodec::Stored:
+            if (payloadSize != static_cast<size_t>(pixelCount)) {
+                return false;
+            }
+            std::memcpy(pixels, payload, pixelCount);
+            return true;
+        case SPRTZCodec::RLE:
+            return decodeRLE(payload, payloadSize, pixels, pixelCount);
+        case SPRTZCodec::Zlib:
+            return decodeZlib(payload, payloadSize, pixels, pixelCount, dictionaryID);
+        case SPRTZCodec::LZ:
+            return decodeLZ(payload, payloadSize, pixels, pixelCount);
+        case SPRTZCodec::Masked:
+            return decodeMasked(payload, payloadSize, pixels, pixelCount);
+        default:
+            return false;
+    }
+}
+
+const char* SpriteCodecs::getCodecName(SPRTZCodec codec) {
+    switch (codec) {
+        case SPRTZCodec::Stored: return "Stored";
+        case SPRTZCodec::RLE: return "RLE";
+        case SPRTZCodec::Zlib: return "Zlib";
+        case SPRTZCodec::LZ: return "LZ";
+        case SPRTZCodec::Masked: return "Masked";
+        case SPRTZCodec::AutoSmallest: return "AutoSmallest";
+        case SPRTZCodec::AutoFastest: return "AutoFastest";
+    }
+    return "Unknown";
+}
+
+bool SpriteCodecs::parseMaskedSpans(const uint8_t* payload, size_t payloadSize, int pixelCount,
+                                    std::vector<SpriteSpan>& outSpans, const uint8_t*& outPackedIndices) {
+    return scanMaskedSpans(payload, payloadSize, pixelCount, outSpans, outPackedIndices);
+}
+
+bool SpriteCodecs::decodeOpacityMask(SPRTZCodec codec, const uint8_t* payload, size_t payloadSize,
+                                     int width, int height, uint64_t* outRows, uint8_t dictionaryID) {
+    if (width <= 0 || width > 64 || height <= 0) {
+        return false;
+    }
+    int pixelCount = width * height;
+    std::memset(outRows, 0, height * sizeof(uint64_t));
+
+    if (codec != SPRTZCodec::Masked) {
+        std::vector<uint8_t> pixels(pixelCount);
+        if (!decode(codec, payload, payloadSize, pixels.data(), pixelCount, dictionaryID)) {
+            return false;
+        }
+        for (int i = 0; i < pixelCount; i++) {
+            if (pixels[i] != 0) {
+                outRows[i / width] |= uint64_t(1) << (i % width);
+            }
+        }
+        return true;
+    }
+
+    std::vector<SpriteSpan> spans;
+    const uint8_t* packedIndices;
+    if (!parseMaskedSpans(payload, payloadSize, pixelCount, spans, packedIndices)) {
+        return false;
+    }
+
+    // Spans run in linear order, so split them where they cross a row end
+    for (const SpriteSpan& span : spans) {
+        int position = span.start;
+        int remaining = span.length;
+        while (remaining > 0) {
+            int x = position % width;
+            int count = std::min(remaining, width - x);
+            uint64_t bits = count == 64 ? ~uint64_t(0) : ((uint64_t(1) << count) - 1);
+            outRows[position / width] |= bits << x;
+            position += count;
+            remaining -= count;
+        }
+    }
+    return true;
+}
+
+bool SpriteCodecs::blitMasked(const uint8_t* payload, size_t payloadSize, int width, int height,
+                              uint8_t* dst, int dstStride) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    thread_local std::vector<SpriteSpan> spans;  // Capacity kept across sprites
+    const uint8_t* packed;
+    if (!scanMaskedSpans(payload, payloadSize, width * height, spans, packed)) {
+        return false;
+    }
+
+    for (const SpriteSpan& span : spans) {
+        int position = span.start;
+        int run = span.length;
+        size_t indexOffset = span.indexOffset;
+        while (run > 0) {
+            int y = position / width;
+            int x = position - y * width;
+            int count = std::min(run, width - x);
+            uint8_t* row = dst + static_cast<ptrdiff_t>(y) * dstStride + x;
+            int k = 0;
+            if (indexOffset & 1) {
+                row[k++] = NibblePacking::get(packed, indexOffset);
+            }
+            NibblePacking::unpack(packed + (indexOffset + k) / 2, row + k, count - k);
+            position += count;
+            indexOffset += count;
+            run -= count;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// RLE
+// =============================================================================
+
+void SpriteCodecs::encodeRLE(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out) {
+    int i = 0;
+    while (i < pixelCount) {
+        uint8_t value = pixels[i] & 0x0F;
+        int run = 1;
+        while (i + run < pixelCount && run < 255 && (pixels[i + run] & 0x0F) == value) {
+            run++;
+        }
+
+        if (run < 15 || (run == 15 && value != 0)) {
+            out.push_back(static_cast<uint8_t>((run << 4) | value));
+        } else {
+            out.push_back(RLE_LONG_RUN);
+            out.push_back(static_cast<uint8_t>(run));
+            out.push_back(static_cast<uint8_t>(value << 4));
+        }
+        i += run;
+    }
+}
+
+bool SpriteCodecs::decodeRLE(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount) {
+    const uint8_t* in = payload;
+    const uint8_t* end = payload + payloadSize;
+    int out = 0;
+
+    while (in < end) {
+        uint8_t byte = *in++;
+        int count;
+        uint8_t value;
+        if (byte == RLE_LONG_RUN) {
+            if (end - in < 2) {
+                return false;
+            }
+            count = in[0];
+            value = in[1] >> 4;
+            in += 2;
+        } else {
+            count = byte >> 4;
+            value = byte & 0x0F;
+        }
+
+        if (count == 0 || count > pixelCount - out) {
+            return false;
+        }
+        std::memset(pixels + out, value, count);
+        out += count;
+    }
+
+    return out == pixelCount;
+}
+
+// =============================================================================
+// Masked
+// =============================================================================
+
+void SpriteCodecs::encodeMasked(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out) {
+    // Span list first; the count is patched in once the spans are known
+    std::vector<uint8_t> opaque;
+    opaque.reserve(pixelCount);
+    std::vector<uint8_t> spans;
+    int spanCount = 0;
+    int position = 0;
+    int previousEnd = 0;
+
+    while (position < pixelCount) {
+        if ((pixels[position] & 0x0F) == 0) {
+            position++;
+            continue;
+        }
+        int start = position;
+        while (position < pixelCount && (pixels[position] & 0x0F) != 0) {
+            opaque.push_back(pixels[position] & 0x0F);
+            position++;
+        }
+        appendLength(spans, start - previousEnd);
+        appendLength(spans, position - start);
+        previousEnd = position;
+        spanCount++;
+    }
+
+    appendLength(out, spanCount);
+    out.insert(out.end(), spans.begin(), spans.end());
+
+    size_t packedStart = out.size();
+    out.resize(packedStart + NibblePacking::packedSize(opaque.size()));
+    NibblePacking::pack(opaque.data(), out.data() + packedStart, opaque.size());
+}
+
+bool SpriteCodecs::decodeMasked(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount) {
+    thread_local std::vector<SpriteSpan> spans;  // Capacity kept across sprites
+    const uint8_t* packed;
+    if (!scanMaskedSpans(payload, payloadSize, pixelCount, spans, packed)) {
+        return false;
+    }
+
+    // Spans were validated above, so the walk needs no bounds checks
+    int position = 0;
+    for (const SpriteSpan& span : spans) {
+        std::memset(pixels + position, 0, span.start - position);
+
+        uint8_t* dst = pixels + span.start;
+        int count = span.length;
+        size_t indexOffset = span.indexOffset;
+        if (indexOffset & 1) {
+            *dst++ = NibblePacking::get(packed, indexOffset);
+            count--;
+        }
+        NibblePacking::unpack(packed + (indexOffset + 1) / 2, dst, count);
+        position = span.start + span.length;
+    }
+
+    std::memset(pixels + position, 0, pixelCount - position);
+    return true;
+}
+
+// =============================================================================
+// LZ
+// =============================================================================
+
+void SpriteCodecs::encodeLZ(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out) {
+    int table[1 << LZ_HASH_BITS];
+    std::memset(table, 0xFF, sizeof(table));  // -1: empty
+
+    int anchor = 0;
+    int i = 0;
+    while (i + LZ_MIN_MATCH <= pixelCount) {
+        uint32_t sequence = read32(pixels + i);
+        uint32_t h = hashLZ(sequence);
+        int candidate = table[h];
+        table[h] = i;
+
+        if (candidate < 0 || i - candidate > LZ_MAX_OFFSET || read32(pixels + candidate) != sequence) {
+            i++;
+            continue;
+        }
+
+        int length = LZ_MIN_MATCH;
+        while (i + length < pixelCount && pixels[candidate + length] == pixels[i + length]) {
+            length++;
+        }
+
+        appendSequence(out, pixels + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+
+        // Seed the table at the end of the match so runs chain cheaply
+        if (i - 2 >= 0 && i - 2 + LZ_MIN_MATCH <= pixelCount) {
+            table[hashLZ(read32(pixels + i - 2))] = i - 2;
+        }
+    }
+
+    if (anchor < pixelCount) {
+        appendSequence(out, pixels + anchor, pixelCount - anchor, 0, 0);
+    }
+}
+
+bool SpriteCodecs::decodeLZ(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount) {
+    const uint8_t* in = payload;
+    const uint8_t* end = payload + payloadSize;
+    int out = 0;
+
+    while (out < pixelCount) {
+        if (in >= end) {
+            return false;
+        }
+        uint8_t token = *in++;
+
+        int literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(in, end, pixelCount - out, literalCount)) {
+            return false;
+        }
+        if (literalCount < 0 || literalCount > end - in || literalCount > pixelCount - out) {
+            return false;
+        }
+        std::memcpy(pixels + out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+
+        if (out == pixelCount) {
+            break;  // Final sequence carries literals only
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        int offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        int matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(in, end, pixelCount - out - LZ_MIN_MATCH, matchLength)) {
+            return false;
+        }
+        matchLength += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > out || matchLength < 0 || matchLength > pixelCount - out) {
+            return false;
+        }
+
+        const uint8_t* match = pixels + out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(pixels + out, match, matchLength);
+        } else {
+            for (int k = 0; k < matchLength; k++) {
+                pixels[out + k] = match[k];  // Overlapping copy replicates the pattern
+            }
+        }
+        out += matchLength;
+    }
+
+    return in == end;
+}
+
+// =============================================================================
+// Zlib
+// =============================================================================
+
+bool SpriteCodecs::encodeZlib(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out,
+                              SpriteCodecContext* context, uint8_t dictionaryID) {
+    const uint8_t* dictionary = nullptr;
+    size_t dictionarySize = 0;
+    if (dictionaryID != 0 && !SpriteDictionary::getDictionary(dictionaryID, dictionary, dictionarySize)) {
+        out.clear();
+        return false;
+    }
+
+    if (!context && !dictionary) {
+        // Estimate compressed size (zlib's compressBound gives upper limit)
+        uLongf compressedSize = compressBound(pixelCount);
+        out.resize(compressedSize);
+
+        int result = compress2(out.data(), &compressedSize,
+                               pixels, pixelCount,
+                               Z_BEST_COMPRESSION);
+        if (result != Z_OK) {
+            out.clear();
+            return false;
+        }
+
+        out.resize(compressedSize);
+        return true;
+    }
+
+    // Same stream parameters as compress2, so undictionaried output is byte-identical
+    z_stream local = {};
+    z_stream* stream = &local;
+    if (context && context->m_deflate) {
+        stream = context->m_deflate;
+        if (deflateReset(stream) != Z_OK) {
+            out.clear();
+            return false;
+        }
+    } else {
+        if (context) {
+            stream = new z_stream();
+        }
+        if (deflateInit(stream, Z_BEST_COMPRESSION) != Z_OK) {
+            if (context) {
+                delete stream;
+            }
+            out.clear();
+            return false;
+        }
+        if (context) {
+            context->m_deflate = stream;
+        }
+    }
+
+    bool ok = !dictionary ||
+              deflateSetDictionary(stream, dictionary, static_cast<uInt>(dictionarySize)) == Z_OK;
+    if (ok) {
+        out.resize(deflateBound(stream, pixelCount));
+
+        stream->next_in = const_cast<Bytef*>(pixels);
+        stream->avail_in = static_cast<uInt>(pixelCount);
+        stream->next_out = out.data();
+        stream->avail_out = static_cast<uInt>(out.size());
+
+        ok = deflate(stream, Z_FINISH) == Z_STREAM_END;
+    }
+
+    if (ok) {
+        out.resize(stream->total_out);
+    } else {
+        out.clear();
+    }
+    if (!context) {
+        deflateEnd(stream);
+    }
+    return ok;
+}
+
+bool SpriteCodecs::decodeZlib(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount,
+                              uint8_t dictionaryID) {
+    if (dictionaryID == 0) {
+        uLongf uncompressedSize = pixelCount;
+        int result = uncompress(pixels, &uncompressedSize, payload, payloadSize);
+        return result == Z_OK && uncompressedSize == static_cast<uLongf>(pixelCount);
+    }
+
+    const uint8_t* dictionary;
+    size_t dictionarySize;
+    if (!SpriteDictionary::getDictionary(dictionaryID, dictionary, dictionarySize)) {
+        return false;
+    }
+
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<Bytef*>(payload);
+    stream.avail_in = static_cast<uInt>(payloadSize);
+    stream.next_out = pixels;
+    stream.avail_out = static_cast<uInt>(pixelCount);
+
+    // The stream asks for its dictionary by Adler-32, so a wrong dictionary is rejected here
+    int result = inflate(&stream, Z_FINISH);
+    if (result == Z_NEED_DICT &&
+        inflateSetDictionary(&stream, dictionary, static_cast<uInt>(dictionarySize)) == Z_OK) {
+        result = inflate(&stream, Z_FINISH);
+    }
+
+    bool ok = result == Z_STREAM_END && stream.total_out == static_cast<uLong>(pixelCount);
+    inflateEnd(&stream);
+    return ok;
+}
+
+} // namespace SPRED
@@ -0,0 +1,163 @@
+//
+//  SpriteCodecs.h
+//  SPRED - Sprite Editor
+//
+//  Pixel payload codecs for SPRTZ v3
+//
+
+#ifndef SPRED_SPRITE_CODECS_H
+#define SPRED_SPRITE_CODECS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct z_stream_s;
+
+namespace SPRED {
+
+/// SPRTZ v3 pixel codec (stored in the codec byte of the header)
+enum class SPRTZCodec : uint8_t {
+    Stored = 0,         // Raw indices, one byte per pixel
+    RLE = 1,            // 4-bit run-length encoding (see below)
+    Zlib = 2,           // zlib stream (the only codec used by v1/v2)
+    LZ = 3,             // Byte-oriented LZ77, tuned for decode speed
+    Masked = 4,         // Opaque spans + packed opaque indices (sparse sprites)
+
+    // Encoder-only selection modes (never written to a file)
+    AutoSmallest = 0xFE,  // Try every codec, keep the smallest (ties go to the faster decoder)
+    AutoFastest = 0xFF    // Smallest of Stored/RLE/Masked/LZ; never pays for an inflate at runtime
+};
+
+/// Run of opaque pixels in a Masked payload
+struct SpriteSpan {
+    uint16_t start;         // Linear pixel position (y * width + x)
+    uint16_t length;        // Opaque pixels in the run (may cross row ends)
+    uint16_t indexOffset;   // Position of the run's first index in the packed index stream
+};
+
+/// Reusable encoder state for encoding many sprites in a row
+///
+/// Holds a deflate stream that is reset (not reallocated) between sprites and
+/// scratch buffers whose capacity is kept. Not thread-safe: use one per thread.
+class SpriteCodecContext {
+public:
+    SpriteCodecContext() = default;
+    ~SpriteCodecContext();
+
+    SpriteCodecContext(const SpriteCodecContext&) = delete;
+    SpriteCodecContext& operator=(const SpriteCodecContext&) = delete;
+
+private:
+    friend class SpriteCodecs;
+    friend class SpriteCompression;
+
+    z_stream_s* m_deflate = nullptr;    // Created on first zlib encode
+    std::vector<uint8_t> m_trial;       // Candidate payload for Auto modes
+    std::vector<uint8_t> m_payload;     // Payload staging for file images
+};
+
+/// Codec Formats
+/// =============
+///
+/// Stored: width × height index bytes.
+///
+/// RLE (4-bit indices):
+///   Short run (1-15):  [count:4][value:4]               (1 byte)
+///   Long run (15-255): [0xF0][count:8][value:4][pad:4]  (3 bytes)
+///   0xF0 is reserved as the long-run marker, so a run of 15 zeros always
+///   uses the long form. A high nibble of 0 is invalid.
+///
+///   Raw: 0 0 0 0 0 1 1 2 2 2  ->  0x50 0x21 0x32
+///   Raw: 20 zeros             ->  0xF0 0x14 0x00
+///
+/// LZ: sequences of [token][literal length ext][literals][offset:16 LE][match length ext]
+///   token high nibble = literal count, low nibble = match length - 4;
+///   a nibble of 15 is extended by bytes that are added until one is < 255.
+///   The final sequence has literals only. Offsets are 1-65535.
+///
+/// Masked (index 0 = transparent, 1-15 = opaque):
+///   [span count][skip][run] ... [skip][run][packed opaque indices]
+///   Counts are LZ-style lengths (bytes added until one is < 255). Each span
+///   skips transparent pixels from the end of the previous span and then
+///   covers run opaque pixels, in linear pixel order; pixels after the last
+///   span are transparent. The opaque indices follow in NibblePacking layout.
+///   Blitters can walk the spans and never touch transparent pixels.
+class SpriteCodecs {
+public:
+    /// Encode pixel indices with one codec (Auto modes are not accepted here)
+    /// @param codec Codec to use
+    /// @param pixels Pixel indices
+    /// @param pixelCount Number of pixels
+    /// @param out Output payload (replaced)
+    /// @param context Optional reusable encoder state (nullptr for one-off encodes)
+    /// @param dictionaryID Preset dictionary for Zlib (0 = none, see SpriteDictionary.h)
+    /// @return true if successful
+    static bool encode(SPRTZCodec codec, const uint8_t* pixels, int pixelCount,
+                       std::vector<uint8_t>& out, SpriteCodecContext* context = nullptr,
+                       uint8_t dictionaryID = 0);
+
+    /// Encode with the best codec for a selection mode (or a fixed codec)
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param outCodec Codec actually used
+    /// @param context Optional reusable encoder state (nullptr for one-off encodes)
+    /// @param dictionaryID Preset dictionary for Zlib (0 = none)
+    /// @return true if successful
+    static bool encodeBest(SPRTZCodec codec, const uint8_t* pixels, int pixelCount,
+                           std::vector<uint8_t>& out, SPRTZCodec& outCodec,
+                           SpriteCodecContext* context = nullptr, uint8_t dictionaryID = 0);
+
+    /// Decode a payload, producing exactly pixelCount indices
+    /// @param dictionaryID Preset dictionary the Zlib payload was compressed with (0 = none)
+    /// @return false on unknown codec, missing dictionary or malformed/truncated payload
+    static bool decode(SPRTZCodec codec, const uint8_t* payload, size_t payloadSize,
+                       uint8_t* pixels, int pixelCount, uint8_t dictionaryID = 0);
+
+    /// Codec name for reports
+    static const char* getCodecName(SPRTZCodec codec);
+
+    /// True for codecs that may appear in a file
+    static bool isValidCodec(uint8_t codec) { return codec <= static_cast<uint8_t>(SPRTZCodec::Masked); }
+
+    /// Parse the span list of a Masked payload without decoding indices
+    /// @param outSpans Output spans in pixel order (replaced)
+    /// @param outPackedIndices Output: start of the packed opaque indices (NibblePacking layout)
+    /// @return false if the payload is malformed or pixelCount exceeds 65535
+    static bool parseMaskedSpans(const uint8_t* payload, size_t payloadSize, int pixelCount,
+                                 std::vector<SpriteSpan>& outSpans, const uint8_t*& outPackedIndices);
+
+    /// Draw a Masked payload onto an index surface, writing opaque pixels only
+    /// Transparent runs are skipped without being read or written.
+    /// @param dst Top-left destination pixel (the whole sprite must fit)
+    /// @param dstStride Bytes between destination rows
+    /// @return false if the payload is malformed (nothing is drawn)
+    static bool blitMasked(const uint8_t* payload, size_t payloadSize, int width, int height,
+                           uint8_t* dst, int dstStride);
+
+    /// Build a per-row opacity bitmask (bit x of row y set = opaque)
+    /// Masked payloads are read from the span list alone; other codecs are decoded.
+    /// @param width Sprite width (at most 64)
+    /// @param outRows Output masks (height entries)
+    /// @return false if the payload is malformed
+    static bool decodeOpacityMask(SPRTZCodec codec, const uint8_t* payload, size_t payloadSize,
+                                  int width, int height, uint64_t* outRows, uint8_t dictionaryID = 0);
+
+private:
+    static void encodeRLE(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out);
+    static bool decodeRLE(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount);
+
+    static void encodeMasked(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out);
+    static bool decodeMasked(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount);
+
+    static void encodeLZ(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out);
+    static bool decodeLZ(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount);
+
+    static bool encodeZlib(const uint8_t* pixels, int pixelCount, std::vector<uint8_t>& out,
+                           SpriteCodecContext* context, uint8_t dictionaryID);
+    static bool decodeZlib(const uint8_t* payload, size_t payloadSize, uint8_t* pixels, int pixelCount,
+                           uint8_t dictionaryID);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_CODECS_H
@@ -0,0 +1,201 @@
+//
+//  SpriteCompositor.cpp
+//  SPRED - Sprite Editor
+//
+//  Reference sprite compositor implementation
+//
+
+#include "SpriteCompositor.h"
+#include "SpriteData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint16_t INVALID_ID = 0xFFFF;
+
+/// Run fn(worker) on workerCount threads (inline when there is only one)
+template <typename Fn>
+void runWorkers(int workerCount, Fn fn) {
+    if (workerCount == 1) {
+        fn(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount);
+    for (int t = 0; t < workerCount; t++) {
+        threads.emplace_back(fn, t);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+} // anonymous namespace
+
+SpriteCompositor::SpriteCompositor(SurfaceFormat format, int threadCount)
+    : m_format(format)
+    , m_threadCount(threadCount)
+    , m_palettes(format)
+{
+}
+
+uint16_t SpriteCompositor::addSprite(int width, int height, const uint8_t* pixels) {
+    if (!pixels || width <= 0 || height <= 0 || width > MAX_SPRITE_SIZE || height > MAX_SPRITE_SIZE ||
+        m_sprites.size() >= INVALID_ID) {
+        return INVALID_ID;
+    }
+    m_sprites.push_back({width, height, m_pixels.size()});
+    m_pixels.insert(m_pixels.end(), pixels, pixels + width * height);
+    return static_cast<uint16_t>(m_sprites.size() - 1);
+}
+
+uint16_t SpriteCompositor::addSprite(const SpriteData& sprite) {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return addSprite(sprite.getWidth(), sprite.getHeight(), sprite.getUnpackedPixels(scratch));
+}
+
+void SpriteCompositor::clear() {
+    m_sprites.clear();
+    m_pixels.clear();
+    m_palettes.clear();
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+bool SpriteCompositor::render(const SpriteInstance* instances, size_t count, const SpriteSurface& target) {
+    m_stats = CompositorStats();
+    m_stats.instanceCount = count;
+    if (!target.pixels || target.width <= 0 || target.height <= 0 ||
+        target.stride < size_t(target.width) * 4 || target.format != m_format || (count > 0 && !instances)) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    const int tilesX = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCount = tilesX * tilesY;
+
+    int threadCount = m_threadCount > 0 ? m_threadCount
+                                        : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max(1, threadCount);
+
+    // Small frames are binned on one thread; the chunk count only affects binning
+    const size_t minChunk = 4096;
+    const int chunkCount = static_cast<int>(std::max<size_t>(1, std::min<size_t>(threadCount, count / minChunk)));
+    if (m_bins.size() < size_t(chunkCount)) {
+        m_bins.resize(chunkCount);
+    }
+    for (int chunk = 0; chunk < chunkCount; chunk++) {
+        std::vector<std::vector<uint32_t>>& bins = m_bins[chunk];
+        if (bins.size() < size_t(tileCount)) {
+            bins.resize(tileCount);
+        }
+        for (int tile = 0; tile < tileCount; tile++) {
+            bins[tile].clear();
+        }
+    }
+
+    std::vector<size_t> visible(chunkCount, 0);
+    std::vector<size_t> refs(chunkCount, 0);
+    runWorkers(chunkCount, [&](int chunk) {
+        std::vector<std::vector<uint32_t>>& bins = m_bins[chunk];
+        size_t begin = count * chunk / chunkCount;
+        size_t end = count * (chunk + 1) / chunkCount;
+        for (size_t i = begin; i < end; i++) {
+            const SpriteInstance& instance = instances[i];
+            if (instance.sprite >= m_sprites.size() || instance.palette >= getPaletteCount()) {
+                continue;
+            }
+            const Sprite& sprite = m_sprites[instance.sprite];
+            int x0 = std::max(instance.x, 0);
+            int y0 = std::max(instance.y, 0);
+            int x1 = static_cast<int>(std::min<int64_t>(int64_t(instance.x) + sprite.width, target.width));
+            int y1 = static_cast<int>(std::min<int64_t>(int64_t(instance.y) + sprite.height, target.height));
+            if (x0 >= x1 || y0 >= y1) {
+                continue;
+            }
+            visible[chunk]++;
+            for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++) {
+                for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++) {
+                    bins[ty * tilesX + tx].push_back(static_cast<uint32_t>(i));
+                    refs[chunk]++;
+                }
+            }
+        }
+    });
+    m_stats.binSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int chunk = 0; chunk < chunkCount; chunk++) {
+        m_stats.visibleCount += visible[chunk];
+        m_stats.tileRefs += refs[chunk];
+    }
+
+    // Tiles are handed out one at a time so dense tiles do not stall a thread
+    std::atomic<int> next(0);
+    runWorkers(std::min(threadCount, tileCount), [&](int) {
+        for (int tile = next++; tile < tileCount; tile = next++) {
+            renderTile(instances, chunkCount, tile % tilesX, tile / tilesX, target);
+        }
+    });
+
+    m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void SpriteCompositor::renderTile(const SpriteInstance* instances, int chunkCount, int tileX, int tileY,
+                                  const SpriteSurface& target) const {
+    const int tileIndex = tileY * ((target.width + TILE_SIZE - 1) / TILE_SIZE) + tileX;
+    const int left = tileX * TILE_SIZE;
+    const int top = tileY * TILE_SIZE;
+    const int right = std::min(left + TILE_SIZE, target.width);
+    const int bottom = std::min(top + TILE_SIZE, target.height);
+
+    for (int chunk = 0; chunk < chunkCount; chunk++) {
+        for (uint32_t index : m_bins[chunk][tileIndex]) {
+            const SpriteInstance& instance = instances[index];
+            const Sprite& sprite = m_sprites[instance.sprite];
+            const uint8_t* pixels = &m_pixels[sprite.offset];
+            const uint32_t* table = m_palettes.getTable(instance.palette);
+
+            // Clip to the tile; u/v are positions inside the drawn (flipped) sprite
+            int x0 = std::max(instance.x, left);
+            int y0 = std::max(instance.y, top);
+            int x1 = std::min(instance.x + sprite.width, right);
+            int y1 = std::min(instance.y + sprite.height, bottom);
+            const bool flipX = (instance.flip & SPRITE_FLIP_X) != 0;
+            const bool flipY = (instance.flip & SPRITE_FLIP_Y) != 0;
+
+            for (int y = y0; y < y1; y++) {
+                int v = y - instance.y;
+                const uint8_t* src = pixels + size_t(flipY ? sprite.height - 1 - v : v) * sprite.width;
+                uint8_t* dst = target.pixels + size_t(y) * target.stride + size_t(x0) * 4;
+                int u0 = x0 - instance.x;
+                int u1 = x1 - instance.x;
+                if (flipX) {
+                    for (int u = u0; u < u1; u++, dst += 4) {
+                        uint8_t index = src[sprite.width - 1 - u];
+                        if (uint8_t(index - 1) < 15) {
+                            std::memcpy(dst, &table[index], 4);
+                        }
+                    }
+                } else {
+                    for (int u = u0; u < u1; u++, dst += 4) {
+                        uint8_t index = src[u];
+                        if (uint8_t(index - 1) < 15) {
+                            std::memcpy(dst, &table[index], 4);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace SPRED
@@ -0,0 +1,135 @@
+//
+//  SpriteCompositor.h
+//  SPRED - Sprite Editor
+//
+//  Portable reference compositor for the runtime sprite layer
+//
+
+#ifndef SPRED_SPRITE_COMPOSITOR_H
+#define SPRED_SPRITE_COMPOSITOR_H
+
+#include "PaletteTable.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// Flip flags for SpriteInstance::flip
+enum SpriteFlip : uint8_t {
+    SPRITE_FLIP_NONE = 0,
+    SPRITE_FLIP_X = 1 << 0,     // Mirror left-right
+    SPRITE_FLIP_Y = 1 << 1      // Mirror top-bottom
+};
+
+/// One sprite drawn on one frame
+struct SpriteInstance {
+    int32_t x;                  // Top-left position in the framebuffer (may be off screen)
+    int32_t y;
+    uint16_t sprite;            // ID from SpriteCompositor::addSprite
+    uint16_t palette;           // ID in the compositor's PaletteTable
+    uint8_t flip;               // SpriteFlip flags
+};
+
+/// Results of the last render
+struct CompositorStats {
+    size_t instanceCount = 0;   // Instances submitted
+    size_t visibleCount = 0;    // Instances overlapping the framebuffer
+    size_t tileRefs = 0;        // Instance-tile pairs after binning
+    double binSeconds = 0.0;
+    double seconds = 0.0;       // Whole render, binning included
+};
+
+/// SpriteCompositor - Multithreaded tile-binned sprite renderer
+///
+/// Mirrors what the SuperTerminalMetal sprite layer draws, without Cocoa or
+/// Metal, so sprite throughput can be measured and regression-tested on any
+/// host. Instances are drawn in submission order with index 0 transparent.
+///
+/// Sprite indices are stored once and each instance picks its palette by ID
+/// at blit time, so color variants (teams, damage flashes, standard palette
+/// swaps) cost 64 bytes each and nothing per frame.
+///
+/// A frame is rendered in two passes. Binning splits the instance list into
+/// one contiguous chunk per thread, and each thread appends its instances to
+/// per-tile lists. Tiles are then rendered in parallel; each tile walks the
+/// chunk lists in order, so draw order is kept without any merge step and no
+/// two threads ever write the same pixel.
+///
+/// Usage:
+///   SpriteCompositor compositor(SurfaceFormat::BGRA);
+///   uint16_t ship = compositor.addSprite(shipSprite);
+///   uint16_t red = compositor.addPalette(shipSprite.getPaletteData());
+///   SpriteInstance instance = {100, 50, ship, red, SPRITE_FLIP_X};
+///   compositor.render(&instance, 1, framebuffer);
+class SpriteCompositor {
+public:
+    /// Framebuffer tile edge in pixels
+    static constexpr int TILE_SIZE = 64;
+
+    /// @param format Byte order of the framebuffers passed to render
+    /// @param threadCount Worker threads (0 = hardware concurrency, 1 = render on the calling thread)
+    explicit SpriteCompositor(SurfaceFormat format = SurfaceFormat::BGRA, int threadCount = 0);
+
+    /// Register sprite pixels (copied)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @return Sprite ID, or 0xFFFF if the size is invalid or the table is full
+    uint16_t addSprite(int width, int height, const uint8_t* pixels);
+
+    /// Register the pixels of a SpriteData (copied; its palette is not)
+    uint16_t addSprite(const SpriteData& sprite);
+
+    /// Register a palette (same as getPalettes().add)
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @return Palette ID, or 0xFFFF if the table is full
+    uint16_t addPalette(const uint8_t* palette) { return m_palettes.add(palette); }
+
+    /// Palettes instances refer to (add standard palettes or edit entries here)
+    PaletteTable& getPalettes() { return m_palettes; }
+    const PaletteTable& getPalettes() const { return m_palettes; }
+
+    size_t getSpriteCount() const { return m_sprites.size(); }
+    size_t getPaletteCount() const { return m_palettes.getCount(); }
+
+    /// Bytes held for sprite indices and palettes
+    size_t getMemoryUsage() const { return m_pixels.size() + m_palettes.getMemoryUsage(); }
+
+    /// Composite instances over a framebuffer, clipped to its bounds
+    /// Instances with unknown sprite or palette IDs are skipped.
+    /// @param target Framebuffer (format must match the compositor's)
+    /// @return false if the framebuffer is invalid or in another format
+    bool render(const SpriteInstance* instances, size_t count, const SpriteSurface& target);
+
+    /// Statistics for the last render
+    const CompositorStats& getStats() const { return m_stats; }
+
+    SurfaceFormat getFormat() const { return m_format; }
+    void setThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+    /// Remove every sprite and palette
+    void clear();
+
+private:
+    struct Sprite {
+        int width;
+        int height;
+        size_t offset;          // Into m_pixels
+    };
+
+    SurfaceFormat m_format;
+    int m_threadCount;
+    std::vector<Sprite> m_sprites;
+    std::vector<uint8_t> m_pixels;          // Every sprite's indices, back to back
+    PaletteTable m_palettes;
+    std::vector<std::vector<std::vector<uint32_t>>> m_bins;    // [chunk][tile] -> instance indices
+    CompositorStats m_stats;
+
+    void renderTile(const SpriteInstance* instances, int chunkCount, int tileX, int tileY,
+                    const SpriteSurface& target) const;
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_COMPOSITOR_H
@@ -7,100 +7,189 @@
 
 #include "SpriteCompression.h"
 #include "PaletteLibrary.h"
+#include "SpriteHash.h"
+#include "SpriteTrace.h"
 #include <fstream>
 #include <cstring>
-#include <cstdio>
 #include <zlib.h>
 
 using namespace SuperTerminal;
 
 namespace SPRED {
 
-bool SpriteCompression::saveSPRTZ(const std::string& filename,
-                                   int width, int height,
-                                   const uint8_t* pixels,
-                                   const uint8_t* palette) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        return false;
-    }
+// =============================================================================
+// Internal Helpers
+// =============================================================================
 
-    // Compress pixel data
-    int pixelCount = width * height;
-    std::vector<uint8_t> compressed;
-    compressRLE(pixels, pixelCount, compressed);
+namespace {
 
-    // Write header
-    const char magic[4] = {'S', 'P', 'T', 'Z'};
-    file.write(magic, 4);
+constexpr size_t SPRTZ_HEADER_SIZE = 16;
+constexpr size_t SPRTZ_PALETTE_SIZE = 42;
+constexpr size_t SPRTZ_V3_EXTENSION_SIZE = 4;
+constexpr size_t SPRTZ_CONTENT_HASH_SIZE = 8;
+constexpr uint8_t SPRTZ_FLAG_CONTENT_HASH = 0x01;
+constexpr int SPRTZ_MAX_SIZE = 40;      // Same limit as SpriteData (MAX_SPRITE_SIZE)
+constexpr int SPRTZ_MAX_PIXELS = SPRTZ_MAX_SIZE * SPRTZ_MAX_SIZE;
 
-    uint16_t version = 1;
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+/// Sprites are 1 to 40 pixels on each side
+inline bool isValidSpriteSize(int width, int height) {
+    return width >= 1 && height >= 1 && width <= SPRTZ_MAX_SIZE && height <= SPRTZ_MAX_SIZE;
+}
 
-    uint8_t w = static_cast<uint8_t>(width);
-    uint8_t h = static_cast<uint8_t>(height);
-    file.write(reinterpret_cast<const char*>(&w), 1);
-    file.write(reinterpret_cast<const char*>(&h), 1);
+/// Parsed and bounds-checked SPRTZ header
+struct SPRTZHeader {
+    uint16_t version;
+    int width;
+    int height;
+    uint8_t paletteMode;        // 0-31 standard, 0xFF custom (always 0xFF for v1)
+    SPRTZCodec codec;           // Always Zlib for v1/v2
+    uint8_t dictionaryID;       // Preset zlib dictionary, 0 = none (v3 only)
+    bool hasContentHash;        // v3 only
+    uint64_t contentHash;
+    const uint8_t* palette;     // Embedded RGB palette, or nullptr
+    const uint8_t* payload;     // Compressed pixel data
+    uint32_t payloadSize;
+};
+
+/// Validate a SPRTZ file image and locate its palette and payload
+/// Nothing is written to caller buffers until the whole header has been checked.
+bool parseSPRTZHeader(const uint8_t* data, size_t size, SPRTZHeader& header) {
+    if (!data || size < SPRTZ_HEADER_SIZE) {
+        return false;
+    }
 
-    uint32_t uncompressedSize = static_cast<uint32_t>(pixelCount);
-    uint32_t compressedSize = static_cast<uint32_t>(compressed.size());
-    file.write(reinterpret_cast<const char*>(&uncompressedSize), sizeof(uncompressedSize));
-    file.write(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+    if (data[0] != 'S' || data[1] != 'P' || data[2] != 'T' || data[3] != 'Z') {
+        return false;
+    }
 
-    // Write palette (indices 2-15 only, RGB only)
-    // Skip indices 0 and 1 (transparent and opaque black)
-    for (int i = 2; i < 16; i++) {
-        int offset = i * 4;
-        uint8_t rgb[3] = {palette[offset], palette[offset + 1], palette[offset + 2]};
-        file.write(reinterpret_cast<const char*>(rgb), 3);
+    std::memcpy(&header.version, data + 4, sizeof(header.version));
+    if (header.version < 1 || header.version > 3) {
+        return false;
     }
 
-    // Write compressed pixel data
-    file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    header.width = data[6];
+    header.height = data[7];
 
-    return file.good();
-}
+    uint32_t uncompressedSize;
+    std::memcpy(&uncompressedSize, data + 8, sizeof(uncompressedSize));
+    std::memcpy(&header.payloadSize, data + 12, sizeof(header.payloadSize));
 
-bool SpriteCompression::loadSPRTZ(const std::string& filename,
-                                   int& outWidth, int& outHeight,
-                                   uint8_t* outPixels,
-                                   uint8_t* outPalette) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
+    // Verify sizes
+    int expectedPixels = header.width * header.height;
+    if (!isValidSpriteSize(header.width, header.height) ||
+        uncompressedSize != static_cast<uint32_t>(expectedPixels)) {
         return false;
     }
 
-    // Read and verify header
-    char magic[4];
-    file.read(magic, 4);
-    if (magic[0] != 'S' || magic[1] != 'P' || magic[2] != 'T' || magic[3] != 'Z') {
+    size_t pos = SPRTZ_HEADER_SIZE;
+
+    // v1 files always carry a custom palette; v2 files start with a palette mode byte;
+    // v3 files add codec, flags and dictionary ID bytes after it
+    header.paletteMode = 0xFF;
+    header.codec = SPRTZCodec::Zlib;
+    header.dictionaryID = 0;
+    header.hasContentHash = false;
+    header.contentHash = 0;
+    if (header.version == 2) {
+        if (pos + 1 > size) {
+            return false;
+        }
+        header.paletteMode = data[pos++];
+    } else if (header.version == 3) {
+        if (pos + SPRTZ_V3_EXTENSION_SIZE > size) {
+            return false;
+        }
+        header.paletteMode = data[pos + 0];
+        uint8_t codec = data[pos + 1];
+        uint8_t flags = data[pos + 2];
+        uint8_t dictionaryID = data[pos + 3];
+        if (!SpriteCodecs::isValidCodec(codec) || (flags & ~SPRTZ_FLAG_CONTENT_HASH) != 0) {
+            return false;
+        }
+        if (dictionaryID != 0 && codec != static_cast<uint8_t>(SPRTZCodec::Zlib)) {
+            return false;   // Only zlib payloads use a preset dictionary
+        }
+        header.codec = static_cast<SPRTZCodec>(codec);
+        header.dictionaryID = dictionaryID;
+        pos += SPRTZ_V3_EXTENSION_SIZE;
+
+        if (flags & SPRTZ_FLAG_CONTENT_HASH) {
+            if (pos + SPRTZ_CONTENT_HASH_SIZE > size) {
+                return false;
+            }
+            std::memcpy(&header.contentHash, data + pos, sizeof(header.contentHash));
+            header.hasContentHash = true;
+            pos += SPRTZ_CONTENT_HASH_SIZE;
+        }
+    }
+
+    header.palette = nullptr;
+    if (header.paletteMode == 0xFF) {
+        if (pos + SPRTZ_PALETTE_SIZE > size) {
+            return false;
+        }
+        header.palette = data + pos;
+        pos += SPRTZ_PALETTE_SIZE;
+    } else if (header.paletteMode >= 32) {
+        // Invalid palette mode
         return false;
     }
 
-    uint16_t version;
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if (version != 1) {
+    if (header.payloadSize > size - pos) {
         return false;
     }
+    header.payload = data + pos;
+    return true;
+}
 
-    uint8_t w, h;
-    file.read(reinterpret_cast<char*>(&w), 1);
-    file.read(reinterpret_cast<char*>(&h), 1);
-    outWidth = w;
-    outHeight = h;
+/// Content hash over the decoded pixels and the palette reference as stored in the file
+/// @param rgbPalette Embedded 42-byte RGB palette, or nullptr for a standard palette
+uint64_t hashContent(int width, int height, const uint8_t* pixels,
+                     uint8_t paletteMode, const uint8_t* rgbPalette) {
+    uint8_t seed[3 + SPRTZ_PALETTE_SIZE];
+    seed[0] = static_cast<uint8_t>(width);
+    seed[1] = static_cast<uint8_t>(height);
+    seed[2] = paletteMode;
+    size_t seedSize = 3;
+    if (rgbPalette) {
+        std::memcpy(seed + 3, rgbPalette, SPRTZ_PALETTE_SIZE);
+        seedSize += SPRTZ_PALETTE_SIZE;
+    }
+    return SpriteHash::hash64(pixels, width * height, SpriteHash::hash64(seed, seedSize));
+}
 
-    uint32_t uncompressedSize, compressedSize;
-    file.read(reinterpret_cast<char*>(&uncompressedSize), sizeof(uncompressedSize));
-    file.read(reinterpret_cast<char*>(&compressedSize), sizeof(compressedSize));
+/// True unless the header carries a content hash that the decoded pixels do not match
+bool matchesContentHash(const SPRTZHeader& header, const uint8_t* pixels) {
+    return !header.hasContentHash ||
+           hashContent(header.width, header.height, pixels, header.paletteMode, header.palette) ==
+               header.contentHash;
+}
 
-    // Verify sizes
-    int expectedPixels = outWidth * outHeight;
-    if (uncompressedSize != static_cast<uint32_t>(expectedPixels)) {
-        return false;
+void copyInfo(const SPRTZHeader& header, SPRTZInfo& outInfo) {
+    outInfo.version = header.version;
+    outInfo.width = header.width;
+    outInfo.height = header.height;
+    outInfo.paletteMode = header.paletteMode;
+    outInfo.codec = header.codec;
+    outInfo.dictionaryID = header.dictionaryID;
+    outInfo.hasContentHash = header.hasContentHash;
+    outInfo.contentHash = header.contentHash;
+    outInfo.palette = header.palette;
+    outInfo.payloadSize = header.payloadSize;
+}
+
+/// Standard palettes can only be resolved once the palette library is loaded
+bool canResolvePalette(const SPRTZHeader& header) {
+    return header.palette || StandardPaletteLibrary::getPalette(header.paletteMode) != nullptr;
+}
+
+/// Build the 64-byte RGBA palette described by a header
+bool resolvePalette(const SPRTZHeader& header, uint8_t* outPalette) {
+    if (!header.palette) {
+        return StandardPaletteLibrary::copyPaletteRGBA(header.paletteMode, outPalette);
     }
 
-    // Read palette (indices 2-15, RGB only)
-    // Set up fixed colors 0 and 1
+    // Fixed colors 0 and 1
     outPalette[0] = 0;   // R
     outPalette[1] = 0;   // G
     outPalette[2] = 0;   // B
@@ -111,80 +200,137 @@ bool SpriteCompression::loadSPRTZ(const std::string& filename,
     outPalette[6] = 0;   // B
     outPalette[7] = 255; // A (opaque)
 
-    // Read colors 2-15
+    // Colors 2-15
+    const uint8_t* rgb = header.palette;
     for (int i = 2; i < 16; i++) {
-        uint8_t rgb[3];
-        file.read(reinterpret_cast<char*>(rgb), 3);
         int offset = i * 4;
         outPalette[offset + 0] = rgb[0];
         outPalette[offset + 1] = rgb[1];
         outPalette[offset + 2] = rgb[2];
         outPalette[offset + 3] = 255; // Always opaque for colors 2-15
+        rgb += 3;
+    }
+    return true;
+}
+
+void appendBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void appendHeader(std::vector<uint8_t>& out, uint16_t version,
+                  int width, int height, uint32_t compressedSize) {
+    const char magic[4] = {'S', 'P', 'T', 'Z'};
+    appendBytes(out, magic, 4);
+    appendBytes(out, &version, sizeof(version));
+
+    out.push_back(static_cast<uint8_t>(width));
+    out.push_back(static_cast<uint8_t>(height));
+
+    uint32_t uncompressedSize = static_cast<uint32_t>(width * height);
+    appendBytes(out, &uncompressedSize, sizeof(uncompressedSize));
+    appendBytes(out, &compressedSize, sizeof(compressedSize));
+}
+
+void appendCustomPalette(std::vector<uint8_t>& out, const uint8_t* palette) {
+    // Indices 2-15 only, RGB only
+    // Skip indices 0 and 1 (transparent and opaque black)
+    for (int i = 2; i < 16; i++) {
+        int offset = i * 4;
+        out.push_back(palette[offset + 0]);
+        out.push_back(palette[offset + 1]);
+        out.push_back(palette[offset + 2]);
     }
+}
 
-    // Read compressed pixel data
-    std::vector<uint8_t> compressed(compressedSize);
-    file.read(reinterpret_cast<char*>(compressed.data()), compressedSize);
+void appendV3Extension(std::vector<uint8_t>& out, uint8_t paletteMode, SPRTZCodec codec,
+                       uint8_t dictionaryID, uint64_t contentHash) {
+    out.push_back(paletteMode);
+    out.push_back(static_cast<uint8_t>(codec));
+    out.push_back(SPRTZ_FLAG_CONTENT_HASH);
+    out.push_back(dictionaryID);
+    appendBytes(out, &contentHash, sizeof(contentHash));
+}
 
-    if (!file.good()) {
+/// Read a whole file with a single read
+bool readFileImage(const std::string& filename, std::vector<uint8_t>& out) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
         return false;
     }
 
-    // Decompress
-    return decompressRLE(compressed.data(), compressedSize, outPixels, expectedPixels);
-}
-
-void SpriteCompression::compressRLE(const uint8_t* pixels, int pixelCount,
-                                     std::vector<uint8_t>& compressed) {
-    // Use zlib compression instead of custom RLE
-    compressed.clear();
-    
-    // Estimate compressed size (zlib's compressBound gives upper limit)
-    uLongf compressedSize = compressBound(pixelCount);
-    compressed.resize(compressedSize);
-    
-    // Compress using zlib
-    int result = compress2(compressed.data(), &compressedSize,
-                          pixels, pixelCount,
-                          Z_BEST_COMPRESSION);
-    
-    if (result != Z_OK) {
-        printf("[SpriteCompression::compressRLE] ERROR: zlib compression failed with code %d\n", result);
-        compressed.clear();
-        return;
+    std::streamsize size = file.tellg();
+    if (size < 0) {
+        return false;
     }
-    
-    // Resize to actual compressed size
-    compressed.resize(compressedSize);
-    printf("[SpriteCompression::compressRLE] Compressed %d bytes to %zu bytes using zlib\n", 
-           pixelCount, compressed.size());
+    file.seekg(0);
+
+    out.resize(static_cast<size_t>(size));
+    file.read(reinterpret_cast<char*>(out.data()), size);
+    return file.good();
 }
 
-bool SpriteCompression::decompressRLE(const uint8_t* compressed, size_t compressedSize,
-                                       uint8_t* pixels, int pixelCount) {
-    printf("[SpriteCompression::decompressRLE] Starting zlib decompression: compressedSize=%zu, pixelCount=%d\n", 
-          compressedSize, pixelCount);
-    
-    // Use zlib decompression
-    uLongf uncompressedSize = pixelCount;
-    int result = uncompress(pixels, &uncompressedSize,
-                           compressed, compressedSize);
-    
-    if (result != Z_OK) {
-        printf("[SpriteCompression::decompressRLE] ERROR: zlib decompression failed with code %d\n", result);
+/// Write a whole file with a single write
+bool writeFileImage(const std::string& filename, const std::vector<uint8_t>& data) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
         return false;
     }
-    
-    if (uncompressedSize != static_cast<uLongf>(pixelCount)) {
-        printf("[SpriteCompression::decompressRLE] ERROR: Size mismatch (got %lu, expected %d)\n", 
-              uncompressedSize, pixelCount);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return file.good();
+}
+
+} // namespace
+
+// =============================================================================
+// SPRTZ v1 Functions
+// =============================================================================
+
+bool SpriteCompression::saveSPRTZ(const std::string& filename,
+                                   int width, int height,
+                                   const uint8_t* pixels,
+                                   const uint8_t* palette) {
+    std::vector<uint8_t> image;
+    return encodeSPRTZ(image, width, height, pixels, palette) &&
+           writeFileImage(filename, image);
+}
+
+bool SpriteCompression::loadSPRTZ(const std::string& filename,
+                                   int& outWidth, int& outHeight,
+                                   uint8_t* outPixels,
+                                   uint8_t* outPalette) {
+    std::vector<uint8_t> image;
+    return readFileImage(filename, image) &&
+           decodeSPRTZ(image.data(), image.size(), outWidth, outHeight, outPixels, outPalette);
+}
+
+void SpriteCompression::compressZlib(const uint8_t* pixels, int pixelCount,
+                                      std::vector<uint8_t>& compressed) {
+    if (!SpriteCodecs::encode(SPRTZCodec::Zlib, pixels, pixelCount, compressed)) {
+        SPRED_TRACE_LOG("[SpriteCompression::compressZlib] ERROR: zlib compression failed\n");
+        compressed.clear();
+    }
+}
+
+bool SpriteCompression::decompressZlib(const uint8_t* compressed, size_t compressedSize,
+                                        uint8_t* pixels, int pixelCount) {
+    if (!SpriteCodecs::decode(SPRTZCodec::Zlib, compressed, compressedSize, pixels, pixelCount)) {
+        SPRED_TRACE_LOG("[SpriteCompression::decompressZlib] ERROR: zlib decompression failed "
+                        "(compressedSize=%zu, pixelCount=%d)\n", compressedSize, pixelCount);
         return false;
     }
-    
-    printf("[SpriteCompression::decompressRLE] Decompression SUCCESS: %lu bytes\n", uncompressedSize);
     return true;
 }
 
+bool SpriteCompression::decodePayload(uint16_t version, SPRTZCodec codec, uint8_t dictionaryID,
+                                       const uint8_t* payload, size_t payloadSize,
+                                       uint8_t* pixels, int pixelCount) {
+    if (version < 3) {
+        return decompressZlib(payload, payloadSize, pixels, pixelCount);
+    }
+    return SpriteCodecs::decode(codec, payload, payloadSize, pixels, pixelCount, dictionaryID);
+}
+
 size_t SpriteCompression::estimateCompressedSize(const uint8_t* pixels, int pixelCount) {
     // Use zlib's compressBound for accurate estimation
     return compressBound(pixelCount);
@@ -198,205 +344,317 @@ bool SpriteCompression::saveSPRTZv2Standard(const std::string& filename,
                                              int width, int height,
                                              const uint8_t* pixels,
                                              uint8_t standardPaletteID) {
-    if (standardPaletteID >= 32) {
-        return false; // Invalid palette ID
-    }
+    std::vector<uint8_t> image;
+    return encodeSPRTZv2Standard(image, width, height, pixels, standardPaletteID) &&
+           writeFileImage(filename, image);
+}
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        return false;
-    }
+bool SpriteCompression::saveSPRTZv2Custom(const std::string& filename,
+                                          int width, int height,
+                                          const uint8_t* pixels,
+                                          const uint8_t* palette) {
+    std::vector<uint8_t> image;
+    return encodeSPRTZv2Custom(image, width, height, pixels, palette) &&
+           writeFileImage(filename, image);
+}
 
-    // Compress pixel data
-    int pixelCount = width * height;
-    std::vector<uint8_t> compressed;
-    compressRLE(pixels, pixelCount, compressed);
+bool SpriteCompression::loadSPRTZv2(const std::string& filename,
+                                     int& outWidth, int& outHeight,
+                                     uint8_t* outPixels,
+                                     uint8_t* outPalette,
+                                     bool& outIsStandard,
+                                     uint8_t& outPaletteID) {
+    std::vector<uint8_t> image;
+    return readFileImage(filename, image) &&
+           decodeSPRTZv2(image.data(), image.size(), outWidth, outHeight,
+                         outPixels, outPalette, outIsStandard, outPaletteID);
+}
 
-    // Write header
-    const char magic[4] = {'S', 'P', 'T', 'Z'};
-    file.write(magic, 4);
+// =============================================================================
+// SPRTZ v3 Functions
+// =============================================================================
 
-    uint16_t version = 2;
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+bool SpriteCompression::saveSPRTZv3Standard(const std::string& filename,
+                                             int width, int height,
+                                             const uint8_t* pixels,
+                                             uint8_t standardPaletteID,
+                                             SPRTZCodec codec,
+                                             uint8_t dictionaryID) {
+    std::vector<uint8_t> image;
+    return encodeSPRTZv3Standard(image, width, height, pixels, standardPaletteID, codec, dictionaryID) &&
+           writeFileImage(filename, image);
+}
 
-    uint8_t w = static_cast<uint8_t>(width);
-    uint8_t h = static_cast<uint8_t>(height);
-    file.write(reinterpret_cast<const char*>(&w), 1);
-    file.write(reinterpret_cast<const char*>(&h), 1);
+bool SpriteCompression::saveSPRTZv3Custom(const std::string& filename,
+                                           int width, int height,
+                                           const uint8_t* pixels,
+                                           const uint8_t* palette,
+                                           SPRTZCodec codec,
+                                           uint8_t dictionaryID) {
+    std::vector<uint8_t> image;
+    return encodeSPRTZv3Custom(image, width, height, pixels, palette, codec, dictionaryID) &&
+           writeFileImage(filename, image);
+}
 
-    uint32_t uncompressedSize = static_cast<uint32_t>(pixelCount);
-    uint32_t compressedSize = static_cast<uint32_t>(compressed.size());
-    file.write(reinterpret_cast<const char*>(&uncompressedSize), sizeof(uncompressedSize));
-    file.write(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+// =============================================================================
+// In-Memory SPRTZ
+// =============================================================================
 
-    // Write palette mode: standard palette ID (0-31)
-    file.write(reinterpret_cast<const char*>(&standardPaletteID), 1);
+bool SpriteCompression::encodeSPRTZ(std::vector<uint8_t>& out,
+                                     int width, int height,
+                                     const uint8_t* pixels,
+                                     const uint8_t* palette) {
+    if (!isValidSpriteSize(width, height)) {
+        return false;
+    }
 
-    // Write compressed pixel data
-    file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    std::vector<uint8_t> compressed;
+    compressZlib(pixels, width * height, compressed);
+    if (compressed.empty()) {
+        return false;
+    }
 
-    return file.good();
+    out.clear();
+    out.reserve(SPRTZ_HEADER_SIZE + SPRTZ_PALETTE_SIZE + compressed.size());
+    appendHeader(out, 1, width, height, static_cast<uint32_t>(compressed.size()));
+    appendCustomPalette(out, palette);
+    appendBytes(out, compressed.data(), compressed.size());
+    return true;
 }
 
-bool SpriteCompression::saveSPRTZv2Custom(const std::string& filename,
-                                          int width, int height,
-                                          const uint8_t* pixels,
-                                          const uint8_t* palette) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        return false;
+bool SpriteCompression::encodeSPRTZv2Standard(std::vector<uint8_t>& out,
+                                               int width, int height,
+                                               const uint8_t* pixels,
+                                               uint8_t standardPaletteID) {
+    if (!isValidSpriteSize(width, height) || standardPaletteID >= 32) {
+        return false; // Invalid size or palette ID
     }
 
-    // Compress pixel data
-    int pixelCount = width * height;
     std::vector<uint8_t> compressed;
-    compressRLE(pixels, pixelCount, compressed);
+    compressZlib(pixels, width * height, compressed);
+    if (compressed.empty()) {
+        return false;
+    }
 
-    // Write header
-    const char magic[4] = {'S', 'P', 'T', 'Z'};
-    file.write(magic, 4);
+    out.clear();
+    out.reserve(SPRTZ_HEADER_SIZE + 1 + compressed.size());
+    appendHeader(out, 2, width, height, static_cast<uint32_t>(compressed.size()));
+    out.push_back(standardPaletteID);
+    appendBytes(out, compressed.data(), compressed.size());
+    return true;
+}
 
-    uint16_t version = 2;
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+bool SpriteCompression::encodeSPRTZv2Custom(std::vector<uint8_t>& out,
+                                             int width, int height,
+                                             const uint8_t* pixels,
+                                             const uint8_t* palette) {
+    if (!isValidSpriteSize(width, height)) {
+        return false;
+    }
 
-    uint8_t w = static_cast<uint8_t>(width);
-    uint8_t h = static_cast<uint8_t>(height);
-    file.write(reinterpret_cast<const char*>(&w), 1);
-    file.write(reinterpret_cast<const char*>(&h), 1);
+    std::vector<uint8_t> compressed;
+    compressZlib(pixels, width * height, compressed);
+    if (compressed.empty()) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(SPRTZ_HEADER_SIZE + 1 + SPRTZ_PALETTE_SIZE + compressed.size());
+    appendHeader(out, 2, width, height, static_cast<uint32_t>(compressed.size()));
+    out.push_back(0xFF);
+    appendCustomPalette(out, palette);
+    appendBytes(out, compressed.data(), compressed.size());
+    return true;
+}
 
-    uint32_t uncompressedSize = static_cast<uint32_t>(pixelCount);
-    uint32_t compressedSize = static_cast<uint32_t>(compressed.size());
-    file.write(reinterpret_cast<const char*>(&uncompressedSize), sizeof(uncompressedSize));
-    file.write(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+bool SpriteCompression::encodeSPRTZv3Standard(std::vector<uint8_t>& out,
+                                               int width, int height,
+                                               const uint8_t* pixels,
+                                               uint8_t standardPaletteID,
+                                               SPRTZCodec codec,
+                                               uint8_t dictionaryID) {
+    if (standardPaletteID >= 32) {
+        return false; // Invalid palette ID
+    }
+    return encodeSPRTZv3(out, width, height, pixels, standardPaletteID, nullptr, codec, nullptr, dictionaryID);
+}
 
-    // Write palette mode: 0xFF for custom palette
-    uint8_t paletteMode = 0xFF;
-    file.write(reinterpret_cast<const char*>(&paletteMode), 1);
+bool SpriteCompression::encodeSPRTZv3Custom(std::vector<uint8_t>& out,
+                                             int width, int height,
+                                             const uint8_t* pixels,
+                                             const uint8_t* palette,
+                                             SPRTZCodec codec,
+                                             uint8_t dictionaryID) {
+    return encodeSPRTZv3(out, width, height, pixels, 0xFF, palette, codec, nullptr, dictionaryID);
+}
 
-    // Write palette (indices 2-15 only, RGB only)
-    for (int i = 2; i < 16; i++) {
-        int offset = i * 4;
-        uint8_t rgb[3] = {palette[offset], palette[offset + 1], palette[offset + 2]};
-        file.write(reinterpret_cast<const char*>(rgb), 3);
+bool SpriteCompression::encodeSPRTZv3(std::vector<uint8_t>& out,
+                                       int width, int height,
+                                       const uint8_t* pixels,
+                                       uint8_t paletteMode,
+                                       const uint8_t* palette,
+                                       SPRTZCodec codec,
+                                       SpriteCodecContext* context,
+                                       uint8_t dictionaryID) {
+    if (!isValidSpriteSize(width, height)) {
+        return false;
+    }
+    if (paletteMode >= 32 && (paletteMode != 0xFF || !palette)) {
+        return false; // Invalid palette mode
     }
 
-    // Write compressed pixel data
-    file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    std::vector<uint8_t> localPayload;
+    std::vector<uint8_t>& payload = context ? context->m_payload : localPayload;
+    SPRTZCodec usedCodec;
+    if (!SpriteCodecs::encodeBest(codec, pixels, width * height, payload, usedCodec, context, dictionaryID)) {
+        return false;
+    }
 
-    return file.good();
+    size_t paletteSize = paletteMode == 0xFF ? SPRTZ_PALETTE_SIZE : 0;
+    out.clear();
+    out.reserve(SPRTZ_HEADER_SIZE + SPRTZ_V3_EXTENSION_SIZE + SPRTZ_CONTENT_HASH_SIZE +
+                paletteSize + payload.size());
+    appendHeader(out, 3, width, height, static_cast<uint32_t>(payload.size()));
+    appendV3Extension(out, paletteMode, usedCodec, usedCodec == SPRTZCodec::Zlib ? dictionaryID : 0,
+                      computeContentHash(width, height, pixels, paletteMode, palette));
+    if (paletteMode == 0xFF) {
+        appendCustomPalette(out, palette);
+    }
+    appendBytes(out, payload.data(), payload.size());
+    return true;
 }
 
-bool SpriteCompression::loadSPRTZv2(const std::string& filename,
+bool SpriteCompression::decodeSPRTZ(const uint8_t* data, size_t size,
                                      int& outWidth, int& outHeight,
                                      uint8_t* outPixels,
-                                     uint8_t* outPalette,
-                                     bool& outIsStandard,
-                                     uint8_t& outPaletteID) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
+                                     uint8_t* outPalette) {
+    SPRTZHeader header;
+    if (!parseSPRTZHeader(data, size, header) || header.version != 1) {
         return false;
     }
 
-    // Read and verify header
-    char magic[4];
-    file.read(magic, 4);
-    if (magic[0] != 'S' || magic[1] != 'P' || magic[2] != 'T' || magic[3] != 'Z') {
+    if (!canResolvePalette(header) ||
+        !decodePayload(header.version, header.codec, header.dictionaryID, header.payload, header.payloadSize,
+                       outPixels, header.width * header.height)) {
         return false;
     }
-
-    uint16_t version;
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    
-    // Support both v1 and v2
-    if (version == 1) {
-        // v1 format - treat as custom palette
-        outIsStandard = false;
-        outPaletteID = 0xFF;
-        
-        // Rewind and use v1 loader
-        file.seekg(0);
-        return loadSPRTZ(filename, outWidth, outHeight, outPixels, outPalette);
-    }
-    
-    if (version != 2) {
+    if (!resolvePalette(header, outPalette)) {
         return false;
     }
 
-    uint8_t w, h;
-    file.read(reinterpret_cast<char*>(&w), 1);
-    file.read(reinterpret_cast<char*>(&h), 1);
-    outWidth = w;
-    outHeight = h;
+    outWidth = header.width;
+    outHeight = header.height;
+    return true;
+}
 
-    uint32_t uncompressedSize, compressedSize;
-    file.read(reinterpret_cast<char*>(&uncompressedSize), sizeof(uncompressedSize));
-    file.read(reinterpret_cast<char*>(&compressedSize), sizeof(compressedSize));
+bool SpriteCompression::decodeSPRTZv2(const uint8_t* data, size_t size,
+                                       int& outWidth, int& outHeight,
+                                       uint8_t* outPixels,
+                                       uint8_t* outPalette,
+                                       bool& outIsStandard,
+                                       uint8_t& outPaletteID) {
+    SPRTZHeader header;
+    if (!parseSPRTZHeader(data, size, header)) {
+        return false;
+    }
 
-    // Verify sizes
-    int expectedPixels = outWidth * outHeight;
-    if (uncompressedSize != static_cast<uint32_t>(expectedPixels)) {
+    if (!canResolvePalette(header) ||
+        !decodePayload(header.version, header.codec, header.dictionaryID, header.payload, header.payloadSize,
+                       outPixels, header.width * header.height)) {
+        return false;
+    }
+    if (!matchesContentHash(header, outPixels)) {
+        SPRED_TRACE_LOG("[SpriteCompression::decodeSPRTZv2] ERROR: content hash mismatch\n");
+        return false;
+    }
+    if (!resolvePalette(header, outPalette)) {
         return false;
     }
 
-    // Read palette mode
-    uint8_t paletteMode;
-    file.read(reinterpret_cast<char*>(&paletteMode), 1);
+    outWidth = header.width;
+    outHeight = header.height;
+    outIsStandard = header.paletteMode != 0xFF;
+    outPaletteID = header.paletteMode;
+    return true;
+}
 
-    // Set up fixed colors 0 and 1
-    outPalette[0] = 0;   // R
-    outPalette[1] = 0;   // G
-    outPalette[2] = 0;   // B
-    outPalette[3] = 0;   // A (transparent)
+bool SpriteCompression::decodeSPRTZToSurface(const uint8_t* data, size_t size,
+                                              const SpriteSurface& surface, int x, int y,
+                                              int& outWidth, int& outHeight) {
+    SPRTZHeader header;
+    if (!parseSPRTZHeader(data, size, header) || !canResolvePalette(header)) {
+        return false;
+    }
 
-    outPalette[4] = 0;   // R
-    outPalette[5] = 0;   // G
-    outPalette[6] = 0;   // B
-    outPalette[7] = 255; // A (opaque)
+    // Reject before decoding: the surface check is free, the payload is not
+    if (!surface.pixels || x < 0 || y < 0 ||
+        x + header.width > surface.width || y + header.height > surface.height) {
+        return false;
+    }
 
-    if (paletteMode == 0xFF) {
-        // Custom palette
-        outIsStandard = false;
-        outPaletteID = 0xFF;
-        
-        // Read colors 2-15
-        for (int i = 2; i < 16; i++) {
-            uint8_t rgb[3];
-            file.read(reinterpret_cast<char*>(rgb), 3);
-            int offset = i * 4;
-            outPalette[offset + 0] = rgb[0];
-            outPalette[offset + 1] = rgb[1];
-            outPalette[offset + 2] = rgb[2];
-            outPalette[offset + 3] = 255;
-        }
-    } else if (paletteMode < 32) {
-        // Standard palette
-        outIsStandard = true;
-        outPaletteID = paletteMode;
-        
-        // Load from palette library
-        if (StandardPaletteLibrary::isInitialized()) {
-            if (!StandardPaletteLibrary::copyPaletteRGBA(paletteMode, outPalette)) {
-                return false;
-            }
-        } else {
-            // Library not initialized - can't load standard palette
-            return false;
-        }
-    } else {
-        // Invalid palette mode
+    uint8_t pixels[SPRTZ_MAX_PIXELS];
+    uint8_t palette[64];
+    if (!decodePayload(header.version, header.codec, header.dictionaryID, header.payload, header.payloadSize,
+                       pixels, header.width * header.height) ||
+        !matchesContentHash(header, pixels) ||
+        !resolvePalette(header, palette)) {
         return false;
     }
 
-    // Read compressed pixel data
-    std::vector<uint8_t> compressed(compressedSize);
-    file.read(reinterpret_cast<char*>(compressed.data()), compressedSize);
+    if (!PaletteExpand::expandToSurface(pixels, header.width, header.height, palette, surface, x, y)) {
+        return false;
+    }
+    outWidth = header.width;
+    outHeight = header.height;
+    return true;
+}
+
+// =============================================================================
+// Header-Only Access and Validation
+// =============================================================================
+
+bool SpriteCompression::readSPRTZInfo(const uint8_t* data, size_t size, SPRTZInfo& outInfo) {
+    SPRTZHeader header;
+    if (!parseSPRTZHeader(data, size, header)) {
+        return false;
+    }
+    copyInfo(header, outInfo);
+    return true;
+}
 
-    if (!file.good()) {
+bool SpriteCompression::decodeSPRTZPixels(const uint8_t* data, size_t size, SPRTZInfo& outInfo,
+                                          uint8_t* outPixels) {
+    SPRTZHeader header;
+    if (!parseSPRTZHeader(data, size, header)) {
+        return false;
+    }
+    if (!decodePayload(header.version, header.codec, header.dictionaryID, header.payload, header.payloadSize,
+                       outPixels, header.width * header.height) ||
+        !matchesContentHash(header, outPixels)) {
         return false;
     }
+    copyInfo(header, outInfo);
+    return true;
+}
+
+bool SpriteCompression::validateSPRTZ(const uint8_t* data, size_t size) {
+    SPRTZInfo info;
+    uint8_t pixels[SPRTZ_MAX_PIXELS];
+    return decodeSPRTZPixels(data, size, info, pixels);
+}
 
-    // Decompress
-    return decompressRLE(compressed.data(), compressedSize, outPixels, expectedPixels);
+uint64_t SpriteCompression::computeContentHash(int width, int height, const uint8_t* pixels,
+                                               uint8_t paletteMode, const uint8_t* palette) {
+    if (paletteMode != 0xFF) {
+        return hashContent(width, height, pixels, paletteMode, nullptr);
+    }
+
+    // Hash the palette bytes exactly as they are embedded (indices 2-15, RGB)
+    uint8_t rgb[SPRTZ_PALETTE_SIZE];
+    for (int i = 2; i < 16; i++) {
+        std::memcpy(rgb + (i - 2) * 3, palette + i * 4, 3);
+    }
+    return hashContent(width, height, pixels, paletteMode, rgb);
 }
 
-} // namespace SPRED
\ No newline at end of file
+} // namespace SPRED
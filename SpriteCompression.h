@@ -8,12 +8,28 @@
 #ifndef SPRED_SPRITE_COMPRESSION_H
 #define SPRED_SPRITE_COMPRESSION_H
 
+#include "PaletteExpand.h"
+#include "SpriteCodecs.h"
 #include <cstdint>
 #include <string>
 #include <vector>
 
 namespace SPRED {
 
+/// Header fields of a SPRTZ file image, read without decoding the payload
+struct SPRTZInfo {
+    uint16_t version = 0;
+    int width = 0;
+    int height = 0;
+    uint8_t paletteMode = 0xFF;         // 0-31 standard, 0xFF custom
+    SPRTZCodec codec = SPRTZCodec::Zlib;
+    uint8_t dictionaryID = 0;           // Preset zlib dictionary, 0 = none
+    bool hasContentHash = false;        // v3 files written since content hashes were added
+    uint64_t contentHash = 0;
+    const uint8_t* palette = nullptr;   // Embedded 42-byte RGB palette (colors 2-15), or nullptr
+    uint32_t payloadSize = 0;
+};
+
 /// SPRTZ Format Specification
 /// ===========================
 ///
@@ -55,27 +71,35 @@ namespace SPRED {
 ///   Header (16 bytes) + 0xFF + Palette (42 bytes) + Compressed data
 ///   Total: 59 bytes + compressed data (1 byte larger than v1)
 ///
+/// SPRTZ v3 Format Changes:
+/// -------------------------
+/// Version field = 3, compressed size field = payload size for the codec
+/// Offset | Size | Description
+/// -------|------|----------------------------------
+/// 0x10   | 1    | Palette Mode (as v2)
+/// 0x11   | 1    | Codec (0 Stored, 1 RLE, 2 Zlib, 3 LZ, 4 Masked - see SpriteCodecs.h)
+/// 0x12   | 1    | Flags (bit 0: content hash present; other bits must be 0)
+/// 0x13   | 1    | Dictionary ID (0 = none; Zlib codec only, see SpriteDictionary.h)
+/// 0x14   | 8    | Content hash (only if flag bit 0 is set)
+/// ...    | 42   | Palette (custom palette mode only)
+///
+/// v3 with Standard Palette: 20 bytes (28 with hash) + payload
+/// v3 with Custom Palette:   62 bytes (70 with hash) + payload
+///
+/// The content hash is SpriteHash::hash64 over the decoded pixel indices,
+/// seeded with width, height, palette mode and the embedded palette bytes.
+/// It identifies the decoded sprite without decompressing it, and decoders
+/// reject files whose pixels do not match it. The encoder always writes it.
+///
 /// Compressed Pixel Data (variable):
 /// ----------------------------------
 /// Offset | Size     | Description
 /// -------|----------|----------------------------------
-/// varies | variable | RLE compressed pixel data
-///
-/// RLE Compression:
-/// ----------------
-/// Simple run-length encoding for 4-bit indices:
-/// - If count <= 15: [count:4bits][value:4bits] (1 byte)
-/// - If count > 15:  [0xF0][count:8bits][value:4bits padding:4bits] (3 bytes)
+/// varies | variable | Compressed pixel data
 ///
-/// Example:
-/// Raw: 0 0 0 0 0 1 1 2 2 2
-/// RLE: [5:4][0:4] [2:4][1:4] [3:4][2:4]
-///      = 0x50 0x21 0x32
-///
-/// For runs > 15:
-/// Raw: 20 zeros
-/// RLE: [0xF0][20:8][0:4][0:4]
-///      = 0xF0 0x14 0x00
+/// v1 and v2 payloads are always zlib streams of the index bytes.
+/// v3 payloads use the codec named in the header; the encoder picks the
+/// smallest (or fastest-decoding) codec per sprite.
 
 class SpriteCompression {
 public:
@@ -135,7 +159,7 @@ public:
                                   const uint8_t* pixels,
                                   const uint8_t* palette);
 
-    /// Load sprite from SPRTZ v2 format (with palette mode detection)
+    /// Load sprite from SPRTZ v1, v2 or v3 format (with palette mode detection)
     /// @param filename Input file path
     /// @param outWidth Output sprite width
     /// @param outHeight Output sprite height
@@ -151,6 +175,206 @@ public:
                             bool& outIsStandard,
                             uint8_t& outPaletteID);
 
+    // =============================================================================
+    // SPRTZ v3 Functions (Per-Sprite Codec Selection)
+    // =============================================================================
+    //
+    // v3 files are read by loadSPRTZv2 / decodeSPRTZv2 like v1 and v2 files.
+
+    /// Save sprite in SPRTZ v3 format with standard palette reference
+    /// @param filename Output file path
+    /// @param width Sprite width (8, 16, or 40)
+    /// @param height Sprite height (8, 16, or 40)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param standardPaletteID Standard palette ID (0-31)
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param dictionaryID Preset zlib dictionary (0 = none)
+    /// @return true if successful
+    static bool saveSPRTZv3Standard(const std::string& filename,
+                                    int width, int height,
+                                    const uint8_t* pixels,
+                                    uint8_t standardPaletteID,
+                                    SPRTZCodec codec = SPRTZCodec::AutoSmallest,
+                                    uint8_t dictionaryID = 0);
+
+    /// Save sprite in SPRTZ v3 format with custom palette
+    /// @param filename Output file path
+    /// @param width Sprite width (8, 16, or 40)
+    /// @param height Sprite height (8, 16, or 40)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param dictionaryID Preset zlib dictionary (0 = none)
+    /// @return true if successful
+    static bool saveSPRTZv3Custom(const std::string& filename,
+                                  int width, int height,
+                                  const uint8_t* pixels,
+                                  const uint8_t* palette,
+                                  SPRTZCodec codec = SPRTZCodec::AutoSmallest,
+                                  uint8_t dictionaryID = 0);
+
+    // =============================================================================
+    // In-Memory SPRTZ (asset servers, sprite banks, memory-mapped data)
+    // =============================================================================
+    //
+    // The file functions above are thin wrappers around these: one read or
+    // write of the whole file image, and the header is parsed exactly once.
+    // Decoding writes straight into the caller's pixel and palette buffers.
+    // The palette and dimensions are only written on success; a corrupt
+    // compressed stream can leave the pixel buffer partially written.
+    // SpriteData's loaders decode into locals for that reason. Encoders and
+    // the header parser reject sizes outside 1-40 on either side.
+
+    /// Encode sprite as a SPRTZ v1 file image (custom palette)
+    /// @param out Output buffer (replaced with the complete file image)
+    /// @param width Sprite width (8, 16, or 40)
+    /// @param height Sprite height (8, 16, or 40)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @return true if successful
+    static bool encodeSPRTZ(std::vector<uint8_t>& out,
+                            int width, int height,
+                            const uint8_t* pixels,
+                            const uint8_t* palette);
+
+    /// Encode sprite as a SPRTZ v2 file image with standard palette reference
+    /// @param out Output buffer (replaced with the complete file image)
+    /// @param width Sprite width (8, 16, or 40)
+    /// @param height Sprite height (8, 16, or 40)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param standardPaletteID Standard palette ID (0-31)
+    /// @return true if successful
+    static bool encodeSPRTZv2Standard(std::vector<uint8_t>& out,
+                                      int width, int height,
+                                      const uint8_t* pixels,
+                                      uint8_t standardPaletteID);
+
+    /// Encode sprite as a SPRTZ v2 file image with custom palette
+    /// @param out Output buffer (replaced with the complete file image)
+    /// @param width Sprite width (8, 16, or 40)
+    /// @param height Sprite height (8, 16, or 40)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @return true if successful
+    static bool encodeSPRTZv2Custom(std::vector<uint8_t>& out,
+                                    int width, int height,
+                                    const uint8_t* pixels,
+                                    const uint8_t* palette);
+
+    /// Encode sprite as a SPRTZ v3 file image with standard palette reference
+    /// @param out Output buffer (replaced with the complete file image)
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param dictionaryID Preset zlib dictionary (0 = none)
+    /// @return true if successful
+    static bool encodeSPRTZv3Standard(std::vector<uint8_t>& out,
+                                      int width, int height,
+                                      const uint8_t* pixels,
+                                      uint8_t standardPaletteID,
+                                      SPRTZCodec codec = SPRTZCodec::AutoSmallest,
+                                      uint8_t dictionaryID = 0);
+
+    /// Encode sprite as a SPRTZ v3 file image with custom palette
+    /// @param out Output buffer (replaced with the complete file image)
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param dictionaryID Preset zlib dictionary (0 = none)
+    /// @return true if successful
+    static bool encodeSPRTZv3Custom(std::vector<uint8_t>& out,
+                                    int width, int height,
+                                    const uint8_t* pixels,
+                                    const uint8_t* palette,
+                                    SPRTZCodec codec = SPRTZCodec::AutoSmallest,
+                                    uint8_t dictionaryID = 0);
+
+    /// Encode sprite as a SPRTZ v3 file image, reusing encoder state across calls
+    /// @param out Output buffer (replaced; its capacity is reused)
+    /// @param paletteMode Standard palette ID (0-31), or 0xFF for custom
+    /// @param palette Full 64-byte palette (RGBA), only read when paletteMode is 0xFF
+    /// @param codec Fixed codec or Auto selection mode
+    /// @param context Reusable encoder state (nullptr for a one-off encode)
+    /// @param dictionaryID Preset zlib dictionary (0 = none); recorded only if Zlib is chosen
+    /// @return true if successful
+    static bool encodeSPRTZv3(std::vector<uint8_t>& out,
+                              int width, int height,
+                              const uint8_t* pixels,
+                              uint8_t paletteMode,
+                              const uint8_t* palette,
+                              SPRTZCodec codec,
+                              SpriteCodecContext* context,
+                              uint8_t dictionaryID = 0);
+
+    /// Decode a SPRTZ v1 file image held in memory
+    /// @param data Start of the file image
+    /// @param size Size of the file image in bytes
+    /// @param outWidth Output sprite width
+    /// @param outHeight Output sprite height
+    /// @param outPixels Output pixel buffer (must be at least width×height bytes)
+    /// @param outPalette Output palette buffer (must be 64 bytes)
+    /// @return true if successful
+    static bool decodeSPRTZ(const uint8_t* data, size_t size,
+                            int& outWidth, int& outHeight,
+                            uint8_t* outPixels,
+                            uint8_t* outPalette);
+
+    /// Decode a SPRTZ file image (v1, v2 or v3) held in memory
+    /// @param data Start of the file image
+    /// @param size Size of the file image in bytes
+    /// @param outWidth Output sprite width
+    /// @param outHeight Output sprite height
+    /// @param outPixels Output pixel buffer (must be at least width×height bytes)
+    /// @param outPalette Output palette buffer (must be 64 bytes)
+    /// @param outIsStandard Output: true if using standard palette, false if custom
+    /// @param outPaletteID Output: standard palette ID (0-31) or 0xFF if custom
+    /// @return true if successful
+    static bool decodeSPRTZv2(const uint8_t* data, size_t size,
+                              int& outWidth, int& outHeight,
+                              uint8_t* outPixels,
+                              uint8_t* outPalette,
+                              bool& outIsStandard,
+                              uint8_t& outPaletteID);
+
+    /// Decode a SPRTZ file image (v1, v2 or v3) straight into a 32-bit surface
+    /// Pixels go from the payload to the surface through a 16-entry color
+    /// table; no RGBA intermediate or SpriteData is involved. Every pixel of
+    /// the sprite rectangle is written (index 0 as transparent).
+    /// @param surface Destination surface (format selects RGBA/BGRA/premultiplied)
+    /// @param x Destination x of the sprite's left edge
+    /// @param y Destination y of the sprite's top edge
+    /// @param outWidth Output sprite width
+    /// @param outHeight Output sprite height
+    /// @return true if successful (false if the sprite does not fit at x, y)
+    static bool decodeSPRTZToSurface(const uint8_t* data, size_t size,
+                                     const SpriteSurface& surface, int x, int y,
+                                     int& outWidth, int& outHeight);
+
+    // =============================================================================
+    // Header-Only Access and Validation
+    // =============================================================================
+
+    /// Read the header of a SPRTZ file image (the payload is not touched)
+    /// @param outInfo Output header fields
+    /// @return true if the header is valid and the payload lies within the image
+    static bool readSPRTZInfo(const uint8_t* data, size_t size, SPRTZInfo& outInfo);
+
+    /// Decode only the pixels of a SPRTZ file image (any version)
+    /// The palette is left as stored (see SPRTZInfo), so standard palettes need not be loaded.
+    /// @param outInfo Output header fields
+    /// @param outPixels Output pixel buffer (must be at least width×height bytes)
+    /// @return true if the image decodes (and matches its content hash)
+    static bool decodeSPRTZPixels(const uint8_t* data, size_t size, SPRTZInfo& outInfo, uint8_t* outPixels);
+
+    /// Check a SPRTZ file image without producing any output
+    /// Decodes the payload into scratch memory and, if present, checks the
+    /// content hash. Standard palettes need not be loaded.
+    /// @return true if the image decodes (and matches its content hash)
+    static bool validateSPRTZ(const uint8_t* data, size_t size);
+
+    /// Content hash as stored in v3 headers
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param paletteMode Standard palette ID (0-31), or 0xFF for custom
+    /// @param palette Full 64-byte palette (RGBA), only read when paletteMode is 0xFF
+    static uint64_t computeContentHash(int width, int height, const uint8_t* pixels,
+                                       uint8_t paletteMode, const uint8_t* palette);
+
     // =============================================================================
     // Utilities
     // =============================================================================
@@ -162,21 +386,26 @@ public:
     static size_t estimateCompressedSize(const uint8_t* pixels, int pixelCount);
 
 private:
-    /// RLE compress pixel data
+    /// zlib compress pixel data (v1/v2 payload)
     /// @param pixels Input pixel data
     /// @param pixelCount Number of pixels
     /// @param compressed Output compressed data
-    static void compressRLE(const uint8_t* pixels, int pixelCount,
-                           std::vector<uint8_t>& compressed);
+    static void compressZlib(const uint8_t* pixels, int pixelCount,
+                             std::vector<uint8_t>& compressed);
 
-    /// RLE decompress pixel data
+    /// zlib decompress pixel data (v1/v2 payload)
     /// @param compressed Input compressed data
     /// @param compressedSize Size of compressed data
     /// @param pixels Output pixel buffer
     /// @param pixelCount Expected number of pixels
     /// @return true if successful
-    static bool decompressRLE(const uint8_t* compressed, size_t compressedSize,
-                             uint8_t* pixels, int pixelCount);
+    static bool decompressZlib(const uint8_t* compressed, size_t compressedSize,
+                               uint8_t* pixels, int pixelCount);
+
+    /// Decode the payload of any SPRTZ version
+    static bool decodePayload(uint16_t version, SPRTZCodec codec, uint8_t dictionaryID,
+                              const uint8_t* payload, size_t payloadSize,
+                              uint8_t* pixels, int pixelCount);
 };
 
 /// Get file format description for documentation
@@ -187,7 +416,7 @@ SPRTZ Format Specification
 
 SPRTZ is a compressed sprite format for indexed 4-bit sprites.
 It stores sprite dimensions, a 14-color RGB palette (indices 2-15),
-and RLE-compressed pixel data.
+and compressed pixel data.
 
 File Structure:
 ---------------
@@ -219,15 +448,20 @@ Stored colors (indices 2-15):
 
 Compression Algorithm:
 ----------------------
-Run-Length Encoding (RLE) for 4-bit values:
+v1 and v2: zlib stream of the index bytes.
 
-Short runs (count 1-15):
-  [count:4bits][value:4bits]
-  1 byte per run
+v3 adds a codec byte and picks one per sprite:
+  0 Stored - raw index bytes
+  1 RLE    - 4-bit runs: [count:4][value:4], or
+             [0xF0][count:8][value:4][padding:4] for runs of 15-255
+  2 Zlib   - as v1/v2, optionally primed with a preset dictionary
+             (ID in byte 0x13, trained with sprtz_tool train-dict)
+  3 LZ     - byte LZ77 tuned for fast decoding
+  4 Masked - opaque span list, then only the opaque indices packed
+             two per byte; blitters skip transparent runs outright
 
-Long runs (count 16-255):
-  [0xF0][count:8bits][value:4bits][padding:4bits]
-  3 bytes per run
+v3 headers also carry a 64-bit hash of the decoded sprite, so caches can
+match a file to a decoded copy and loaders can reject corrupt pixels.
 
 Example:
 --------
@@ -7,14 +7,40 @@
 
 #include "SpriteData.h"
 #include "PNGConverter.h"
+#include "PaletteMapper.h"
 #include "SpriteCompression.h"
+#include "SpriteBank.h"
 #include "PaletteLibrary.h"
+#include "NibblePacking.h"
+#include "PaletteExpand.h"
+#include "SpriteScale.h"
+#include "SpriteTrace.h"
 #include <cstring>
 #include <fstream>
 #include <algorithm>
+#include <atomic>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRED_IMPORT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPRED_IMPORT_NEON 1
+#endif
 
 namespace SPRED {
 
+namespace {
+
+/// Generations come from one process-wide counter, so two sprites only share
+/// a generation when one is a copy of the other with no edit since
+uint64_t nextGeneration() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // anonymous namespace
+
 SpriteData::SpriteData() : m_width(8), m_height(8) {
     clear();
 }
@@ -42,6 +68,9 @@ uint8_t SpriteData::getPixel(int x, int y) const {
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
         return 0;
     }
+    if (m_layout == PixelLayout::Packed) {
+        return NibblePacking::get(m_pixels, y * m_width + x);
+    }
     return m_pixels[y * m_width + x];
 }
 
@@ -52,7 +81,144 @@ void SpriteData::setPixel(int x, int y, uint8_t colorIndex) {
     if (colorIndex >= PALETTE_SIZE) {
         colorIndex = 0;
     }
-    m_pixels[y * m_width + x] = colorIndex;
+    if (getPixel(x, y) == colorIndex) {
+        return;
+    }
+    if (m_layout == PixelLayout::Packed) {
+        NibblePacking::set(m_pixels, y * m_width + x, colorIndex);
+    } else {
+        m_pixels[y * m_width + x] = colorIndex;
+    }
+    markPixelsDirty(x, y, x + 1, y + 1);
+}
+
+void SpriteData::transform(SpriteOrientation orientation) {
+    if (orientation == SpriteOrientation::Identity) {
+        return;
+    }
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    uint8_t transformed[MAX_SPRITE_PIXELS];
+    SpriteTransform::apply(getUnpackedPixels(scratch), m_width, m_height, orientation, transformed);
+    if (SpriteTransform::swapsAxes(orientation)) {
+        std::swap(m_width, m_height);
+    }
+    if (m_layout == PixelLayout::Packed) {
+        NibblePacking::pack(transformed, m_pixels, m_width * m_height);
+    } else {
+        std::memcpy(m_pixels, transformed, m_width * m_height);
+    }
+    markAllDirty();
+}
+
+void SpriteData::shift(int dx, int dy) {
+    if (dx % m_width == 0 && dy % m_height == 0) {
+        return;
+    }
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    uint8_t shifted[MAX_SPRITE_PIXELS];
+    SpriteTransform::shift(getUnpackedPixels(scratch), m_width, m_height, dx, dy, shifted);
+    if (m_layout == PixelLayout::Packed) {
+        NibblePacking::pack(shifted, m_pixels, m_width * m_height);
+    } else {
+        std::memcpy(m_pixels, shifted, m_width * m_height);
+    }
+    markAllDirty();
+}
+
+void SpriteData::setPixelLayout(PixelLayout layout) {
+    if (layout == m_layout) {
+        return;
+    }
+
+    int numPixels = m_width * m_height;
+    if (layout == PixelLayout::Packed) {
+        NibblePacking::pack(m_pixels, m_pixels, numPixels);
+        std::memset(m_pixels + NibblePacking::packedSize(numPixels), 0,
+                    MAX_SPRITE_PIXELS - NibblePacking::packedSize(numPixels));
+    } else {
+        uint8_t packed[MAX_SPRITE_PIXELS / 2];
+        std::memcpy(packed, m_pixels, NibblePacking::packedSize(numPixels));
+        NibblePacking::unpack(packed, m_pixels, numPixels);
+    }
+    m_layout = layout;
+}
+
+const uint8_t* SpriteData::getUnpackedPixels(uint8_t* scratch) const {
+    if (m_layout == PixelLayout::Unpacked) {
+        return m_pixels;
+    }
+    NibblePacking::unpack(m_pixels, scratch, m_width * m_height);
+    return scratch;
+}
+
+bool SpriteData::commitLoadedSprite(int width, int height, const uint8_t* pixels, const uint8_t* palette) {
+    // Loaders decode into locals and only get here on success, so a failed
+    // load leaves the sprite untouched. The decoders check the size too;
+    // this is the last guard before it reaches the fixed-size buffers.
+    if (width < 1 || height < 1 || width > MAX_SPRITE_SIZE || height > MAX_SPRITE_SIZE) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    if (m_layout == PixelLayout::Packed) {
+        NibblePacking::pack(pixels, m_pixels, width * height);
+    } else {
+        std::memcpy(m_pixels, pixels, size_t(width) * height);
+    }
+    std::memcpy(m_palette, palette, PALETTE_BYTES);
+    markAllDirty();
+    m_paletteDirty = true;
+    return true;
+}
+
+void SpriteData::markPixelsDirty(int x0, int y0, int x1, int y1) {
+    if (m_dirtyX0 >= m_dirtyX1) {
+        m_dirtyX0 = x0;
+        m_dirtyY0 = y0;
+        m_dirtyX1 = x1;
+        m_dirtyY1 = y1;
+    } else {
+        m_dirtyX0 = std::min(m_dirtyX0, x0);
+        m_dirtyY0 = std::min(m_dirtyY0, y0);
+        m_dirtyX1 = std::max(m_dirtyX1, x1);
+        m_dirtyY1 = std::max(m_dirtyY1, y1);
+    }
+    m_generation = nextGeneration();
+}
+
+void SpriteData::markAllDirty() {
+    m_dirtyX0 = 0;
+    m_dirtyY0 = 0;
+    m_dirtyX1 = m_width;
+    m_dirtyY1 = m_height;
+    m_generation = nextGeneration();
+}
+
+SpriteChanges SpriteData::getChanges() const {
+    SpriteChanges changes;
+    changes.generation = m_generation;
+    changes.paletteChanged = m_paletteDirty;
+    changes.resized = m_width != m_consumedWidth || m_height != m_consumedHeight;
+    if (changes.resized) {
+        changes.pixels.width = m_width;
+        changes.pixels.height = m_height;
+    } else if (m_dirtyX0 < m_dirtyX1) {
+        // Clamp: the box may have been marked while the sprite was briefly larger
+        changes.pixels.x = m_dirtyX0;
+        changes.pixels.y = m_dirtyY0;
+        changes.pixels.width = std::min(m_dirtyX1, m_width) - m_dirtyX0;
+        changes.pixels.height = std::min(m_dirtyY1, m_height) - m_dirtyY0;
+    }
+    return changes;
+}
+
+SpriteChanges SpriteData::consumeChanges() {
+    SpriteChanges changes = getChanges();
+    m_dirtyX0 = m_dirtyY0 = m_dirtyX1 = m_dirtyY1 = 0;
+    m_paletteDirty = false;
+    m_consumedWidth = m_width;
+    m_consumedHeight = m_height;
+    return changes;
 }
 
 void SpriteData::getPaletteColor(int index, uint8_t& r, uint8_t& g, uint8_t& b, uint8_t& a) const {
@@ -73,15 +239,22 @@ void SpriteData::setPaletteColor(int index, uint8_t r, uint8_t g, uint8_t b, uin
         return;
     }
     int offset = index * 4;
+    if (m_palette[offset + 0] == r && m_palette[offset + 1] == g &&
+        m_palette[offset + 2] == b && m_palette[offset + 3] == a) {
+        return;
+    }
     m_palette[offset + 0] = r;
     m_palette[offset + 1] = g;
     m_palette[offset + 2] = b;
     m_palette[offset + 3] = a;
+    m_paletteDirty = true;
+    m_generation = nextGeneration();
 }
 
 void SpriteData::clear() {
     // Clear all pixels to transparent (index 0)
     std::memset(m_pixels, 0, MAX_SPRITE_PIXELS);
+    markAllDirty();
 
     // Initialize default palette
     initializeDefaultPalette();
@@ -102,18 +275,36 @@ void SpriteData::initializeDefaultPalette() {
 }
 
 void SpriteData::getRGBAPixels(uint8_t* outRGBA) const {
-    int numPixels = m_width * m_height;
-    for (int i = 0; i < numPixels; i++) {
-        uint8_t index = m_pixels[i];
-        if (index >= PALETTE_SIZE) {
-            index = 0;
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    PaletteExpand::buildTable(m_palette, SurfaceFormat::RGBA, table);
+    if (m_layout == PixelLayout::Packed) {
+        PaletteExpand::expandPackedRow(m_pixels, m_width * m_height, table, outRGBA);
+    } else {
+        PaletteExpand::expandRow(m_pixels, m_width * m_height, table, outRGBA);
+    }
+}
+
+void SpriteData::updateRGBAPixels(uint8_t* rgba, const SpriteDirtyRect& rect) const {
+    int x0 = std::max(rect.x, 0);
+    int y0 = std::max(rect.y, 0);
+    int x1 = std::min(rect.x + rect.width, m_width);
+    int y1 = std::min(rect.y + rect.height, m_height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    PaletteExpand::buildTable(m_palette, SurfaceFormat::RGBA, table);
+    uint8_t row[MAX_SPRITE_SIZE];
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* indices = m_pixels + y * m_width + x0;
+        if (m_layout == PixelLayout::Packed) {
+            for (int x = x0; x < x1; x++) {
+                row[x - x0] = NibblePacking::get(m_pixels, y * m_width + x);
+            }
+            indices = row;
         }
-        int paletteOffset = index * 4;
-        int rgbaOffset = i * 4;
-        outRGBA[rgbaOffset + 0] = m_palette[paletteOffset + 0];
-        outRGBA[rgbaOffset + 1] = m_palette[paletteOffset + 1];
-        outRGBA[rgbaOffset + 2] = m_palette[paletteOffset + 2];
-        outRGBA[rgbaOffset + 3] = m_palette[paletteOffset + 3];
+        PaletteExpand::expandRow(indices, x1 - x0, table, rgba + (size_t(y) * m_width + x0) * 4);
     }
 }
 
@@ -131,8 +322,9 @@ bool SpriteData::saveSprite(const std::string& filename) const {
     file.write(reinterpret_cast<const char*>(&m_height), sizeof(int));
 
     // Write pixel data
+    uint8_t scratch[MAX_SPRITE_PIXELS];
     int numPixels = m_width * m_height;
-    file.write(reinterpret_cast<const char*>(m_pixels), numPixels);
+    file.write(reinterpret_cast<const char*>(getUnpackedPixels(scratch)), numPixels);
 
     // Write palette
     file.write(reinterpret_cast<const char*>(m_palette), PALETTE_BYTES);
@@ -162,19 +354,17 @@ bool SpriteData::loadSprite(const std::string& filename) {
     int width, height;
     file.read(reinterpret_cast<char*>(&width), sizeof(int));
     file.read(reinterpret_cast<char*>(&height), sizeof(int));
+    if (!file || width < 1 || height < 1 || width > MAX_SPRITE_SIZE || height > MAX_SPRITE_SIZE) {
+        return false;
+    }
 
-    // Update sprite size
-    m_width = width;
-    m_height = height;
-
-    // Read pixels
-    int numPixels = m_width * m_height;
-    file.read(reinterpret_cast<char*>(m_pixels), numPixels);
-
-    // Read palette
-    file.read(reinterpret_cast<char*>(m_palette), PALETTE_BYTES);
+    // Read pixels and palette
+    uint8_t pixels[MAX_SPRITE_PIXELS];
+    uint8_t palette[PALETTE_BYTES];
+    file.read(reinterpret_cast<char*>(pixels), width * height);
+    file.read(reinterpret_cast<char*>(palette), PALETTE_BYTES);
 
-    return file.good();
+    return file.good() && commitLoadedSprite(width, height, pixels, palette);
 }
 
 bool SpriteData::savePalette(const std::string& filename) const {
@@ -215,56 +405,74 @@ bool SpriteData::loadPalette(const std::string& filename) {
 
     // Read palette
     file.read(reinterpret_cast<char*>(m_palette), PALETTE_BYTES);
+    m_paletteDirty = true;
+    m_generation = nextGeneration();
 
     return file.good();
 }
 
 bool SpriteData::saveSPRTZ(const std::string& filename) const {
-    return SpriteCompression::saveSPRTZ(filename, m_width, m_height, m_pixels, m_palette);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return SpriteCompression::saveSPRTZ(filename, m_width, m_height, getUnpackedPixels(scratch), m_palette);
 }
 
 bool SpriteData::loadSPRTZ(const std::string& filename) {
-    uint8_t tempPixels[MAX_SPRITE_PIXELS];
-    uint8_t tempPalette[PALETTE_BYTES];
+    // Decode into locals so a corrupt file leaves the sprite untouched
     int width, height;
-
-    if (!SpriteCompression::loadSPRTZ(filename, width, height, tempPixels, tempPalette)) {
-        return false;
-    }
-
-    // Update sprite data
-    m_width = width;
-    m_height = height;
-    std::memcpy(m_pixels, tempPixels, MAX_SPRITE_PIXELS);
-    std::memcpy(m_palette, tempPalette, PALETTE_BYTES);
-
-    return true;
+    uint8_t pixels[MAX_SPRITE_PIXELS];
+    uint8_t palette[PALETTE_BYTES];
+    return SpriteCompression::loadSPRTZ(filename, width, height, pixels, palette) &&
+           commitLoadedSprite(width, height, pixels, palette);
 }
 
 bool SpriteData::saveSPRTZv2Standard(const std::string& filename, uint8_t standardPaletteID) const {
-    return SpriteCompression::saveSPRTZv2Standard(filename, m_width, m_height, m_pixels, standardPaletteID);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return SpriteCompression::saveSPRTZv2Standard(filename, m_width, m_height, getUnpackedPixels(scratch), standardPaletteID);
 }
 
 bool SpriteData::saveSPRTZv2Custom(const std::string& filename) const {
-    return SpriteCompression::saveSPRTZv2Custom(filename, m_width, m_height, m_pixels, m_palette);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return SpriteCompression::saveSPRTZv2Custom(filename, m_width, m_height, getUnpackedPixels(scratch), m_palette);
 }
 
 bool SpriteData::loadSPRTZv2(const std::string& filename, bool& outIsStandard, uint8_t& outPaletteID) {
-    uint8_t tempPixels[MAX_SPRITE_PIXELS];
-    uint8_t tempPalette[PALETTE_BYTES];
     int width, height;
+    uint8_t pixels[MAX_SPRITE_PIXELS];
+    uint8_t palette[PALETTE_BYTES];
+    return SpriteCompression::loadSPRTZv2(filename, width, height, pixels, palette, outIsStandard, outPaletteID) &&
+           commitLoadedSprite(width, height, pixels, palette);
+}
+
+bool SpriteData::saveSPRTZv3Standard(const std::string& filename, uint8_t standardPaletteID, SPRTZCodec codec) const {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return SpriteCompression::saveSPRTZv3Standard(filename, m_width, m_height, getUnpackedPixels(scratch),
+                                                  standardPaletteID, codec);
+}
+
+bool SpriteData::saveSPRTZv3Custom(const std::string& filename, SPRTZCodec codec) const {
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    return SpriteCompression::saveSPRTZv3Custom(filename, m_width, m_height, getUnpackedPixels(scratch),
+                                                m_palette, codec);
+}
 
-    if (!SpriteCompression::loadSPRTZv2(filename, width, height, tempPixels, tempPalette, outIsStandard, outPaletteID)) {
+bool SpriteData::loadFromBank(const SpriteBankReader& bank, uint32_t index, bool& outIsStandard, uint8_t& outPaletteID) {
+    int width, height;
+    uint8_t pixels[MAX_SPRITE_PIXELS];
+    uint8_t palette[PALETTE_BYTES];
+    return bank.decodeEntry(index, width, height, pixels, palette, outIsStandard, outPaletteID) &&
+           commitLoadedSprite(width, height, pixels, palette);
+}
+
+bool SpriteData::loadFromBank(const SpriteBankReader& bank, const std::string& name, bool& outIsStandard, uint8_t& outPaletteID) {
+    int index = bank.findEntry(name);
+    if (index < 0) {
         return false;
     }
+    return loadFromBank(bank, static_cast<uint32_t>(index), outIsStandard, outPaletteID);
+}
 
-    // Update sprite data
-    m_width = width;
-    m_height = height;
-    std::memcpy(m_pixels, tempPixels, MAX_SPRITE_PIXELS);
-    std::memcpy(m_palette, tempPalette, PALETTE_BYTES);
-
-    return true;
+bool SpriteData::addToBank(SpriteBankWriter& bank, const std::string& name, uint8_t standardPaletteID) const {
+    return bank.addSprite(name, *this, standardPaletteID);
 }
 
 bool SpriteData::importPNG(const std::string& filename, int maxWidth, int maxHeight) {
@@ -276,42 +484,251 @@ bool SpriteData::importPNG(const std::string& filename, int maxWidth, int maxHei
         return false;
     }
 
-    // Update sprite data
-    m_width = width;
-    m_height = height;
-    std::memcpy(m_pixels, pixels, MAX_SPRITE_PIXELS);
-    std::memcpy(m_palette, palette, PALETTE_BYTES);
-
-    return true;
+    return commitLoadedSprite(width, height, pixels, palette);
 }
 
 bool SpriteData::exportPNG(const std::string& filename, int scale) const {
-    return PNGConverter::exportPNG(filename, m_width, m_height, m_pixels, m_palette, scale);
+    if (scale > SpriteScale::MAX_SCALE) {
+        // Beyond the cache's range: expand row by row straight into the encoder
+        uint8_t scratch[MAX_SPRITE_PIXELS];
+        return PNGConverter::exportPNG(filename, m_width, m_height, getUnpackedPixels(scratch), m_palette, scale);
+    }
+
+    // Unchanged sprites reuse the cached image and only pay for the PNG encode
+    ScaledSpriteCache::Image image = ScaledSpriteCache::shared().get(*this, scale);
+    return image && PNGConverter::savePNGFile(filename, image->data(), m_width * scale, m_height * scale);
+}
+
+bool SpriteData::exportPNGScales(const std::string& filename, const std::vector<int>& scales) const {
+    // Cacheable scales come from one expansion; larger ones are exported directly
+    std::vector<int> cachedScales;
+    for (int scale : scales) {
+        if (scale < 1) {
+            return false;
+        }
+        if (scale <= SpriteScale::MAX_SCALE) {
+            cachedScales.push_back(scale);
+        }
+    }
+    std::vector<ScaledSpriteCache::Image> images(cachedScales.size());
+    if (!ScaledSpriteCache::shared().get(*this, cachedScales.data(), static_cast<int>(cachedScales.size()),
+                                         images.data())) {
+        return false;
+    }
+
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        dot = filename.size();
+    }
+    bool ok = true;
+    size_t cached = 0;
+    for (size_t i = 0; i < scales.size(); i++) {
+        std::string path = scales[i] == 1 ? filename
+            : filename.substr(0, dot) + "@" + std::to_string(scales[i]) + "x" + filename.substr(dot);
+        if (scales[i] <= SpriteScale::MAX_SCALE) {
+            ok = PNGConverter::savePNGFile(path, images[cached++]->data(), m_width * scales[i], m_height * scales[i]) && ok;
+        } else {
+            ok = exportPNG(path, scales[i]) && ok;
+        }
+    }
+    return ok;
 }
 
 // =============================================================================
 // PNG Import Pipeline - Discrete Steps
 // =============================================================================
 
-bool SpriteData::startPNGImport(const std::string& filename, int targetWidth, int targetHeight) {
-    printf("\n========================================\n");
-    printf("PNG IMPORT PIPELINE START\n");
-    printf("========================================\n");
+namespace {
+
+/// Inclusive bounds of the non-transparent pixels of an import source
+struct ImportBounds {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+/// Import steps B and C in one pass: quantize RGB to 4 bits, turn pixels of the
+/// background color (quantized top-left pixel) fully transparent, and find the
+/// bounds of what is left. Pixels are little-endian 0xAABBGGRR words here.
+///
+/// A keyed pixel keeps its quantized RGB and parks its original alpha in the
+/// low nibbles of R (high alpha nibble) and G (low alpha nibble), which
+/// quantizing leaves free. Everything downstream ignores those bits, and
+/// unkeyImport uses them to undo the keying without a copy of the source.
+/// @param dst Output pixels (may be src)
+/// @return Number of pixels keyed out; bounds.right < bounds.left if nothing is left
+int quantizeKeyAndBound(const uint8_t* src, uint8_t* dst, int width, int height, ImportBounds& bounds) {
+    const uint32_t quantizeMask = 0xFFF0F0F0u;
+    const uint32_t rgbMask = 0x00FFFFFFu;
+    uint32_t first;
+    std::memcpy(&first, src, 4);
+    const uint32_t background = first & quantizeMask & rgbMask;
+
+    int keyed = 0;
+    int left = width;
+    int right = -1;
+    int top = -1;
+    int bottom = -1;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* in = src + size_t(y) * width * 4;
+        uint8_t* out = dst + size_t(y) * width * 4;
+        int rowFirst = -1;
+        int rowLast = -1;
+        int x = 0;
+#if defined(SPRED_IMPORT_SSE2)
+        const __m128i quantize = _mm_set1_epi32(static_cast<int>(quantizeMask));
+        const __m128i rgb = _mm_set1_epi32(static_cast<int>(rgbMask));
+        const __m128i key = _mm_set1_epi32(static_cast<int>(background));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaLow = _mm_set1_epi32(0xF00);
+        for (; x + 4 <= width; x += 4) {
+            __m128i pixels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4)), quantize);
+            __m128i match = _mm_cmpeq_epi32(_mm_and_si128(pixels, rgb), key);
+            __m128i parked = _mm_or_si128(_mm_srli_epi32(pixels, 28), _mm_and_si128(_mm_srli_epi32(pixels, 16), alphaLow));
+            __m128i keyedPixels = _mm_or_si128(_mm_and_si128(pixels, rgb), parked);
+            pixels = _mm_or_si128(_mm_and_si128(match, keyedPixels), _mm_andnot_si128(match, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), pixels);
+            keyed += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(match)));
+            // Alpha is the top byte: a word is opaque iff it is above 0x00FFFFFF
+            __m128i clear = _mm_cmpeq_epi32(_mm_andnot_si128(rgb, pixels), zero);
+            int opaque = ~_mm_movemask_ps(_mm_castsi128_ps(clear)) & 0xF;
+            if (opaque) {
+                if (rowFirst < 0) {
+                    rowFirst = x + __builtin_ctz(opaque);
+                }
+                rowLast = x + 31 - __builtin_clz(opaque);
+            }
+        }
+#elif defined(SPRED_IMPORT_NEON)
+        const uint32x4_t quantize = vdupq_n_u32(quantizeMask);
+        const uint32x4_t rgb = vdupq_n_u32(rgbMask);
+        const uint32x4_t key = vdupq_n_u32(background);
+        const uint32x4_t alphaLow = vdupq_n_u32(0xF00);
+        for (; x + 4 <= width; x += 4) {
+            uint32x4_t pixels = vandq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(in + x * 4)), quantize);
+            uint32x4_t match = vceqq_u32(vandq_u32(pixels, rgb), key);
+            uint32x4_t parked = vorrq_u32(vshrq_n_u32(pixels, 28), vandq_u32(vshrq_n_u32(pixels, 16), alphaLow));
+            pixels = vbslq_u32(match, vorrq_u32(vandq_u32(pixels, rgb), parked), pixels);
+            vst1q_u32(reinterpret_cast<uint32_t*>(out + x * 4), pixels);
+            keyed += static_cast<int>(vaddvq_u32(vshrq_n_u32(match, 31)));
+            // 16 bits per lane: lane i is opaque iff bits [16i, 16i + 16) are set
+            uint64_t opaque = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(vtstq_u32(pixels, vmvnq_u32(rgb)))), 0);
+            if (opaque) {
+                if (rowFirst < 0) {
+                    rowFirst = x + __builtin_ctzll(opaque) / 16;
+                }
+                rowLast = x + (63 - __builtin_clzll(opaque)) / 16;
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            uint32_t pixel;
+            std::memcpy(&pixel, in + x * 4, 4);
+            pixel &= quantizeMask;
+            if ((pixel & rgbMask) == background) {
+                pixel = (pixel & rgbMask) | (pixel >> 28) | ((pixel >> 16) & 0xF00);
+                keyed++;
+            }
+            std::memcpy(out + x * 4, &pixel, 4);
+            if (pixel & ~rgbMask) {
+                if (rowFirst < 0) {
+                    rowFirst = x;
+                }
+                rowLast = x;
+            }
+        }
 
-    // STEP 0: Load PNG at full resolution
-    printf("[Step 0] Loading source PNG...\n");
+        if (rowFirst >= 0) {
+            left = std::min(left, rowFirst);
+            right = std::max(right, rowLast);
+            if (top < 0) {
+                top = y;
+            }
+            bottom = y;
+        }
+    }
+
+    if (top < 0) {
+        bounds = {0, 0, -1, -1};
+    } else {
+        bounds = {left, top, right, bottom};
+    }
+    return keyed;
+}
+
+/// Undo quantizeKeyAndBound's keying of one background color, restoring each
+/// keyed pixel's alpha from its parked nibbles; the pixels stay quantized
+void unkeyImport(uint8_t* rgba, size_t pixelCount, uint32_t key) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint32_t pixel;
+        std::memcpy(&pixel, rgba + i * 4, 4);
+        // Every pixel of the key color was keyed, so alpha 0 plus the key means keyed
+        if ((pixel >> 24) == 0 && (pixel & 0x00F0F0F0u) == key) {
+            uint32_t alpha = ((pixel & 0xF) << 4) | ((pixel >> 8) & 0xF);
+            pixel = (pixel & 0x00F0F0F0u) | (alpha << 24);
+            std::memcpy(rgba + i * 4, &pixel, 4);
+        }
+    }
+}
+
+/// Quantized RGB of one pixel, as compared by quantizeKeyAndBound
+uint32_t importKeyOf(const uint8_t* pixel) {
+    return uint32_t(pixel[0] & 0xF0) | (uint32_t(pixel[1] & 0xF0) << 8) | (uint32_t(pixel[2] & 0xF0) << 16);
+}
+
+/// True if no pixel of row y in [x0, x1] has non-zero alpha
+bool importRowEmpty(const uint8_t* rgba, int width, int y, int x0, int x1) {
+    const uint8_t* pixel = rgba + (size_t(y) * width + x0) * 4;
+    for (int x = x0; x <= x1; x++, pixel += 4) {
+        if (pixel[3] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// True if no pixel of column x in [y0, y1] has non-zero alpha
+bool importColumnEmpty(const uint8_t* rgba, int width, int x, int y0, int y1) {
+    for (int y = y0; y <= y1; y++) {
+        if (rgba[(size_t(y) * width + x) * 4 + 3] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Keep the [left, left + newWidth) × [top, top + newHeight) window of an RGBA
+/// buffer, moving rows down in place
+void cropRGBAInPlace(std::vector<uint8_t>& rgba, int width, int left, int top, int newWidth, int newHeight) {
+    for (int y = 0; y < newHeight; y++) {
+        std::memmove(rgba.data() + size_t(y) * newWidth * 4,
+                     rgba.data() + (size_t(top + y) * width + left) * 4, size_t(newWidth) * 4);
+    }
+    rgba.resize(size_t(newWidth) * newHeight * 4);
+}
+
+} // anonymous namespace
+
+bool SpriteData::startPNGImport(const std::string& filename, int targetWidth, int targetHeight) {
+    // STEP (a): Load PNG at full resolution
+    SPRED_TRACE_SCOPE(stepA, TraceStage::ImportLoad);
     std::vector<uint8_t> rgba;
     int pngWidth, pngHeight;
 
     if (!PNGConverter::loadPNGFile(filename, rgba, pngWidth, pngHeight)) {
-        printf("[Step 0] ERROR: Failed to load PNG file\n");
+        SPRED_TRACE_LOG("[Step A] ERROR: Failed to load PNG file: %s\n", filename.c_str());
         return false;
     }
-    printf("[Step 0] ✓ Loaded source PNG: %dx%d (%zu bytes)\n",
-           pngWidth, pngHeight, rgba.size());
-
-    // Store the PNG data
-    m_importedPNGData = rgba;
+    SPRED_TRACE_BYTES(stepA, 0, rgba.size());
+    SPRED_TRACE_END(stepA);
+    SPRED_TRACE_LOG("[Step A] Loaded source PNG: %dx%d (%zu bytes)\n",
+                    pngWidth, pngHeight, rgba.size());
+
+    // Store the PNG data; steps B/C run in place on the first resample
+    m_importedPNGData = std::move(rgba);
+    m_importPrepared = false;
     m_importedPNGWidth = pngWidth;
     m_importedPNGHeight = pngHeight;
     m_pngOffsetX = 0;
@@ -346,14 +763,12 @@ bool SpriteData::startPNGImport(const std::string& filename, int targetWidth, in
     m_pngTargetWidth = actualWidth;
     m_pngTargetHeight = actualHeight;
 
-    printf("[Step 0] Calculated target sprite size: %dx%d (preserves aspect ratio)\n",
-           actualWidth, actualHeight);
+    SPRED_TRACE_LOG("[Step A] Target sprite size: %dx%d (preserves aspect ratio)\n",
+                    actualWidth, actualHeight);
 
     // Resize sprite to calculated size
     resize(actualWidth, actualHeight);
 
-    printf("[Step 0] Sprite dimensions set: m_width=%d, m_height=%d\n", m_width, m_height);
-
     // Do initial resample at offset (0, 0)
     return resamplePNGAtOffset();
 }
@@ -371,8 +786,8 @@ void SpriteData::shiftPNGImportOffset(int dx, int dy) {
     int pngDx = static_cast<int>(dx * scaleX);
     int pngDy = static_cast<int>(dy * scaleY);
 
-    printf("[PNG Shift] (%d,%d) sprite space = (%d,%d) PNG space (scale %.2fx%.2f)\n",
-           dx, dy, pngDx, pngDy, scaleX, scaleY);
+    SPRED_TRACE_LOG("[PNG Shift] (%d,%d) sprite space = (%d,%d) PNG space (scale %.2fx%.2f)\n",
+                    dx, dy, pngDx, pngDy, scaleX, scaleY);
 
     // Update offset
     m_pngOffsetX += pngDx;
@@ -403,40 +818,63 @@ void SpriteData::trimPNGImport(int left, int right, int top, int bottom) {
     int newWidth = m_importedPNGWidth - left - right;
     int newHeight = m_importedPNGHeight - top - bottom;
 
-    if (newWidth < 1 || newHeight < 1) {
-        printf("[Trim] ERROR: Trimming would result in invalid dimensions\n");
+    if (left < 0 || right < 0 || top < 0 || bottom < 0 || newWidth < 1 || newHeight < 1) {
+        SPRED_TRACE_LOG("[Trim] ERROR: Trimming would result in invalid dimensions\n");
         return;
     }
 
-    // Create trimmed image
-    std::vector<uint8_t> trimmedRGBA(newWidth * newHeight * 4);
+    // Trim the source (and with it the cached steps) in place
+    const int oldWidth = m_importedPNGWidth;
+    const int oldHeight = m_importedPNGHeight;
+    cropRGBAInPlace(m_importedPNGData, oldWidth, left, top, newWidth, newHeight);
+    m_importedPNGWidth = newWidth;
+    m_importedPNGHeight = newHeight;
 
-    for (int y = 0; y < newHeight; y++) {
-        for (int x = 0; x < newWidth; x++) {
-            int srcOffset = ((top + y) * m_importedPNGWidth + (left + x)) * 4;
-            int dstOffset = (y * newWidth + x) * 4;
-            trimmedRGBA[dstOffset + 0] = m_importedPNGData[srcOffset + 0];
-            trimmedRGBA[dstOffset + 1] = m_importedPNGData[srcOffset + 1];
-            trimmedRGBA[dstOffset + 2] = m_importedPNGData[srcOffset + 2];
-            trimmedRGBA[dstOffset + 3] = m_importedPNGData[srcOffset + 3];
+    if (m_importPrepared) {
+        if (importKeyOf(m_importedPNGData.data()) != m_importKey) {
+            // New top-left pixel, new background color: undo the old keying
+            // and let the next resample key again
+            unkeyImport(m_importedPNGData.data(), size_t(newWidth) * newHeight, m_importKey);
+            m_importPrepared = false;
+        } else {
+
+            // Clip the bounds, then shrink them past rows/columns the trim emptied
+            int x0 = std::max(m_importLeft, left) - left;
+            int x1 = std::min(m_importRight, oldWidth - 1 - right) - left;
+            int y0 = std::max(m_importTop, top) - top;
+            int y1 = std::min(m_importBottom, oldHeight - 1 - bottom) - top;
+            const uint8_t* pixels = m_importedPNGData.data();
+            while (y0 <= y1 && x0 <= x1 && importRowEmpty(pixels, newWidth, y0, x0, x1)) y0++;
+            while (y1 >= y0 && x0 <= x1 && importRowEmpty(pixels, newWidth, y1, x0, x1)) y1--;
+            while (x0 <= x1 && y0 <= y1 && importColumnEmpty(pixels, newWidth, x0, y0, y1)) x0++;
+            while (x1 >= x0 && y0 <= y1 && importColumnEmpty(pixels, newWidth, x1, y0, y1)) x1--;
+            if (x0 > x1 || y0 > y1) {
+                x0 = y0 = 0;
+                x1 = y1 = -1;
+            }
+            m_importLeft = x0;
+            m_importTop = y0;
+            m_importRight = x1;
+            m_importBottom = y1;
         }
     }
 
-    // Update imported PNG data
-    m_importedPNGData = trimmedRGBA;
-    m_importedPNGWidth = newWidth;
-    m_importedPNGHeight = newHeight;
-
-    printf("[Trim] Trimmed PNG to %dx%d (removed L:%d R:%d T:%d B:%d)\n",
-           newWidth, newHeight, left, right, top, bottom);
+    SPRED_TRACE_LOG("[Trim] Trimmed PNG to %dx%d (removed L:%d R:%d T:%d B:%d)\n",
+                    newWidth, newHeight, left, right, top, bottom);
 
     // Re-resample
     resamplePNGAtOffset();
 }
 
+void SpriteData::releasePNGImport() {
+    // Swap with an empty vector so the memory is actually returned
+    std::vector<uint8_t>().swap(m_importedPNGData);
+    m_importPrepared = false;
+}
+
 void SpriteData::commitPNGImport() {
     // Clear the PNG data from memory
-    m_importedPNGData.clear();
+    releasePNGImport();
     m_importedPNGWidth = 0;
     m_importedPNGHeight = 0;
     m_pngOffsetX = 0;
@@ -445,12 +883,12 @@ void SpriteData::commitPNGImport() {
     m_pngTargetHeight = 0;
     m_hasPendingImport = false;
 
-    printf("[Commit] PNG import committed, memory cleared\n");
+    SPRED_TRACE_LOG("[Commit] PNG import committed, memory cleared\n");
 }
 
 void SpriteData::cancelPNGImport() {
     // Clear the PNG data and revert sprite
-    m_importedPNGData.clear();
+    releasePNGImport();
     m_importedPNGWidth = 0;
     m_importedPNGHeight = 0;
     m_pngOffsetX = 0;
@@ -462,7 +900,7 @@ void SpriteData::cancelPNGImport() {
     // Clear sprite
     clear();
 
-    printf("[Cancel] PNG import cancelled\n");
+    SPRED_TRACE_LOG("[Cancel] PNG import cancelled\n");
 }
 
 void SpriteData::getPNGImportInfo(int& width, int& height, int& offsetX, int& offsetY) const {
@@ -472,182 +910,94 @@ void SpriteData::getPNGImportInfo(int& width, int& height, int& offsetX, int& of
     offsetY = m_pngOffsetY;
 }
 
+void SpriteData::preparePNGImport() {
+    // =============================================================================
+    // STEP (b): QUANTIZE original PNG to 16 colors AND convert background to transparent
+    // STEP (c): find the CROP bounds of what is left
+    // One fused pass, in place over the source; nudges and trims reuse the result
+    // =============================================================================
+    SPRED_TRACE_SCOPE(stepB, TraceStage::ImportQuantize);
+
+    ImportBounds bounds;
+    m_importKey = importKeyOf(m_importedPNGData.data());
+    [[maybe_unused]] int transparentCount =
+        quantizeKeyAndBound(m_importedPNGData.data(), m_importedPNGData.data(),
+                            m_importedPNGWidth, m_importedPNGHeight, bounds);
+    m_importPrepared = true;
+    m_importLeft = bounds.left;
+    m_importTop = bounds.top;
+    m_importRight = bounds.right;
+    m_importBottom = bounds.bottom;
+
+    SPRED_TRACE_BYTES(stepB, m_importedPNGData.size(), m_importedPNGData.size());
+    SPRED_TRACE_END(stepB);
+    SPRED_TRACE_LOG("[Step B] Quantized %zu pixels, keyed RGB=(%d,%d,%d), made %d pixels transparent\n",
+                    m_importedPNGData.size() / 4, m_importKey & 0xFF, (m_importKey >> 8) & 0xFF,
+                    (m_importKey >> 16) & 0xFF, transparentCount);
+}
+
 bool SpriteData::resamplePNGAtOffset() {
     if (!m_hasPendingImport || m_importedPNGData.empty()) {
         return false;
     }
 
-    printf("\n========================================\n");
-    printf("PNG IMPORT PIPELINE - NEW ORDER\n");
-    printf("========================================\n");
-    printf("Source PNG: %dx%d\n", m_importedPNGWidth, m_importedPNGHeight);
-    printf("Target Sprite: %dx%d\n", m_pngTargetWidth, m_pngTargetHeight);
+    SPRED_TRACE_LOG("[Import] Resample %dx%d source -> %dx%d sprite\n",
+                    m_importedPNGWidth, m_importedPNGHeight, m_pngTargetWidth, m_pngTargetHeight);
 
     // =============================================================================
     // STEP (a): LOAD PNG (already done in startPNGImport)
     // =============================================================================
-    printf("\n[Step A] LOAD PNG\n");
-    printf("[Step A] ✓ Already loaded: %dx%d\n", m_importedPNGWidth, m_importedPNGHeight);
 
     // =============================================================================
-    // STEP (b): QUANTIZE original PNG to 16 colors AND convert background to transparent
+    // STEPS (b) and (c): cached; see preparePNGImport
     // =============================================================================
-    printf("\n[Step B] QUANTIZE and convert background to transparent\n");
-
-    std::vector<uint8_t> quantizedSource = m_importedPNGData;
-
-    // First quantize
-    for (size_t i = 0; i < quantizedSource.size(); i += 4) {
-        quantizedSource[i+0] = (quantizedSource[i+0] >> 4) << 4;  // R
-        quantizedSource[i+1] = (quantizedSource[i+1] >> 4) << 4;  // G
-        quantizedSource[i+2] = (quantizedSource[i+2] >> 4) << 4;  // B
-        // Alpha unchanged
+    if (!m_importPrepared) {
+        preparePNGImport();
     }
 
-    // Use top-left pixel as background color to convert to transparent
-    uint8_t bgR = quantizedSource[0];
-    uint8_t bgG = quantizedSource[1];
-    uint8_t bgB = quantizedSource[2];
-
-    printf("[Step B] Background color to make transparent: RGB=(%d,%d,%d)\n", bgR, bgG, bgB);
-
-    // Convert all background pixels to transparent
-    int transparentCount = 0;
-    for (size_t i = 0; i < quantizedSource.size(); i += 4) {
-        if (quantizedSource[i+0] == bgR &&
-            quantizedSource[i+1] == bgG &&
-            quantizedSource[i+2] == bgB) {
-            quantizedSource[i+0] = 0;
-            quantizedSource[i+1] = 0;
-            quantizedSource[i+2] = 0;
-            quantizedSource[i+3] = 0;  // Transparent
-            transparentCount++;
-        }
-    }
+    SPRED_TRACE_SCOPE(stepC, TraceStage::ImportCrop);
 
-    printf("[Step B] ✓ Quantized %zu pixels, made %d pixels transparent\n",
-           quantizedSource.size() / 4, transparentCount);
-
-    // =============================================================================
-    // STEP (c): CROP away transparent border pixels
-    // =============================================================================
-    printf("\n[Step C] CROP transparent borders\n");
-
-    int cropLeft = 0, cropRight = m_importedPNGWidth - 1;
-    int cropTop = 0, cropBottom = m_importedPNGHeight - 1;
-
-    // Find left border (look for non-transparent pixels)
-    for (int x = 0; x < m_importedPNGWidth; x++) {
-        bool hasContent = false;
-        for (int y = 0; y < m_importedPNGHeight; y++) {
-            int offset = (y * m_importedPNGWidth + x) * 4;
-            if (quantizedSource[offset+3] != 0) {  // Not transparent
-                hasContent = true;
-                break;
-            }
-        }
-        if (hasContent) {
-            cropLeft = x;
-            break;
-        }
-    }
-
-    // Find right border
-    for (int x = m_importedPNGWidth - 1; x >= cropLeft; x--) {
-        bool hasContent = false;
-        for (int y = 0; y < m_importedPNGHeight; y++) {
-            int offset = (y * m_importedPNGWidth + x) * 4;
-            if (quantizedSource[offset+3] != 0) {  // Not transparent
-                hasContent = true;
-                break;
-            }
-        }
-        if (hasContent) {
-            cropRight = x;
-            break;
-        }
-    }
-
-    // Find top border
-    for (int y = 0; y < m_importedPNGHeight; y++) {
-        bool hasContent = false;
-        for (int x = 0; x < m_importedPNGWidth; x++) {
-            int offset = (y * m_importedPNGWidth + x) * 4;
-            if (quantizedSource[offset+3] != 0) {  // Not transparent
-                hasContent = true;
-                break;
-            }
-        }
-        if (hasContent) {
-            cropTop = y;
-            break;
-        }
-    }
-
-    // Find bottom border
-    for (int y = m_importedPNGHeight - 1; y >= cropTop; y--) {
-        bool hasContent = false;
-        for (int x = 0; x < m_importedPNGWidth; x++) {
-            int offset = (y * m_importedPNGWidth + x) * 4;
-            if (quantizedSource[offset+3] != 0) {  // Not transparent
-                hasContent = true;
-                break;
-            }
-        }
-        if (hasContent) {
-            cropBottom = y;
-            break;
-        }
-    }
+    // The crop is a view into the cached buffer; nothing left after keying keeps the whole image
+    const bool empty = m_importRight < m_importLeft;
+    const int cropLeft = empty ? 0 : m_importLeft;
+    const int cropTop = empty ? 0 : m_importTop;
+    const int croppedWidth = empty ? m_importedPNGWidth : m_importRight - m_importLeft + 1;
+    const int croppedHeight = empty ? m_importedPNGHeight : m_importBottom - m_importTop + 1;
+    const size_t sourceStride = size_t(m_importedPNGWidth) * 4;
+    const uint8_t* croppedRGBA = m_importedPNGData.data() + size_t(cropTop) * sourceStride + size_t(cropLeft) * 4;
 
-    int croppedWidth = cropRight - cropLeft + 1;
-    int croppedHeight = cropBottom - cropTop + 1;
-
-    printf("[Step C] Crop bounds: Left=%d, Right=%d, Top=%d, Bottom=%d\n",
-           cropLeft, cropRight, cropTop, cropBottom);
-    printf("[Step C] Cropped size: %dx%d (removed %d cols, %d rows)\n",
-           croppedWidth, croppedHeight,
-           m_importedPNGWidth - croppedWidth, m_importedPNGHeight - croppedHeight);
-
-    // Create cropped image
-    std::vector<uint8_t> croppedRGBA(croppedWidth * croppedHeight * 4);
-    for (int y = 0; y < croppedHeight; y++) {
-        for (int x = 0; x < croppedWidth; x++) {
-            int srcOffset = ((cropTop + y) * m_importedPNGWidth + (cropLeft + x)) * 4;
-            int dstOffset = (y * croppedWidth + x) * 4;
-            croppedRGBA[dstOffset + 0] = quantizedSource[srcOffset + 0];
-            croppedRGBA[dstOffset + 1] = quantizedSource[srcOffset + 1];
-            croppedRGBA[dstOffset + 2] = quantizedSource[srcOffset + 2];
-            croppedRGBA[dstOffset + 3] = quantizedSource[srcOffset + 3];
-        }
-    }
+    SPRED_TRACE_END(stepC);
+    SPRED_TRACE_LOG("[Step C] Crop bounds L=%d R=%d T=%d B=%d -> %dx%d\n",
+                    cropLeft, cropLeft + croppedWidth - 1, cropTop, cropTop + croppedHeight - 1,
+                    croppedWidth, croppedHeight);
 
     // =============================================================================
     // STEP (d): RESIZE cropped image to target dimensions (keeps transparency)
     // =============================================================================
-    printf("\n[Step D] RESIZE %dx%d -> %dx%d\n",
-           croppedWidth, croppedHeight, m_pngTargetWidth, m_pngTargetHeight);
+    SPRED_TRACE_SCOPE(stepD, TraceStage::ImportResize);
 
     std::vector<uint8_t> resizedRGBA;
 
-    if (!PNGConverter::resizePNG(croppedRGBA.data(),
-                                  croppedWidth, croppedHeight,
-                                  0, 0,
-                                  m_pngTargetWidth, m_pngTargetHeight,
-                                  resizedRGBA,
-                                  PNGScalingMethod::vImage)) {
-        printf("[Step D] ✗ ERROR: Resize failed!\n");
+    // Area averaging: a box filter is the right choice for shrinking to sprite
+    // size, and it is the one method available on every platform
+    if (!PNGConverter::resizeRegion_AreaAverage(croppedRGBA, sourceStride,
+                                                croppedWidth, croppedHeight,
+                                                m_pngTargetWidth, m_pngTargetHeight,
+                                                resizedRGBA)) {
+        SPRED_TRACE_LOG("[Step D] ERROR: Resize %dx%d -> %dx%d failed\n",
+                        croppedWidth, croppedHeight, m_pngTargetWidth, m_pngTargetHeight);
         return false;
     }
 
-    printf("[Step D] ✓ Resized to %dx%d\n", m_pngTargetWidth, m_pngTargetHeight);
+    SPRED_TRACE_BYTES(stepD, size_t(croppedWidth) * croppedHeight * 4, resizedRGBA.size());
+    SPRED_TRACE_END(stepD);
 
     // =============================================================================
-    // STEP (e): QUANTIZE resized image again
+    // STEP (e): QUANTIZE resized image again (in place)
     // =============================================================================
-    printf("\n[Step E] QUANTIZE resized image (4 bits/channel)\n");
+    SPRED_TRACE_SCOPE(stepE, TraceStage::ImportRequantize);
 
-    std::vector<uint8_t> quantizedRGBA = resizedRGBA;
+    std::vector<uint8_t>& quantizedRGBA = resizedRGBA;
     for (size_t i = 0; i < quantizedRGBA.size(); i += 4) {
         quantizedRGBA[i+0] = (quantizedRGBA[i+0] >> 4) << 4;  // R
         quantizedRGBA[i+1] = (quantizedRGBA[i+1] >> 4) << 4;  // G
@@ -655,27 +1005,19 @@ bool SpriteData::resamplePNGAtOffset() {
         // Alpha unchanged
     }
 
-    printf("[Step E] ✓ Quantized %zu pixels\n", quantizedRGBA.size() / 4);
+    SPRED_TRACE_BYTES(stepE, quantizedRGBA.size(), quantizedRGBA.size());
+    SPRED_TRACE_END(stepE);
 
     // =============================================================================
     // STEP (f): MATCH PALETTE (extract 14 colors)
     // =============================================================================
-    printf("\n[Step F] PALETTE EXTRACTION (14 colors)\n");
+    SPRED_TRACE_SCOPE(stepF, TraceStage::ImportPalette);
 
     std::vector<Color> extractedColors;
     PNGConverter::extractPalette(quantizedRGBA.data(),
                                   m_pngTargetWidth * m_pngTargetHeight,
                                   14, extractedColors);
 
-    printf("[Step F] ✓ Extracted %zu colors:\n", extractedColors.size());
-    for (size_t i = 0; i < std::min(size_t(5), extractedColors.size()); i++) {
-        printf("  Color[%zu]: RGB=(%d,%d,%d)\n", i,
-               extractedColors[i].r, extractedColors[i].g, extractedColors[i].b);
-    }
-    if (extractedColors.size() > 5) {
-        printf("  ... (%zu more colors)\n", extractedColors.size() - 5);
-    }
-
     // Build final 16-color palette
     setPaletteColor(0, 0, 0, 0, 0);         // Index 0: Transparent
     setPaletteColor(1, 0, 0, 0, 255);       // Index 1: Opaque black
@@ -689,70 +1031,71 @@ bool SpriteData::resamplePNGAtOffset() {
         }
     }
 
-    printf("[Step F] ✓ Built 16-color palette\n");
+    SPRED_TRACE_BYTES(stepF, quantizedRGBA.size(), PALETTE_BYTES);
+    SPRED_TRACE_END(stepF);
+    SPRED_TRACE_LOG("[Step F] Extracted %zu colors\n", extractedColors.size());
 
     // =============================================================================
     // STEP (g): CONVERT TO SPRITE FORMAT (indexed pixels)
     // =============================================================================
-    printf("\n[Step G] CONVERT to sprite format (indexed pixels)\n");
+    SPRED_TRACE_SCOPE(stepG, TraceStage::ImportConvert);
 
     // CRITICAL: Verify dimensions match before mapping
-    printf("[Step G] DIMENSION CHECK:\n");
-    printf("  m_width = %d, m_height = %d (sprite dimensions)\n", m_width, m_height);
-    printf("  m_pngTargetWidth = %d, m_pngTargetHeight = %d (import target)\n",
-           m_pngTargetWidth, m_pngTargetHeight);
-
     if (m_width != m_pngTargetWidth || m_height != m_pngTargetHeight) {
-        printf("[Step G] ✗✗✗ CRITICAL ERROR: DIMENSION MISMATCH!\n");
-        printf("[Step G] This will cause clipping! Synchronizing dimensions...\n");
+        SPRED_TRACE_LOG("[Step G] Dimension mismatch: sprite %dx%d, import target %dx%d; synchronizing\n",
+                        m_width, m_height, m_pngTargetWidth, m_pngTargetHeight);
         m_width = m_pngTargetWidth;
         m_height = m_pngTargetHeight;
-        printf("[Step G] ✓ Synchronized: m_width=%d, m_height=%d\n", m_width, m_height);
-    } else {
-        printf("[Step G] ✓ Dimensions match correctly\n");
+        markAllDirty();
     }
 
-    // Map pixels to palette using 2D coordinates (prevents stride mismatch)
-    int pixelsMapped = 0;
+    // One table build per palette, then one lookup per pixel. The table gives
+    // the same index as PNGConverter::findClosestColor on quantized pixels:
+    // transparent -> 0, otherwise 2 + the nearest extracted color.
+    PaletteMapper mapper;
+    mapper.build(extractedColors, 2);
+
+    const int pixelsMapped = m_width * m_height;
+    uint8_t mapped[MAX_SPRITE_PIXELS];
+    mapper.map(quantizedRGBA.data(), pixelsMapped, mapped);
+
+    // Store the indices and mark only the pixels that changed, as setPixel would
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    const uint8_t* current = getUnpackedPixels(scratch);
+    int changedX0 = m_width, changedY0 = m_height, changedX1 = 0, changedY1 = 0;
     for (int y = 0; y < m_height; y++) {
         for (int x = 0; x < m_width; x++) {
             int linearIdx = y * m_width + x;
-            int offset = linearIdx * 4;
-
-            Color pixel(quantizedRGBA[offset + 0], quantizedRGBA[offset + 1],
-                       quantizedRGBA[offset + 2], quantizedRGBA[offset + 3]);
-
-            int paletteIdx = PNGConverter::findClosestColor(pixel, extractedColors);
-
-            // Use setPixel to ensure proper 2D mapping
-            setPixel(x, y, static_cast<uint8_t>(paletteIdx));
-            pixelsMapped++;
+            if (mapped[linearIdx] >= PALETTE_SIZE) {
+                mapped[linearIdx] = 0;
+            }
+            if (mapped[linearIdx] != current[linearIdx]) {
+                changedX0 = std::min(changedX0, x);
+                changedY0 = std::min(changedY0, y);
+                changedX1 = std::max(changedX1, x + 1);
+                changedY1 = std::max(changedY1, y + 1);
+            }
         }
     }
+    if (changedX0 < changedX1) {
+        if (m_layout == PixelLayout::Packed) {
+            NibblePacking::pack(mapped, m_pixels, pixelsMapped);
+        } else {
+            std::memcpy(m_pixels, mapped, pixelsMapped);
+        }
+        markPixelsDirty(changedX0, changedY0, changedX1, changedY1);
+    }
 
-    printf("[Step G] ✓ Mapped %d pixels to palette indices\n", pixelsMapped);
-
-    // Verify rightmost column was mapped correctly
-    printf("[Step G] Verification - rightmost column (x=%d):\n", m_width-1);
-    for (int y = 0; y < std::min(3, m_height); y++) {
-        uint8_t idx = getPixel(m_width-1, y);
-        uint8_t r, g, b, a;
-        getPaletteColor(idx, r, g, b, a);
-        printf("  [%d,%d]: index=%d, RGB=(%d,%d,%d)\n",
-               m_width-1, y, idx, r, g, b);
-   }
-
-    printf("\n========================================\n");
-    printf("PNG IMPORT PIPELINE COMPLETE\n");
-    printf("========================================\n\n");
+    SPRED_TRACE_BYTES(stepG, quantizedRGBA.size(), pixelsMapped);
+    SPRED_TRACE_END(stepG);
+    SPRED_TRACE_LOG("[Step G] Mapped %d pixels to palette indices\n", pixelsMapped);
 
     return true;
 }
 
 uint8_t SpriteData::findClosestStandardPalette(int* outDistance) const {
-    printf("\n========================================\n");
-    printf("FIND CLOSEST STANDARD PALETTE\n");
-    printf("========================================\n");
+    SPRED_TRACE_SCOPE(trace, TraceStage::PaletteMatch);
+    SPRED_TRACE_BYTES(trace, PALETTE_BYTES, 0);
 
     // Convert current palette to PaletteColor format
     SuperTerminal::PaletteColor customPalette[16];
@@ -766,49 +1109,18 @@ uint8_t SpriteData::findClosestStandardPalette(int* outDistance) const {
         );
     }
 
-    // Print current palette
-    printf("Current custom palette:\n");
-    for (int i = 0; i < 16; i++) {
-        printf("  [%2d] RGBA=(%3d,%3d,%3d,%3d)\n", i,
-               customPalette[i].r, customPalette[i].g,
-               customPalette[i].b, customPalette[i].a);
-    }
-
     // Find closest standard palette
     int32_t distance = 0;
     uint8_t bestPaletteID = SuperTerminal::StandardPaletteLibrary::findClosestPalette(
         customPalette, &distance);
 
     if (bestPaletteID == 0xFF) {
-        printf("No good matching standard palette found\n");
+        SPRED_TRACE_LOG("[Palette Match] No good matching standard palette found\n");
         if (outDistance) *outDistance = -1;
         return 0xFF;
     }
 
-    const char* paletteName = SuperTerminal::StandardPaletteLibrary::getPaletteName(bestPaletteID);
-    const char* paletteDesc = SuperTerminal::StandardPaletteLibrary::getPaletteDescription(bestPaletteID);
-    const char* paletteCategory = SuperTerminal::StandardPaletteLibrary::getPaletteCategory(bestPaletteID);
-
-    printf("\n✓ Found closest match:\n");
-    printf("  ID: %d\n", bestPaletteID);
-    printf("  Name: %s\n", paletteName ? paletteName : "Unknown");
-    printf("  Category: %s\n", paletteCategory ? paletteCategory : "Unknown");
-    printf("  Description: %s\n", paletteDesc ? paletteDesc : "");
-    printf("  Color distance: %d\n", distance);
-
-    // Show the standard palette for comparison
-    const SuperTerminal::PaletteColor* standardPalette =
-        SuperTerminal::StandardPaletteLibrary::getPalette(bestPaletteID);
-
-    if (standardPalette) {
-        printf("\nStandard palette colors:\n");
-        for (int i = 0; i < 16; i++) {
-            printf("  [%2d] RGBA=(%3d,%3d,%3d,%3d)\n", i,
-                   standardPalette[i].r, standardPalette[i].g,
-                   standardPalette[i].b, standardPalette[i].a);
-        }
-    }
-    printf("========================================\n\n");
+    SPRED_TRACE_LOG("[Palette Match] Closest standard palette: %d, distance %d\n", bestPaletteID, distance);
 
     if (outDistance) *outDistance = distance;
     return bestPaletteID;
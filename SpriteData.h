@@ -8,6 +8,8 @@
 #ifndef SPRED_SPRITE_DATA_H
 #define SPRED_SPRITE_DATA_H
 
+#include "SpriteCodecs.h"
+#include "SpriteTransform.h"
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -20,6 +22,35 @@ constexpr int MAX_SPRITE_PIXELS = MAX_SPRITE_SIZE * MAX_SPRITE_SIZE;
 constexpr int PALETTE_SIZE = 16;
 constexpr int PALETTE_BYTES = PALETTE_SIZE * 4; // RGBA
 
+class SpriteBankReader;
+class SpriteBankWriter;
+
+/// In-memory layout of the pixel indices
+enum class PixelLayout {
+    Unpacked,   // One byte per pixel (default)
+    Packed      // Two pixels per byte, see NibblePacking.h
+};
+
+/// Pixel region, in sprite coordinates (empty when width or height is 0)
+struct SpriteDirtyRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool isEmpty() const { return width <= 0 || height <= 0; }
+};
+
+/// What changed in a SpriteData since changes were last consumed
+struct SpriteChanges {
+    uint64_t generation = 0;        // Generation when the changes were read
+    SpriteDirtyRect pixels;         // Bounding box of changed pixels
+    bool paletteChanged = false;    // Any palette color changed (every pixel may look different)
+    bool resized = false;           // Size changed (pixels covers the whole new size)
+
+    bool isEmpty() const { return pixels.isEmpty() && !paletteChanged && !resized; }
+};
+
 /// SpriteData - Manages variable-sized indexed sprite data (8x8, 16x16, 40x40)
 class SpriteData {
 public:
@@ -40,10 +71,30 @@ public:
     void getPaletteColor(int index, uint8_t& r, uint8_t& g, uint8_t& b, uint8_t& a) const;
     void setPaletteColor(int index, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
     
+    // Transforms (in place; 90° rotations of non-square sprites swap width and height)
+    void transform(SpriteOrientation orientation);
+    void flipHorizontal() { transform(SpriteOrientation::FlipHorizontal); }
+    void flipVertical() { transform(SpriteOrientation::FlipVertical); }
+    void rotate90CW() { transform(SpriteOrientation::Rotate90CW); }
+    void rotate90CCW() { transform(SpriteOrientation::Rotate90CCW); }
+    void shift(int dx, int dy);         // Wrapping: shiftLeft is shift(-1, 0)
+    
+    // Pixel layout (packed halves the bytes touched when walking many sprites)
+    void setPixelLayout(PixelLayout layout);
+    PixelLayout getPixelLayout() const { return m_layout; }
+    
     // Get raw data
-    const uint8_t* getPixelData() const { return m_pixels; }
+    // getPixelData returns nullptr in the Packed layout (and getPackedPixelData
+    // in the Unpacked one); code that may see either layout should use
+    // getUnpackedPixels instead
+    const uint8_t* getPixelData() const { return m_layout == PixelLayout::Unpacked ? m_pixels : nullptr; }
+    const uint8_t* getPackedPixelData() const { return m_layout == PixelLayout::Packed ? m_pixels : nullptr; }
     const uint8_t* getPaletteData() const { return m_palette; }
     
+    // Byte-per-pixel indices in either layout
+    // Returns the internal buffer when unpacked, otherwise unpacks into scratch (MAX_SPRITE_PIXELS bytes)
+    const uint8_t* getUnpackedPixels(uint8_t* scratch) const;
+    
     // File operations
     bool saveSprite(const std::string& filename) const;
     bool loadSprite(const std::string& filename);
@@ -59,9 +110,23 @@ public:
     bool saveSPRTZv2Custom(const std::string& filename) const;
     bool loadSPRTZv2(const std::string& filename, bool& outIsStandard, uint8_t& outPaletteID);
     
+    // SPRTZ v3 format (per-sprite codec selection, loaded by loadSPRTZv2)
+    bool saveSPRTZv3Standard(const std::string& filename, uint8_t standardPaletteID,
+                             SPRTZCodec codec = SPRTZCodec::AutoSmallest) const;
+    bool saveSPRTZv3Custom(const std::string& filename, SPRTZCodec codec = SPRTZCodec::AutoSmallest) const;
+    
+    // SPRTB sprite banks (decoded from the mapped bank, no file I/O)
+    bool loadFromBank(const SpriteBankReader& bank, uint32_t index, bool& outIsStandard, uint8_t& outPaletteID);
+    bool loadFromBank(const SpriteBankReader& bank, const std::string& name, bool& outIsStandard, uint8_t& outPaletteID);
+    bool addToBank(SpriteBankWriter& bank, const std::string& name, uint8_t standardPaletteID = 0xFF) const;
+    
     // PNG import/export
     bool importPNG(const std::string& filename, int maxWidth, int maxHeight);
     bool exportPNG(const std::string& filename, int scale = 1) const;
+    // Export several integer scales from one expansion: scale 1 goes to filename,
+    // others to "name@<scale>x.png" (scaled images up to SpriteScale::MAX_SCALE are
+    // cached, see SpriteScale.h; larger scales are expanded directly)
+    bool exportPNGScales(const std::string& filename, const std::vector<int>& scales) const;
     
     // PNG import mode (interactive positioning)
     bool startPNGImport(const std::string& filename, int targetWidth, int targetHeight);
@@ -78,17 +143,30 @@ public:
     // Get RGBA representation for display
     void getRGBAPixels(uint8_t* outRGBA) const;
     
+    // Re-expand only a region of a full-size RGBA image built by getRGBAPixels
+    void updateRGBAPixels(uint8_t* rgba, const SpriteDirtyRect& rect) const;
+    
+    // Change tracking (views and caches re-expand or re-upload only what changed)
+    // Every edit that changes pixels, palette or size takes a new generation from
+    // a process-wide counter, so a (sprite address, generation) pair stays a valid
+    // cache key across copy assignment. Writing a value a pixel or color already
+    // has is not an edit.
+    uint64_t getGeneration() const { return m_generation; }
+    SpriteChanges getChanges() const;
+    SpriteChanges consumeChanges();     // Returns the changes and resets the dirty state
+    
     // Palette operations
     uint8_t findClosestStandardPalette(int* outDistance = nullptr) const;
 
 private:
     int m_width;
     int m_height;
-    uint8_t m_pixels[MAX_SPRITE_PIXELS];    // Up to 1600 bytes (40x40 indexed pixels)
+    uint8_t m_pixels[MAX_SPRITE_PIXELS];    // Up to 1600 bytes (40x40 indexed pixels), first half only when packed
+    PixelLayout m_layout = PixelLayout::Unpacked;
     uint8_t m_palette[PALETTE_BYTES];       // 64 bytes (16 colors × RGBA)
     
     // PNG import state
-    std::vector<uint8_t> m_importedPNGData; // RGBA data of imported PNG
+    std::vector<uint8_t> m_importedPNGData; // RGBA data of imported PNG (quantized and keyed in place by steps B/C)
     int m_importedPNGWidth = 0;
     int m_importedPNGHeight = 0;
     int m_pngOffsetX = 0;                   // Current pan offset
@@ -97,8 +175,32 @@ private:
     int m_pngTargetHeight = 0;
     bool m_hasPendingImport = false;
     
+    // Cached import steps B/C; they do not depend on the pan offset
+    bool m_importPrepared = false;          // m_importedPNGData has been quantized and keyed
+    uint32_t m_importKey = 0;               // Keyed background RGB (quantized, 0x00BBGGRR)
+    int m_importLeft = 0;                   // Bounds of what is left after keying, inclusive;
+    int m_importTop = 0;                    // right < left when nothing is left
+    int m_importRight = -1;
+    int m_importBottom = -1;
+    
+    // Change tracking (dirty box is [x0, x1) × [y0, y1), empty when x0 >= x1)
+    uint64_t m_generation = 0;
+    int m_dirtyX0 = 0;
+    int m_dirtyY0 = 0;
+    int m_dirtyX1 = 0;
+    int m_dirtyY1 = 0;
+    bool m_paletteDirty = false;
+    int m_consumedWidth = 0;                // Size when changes were last consumed
+    int m_consumedHeight = 0;
+    
+    void markPixelsDirty(int x0, int y0, int x1, int y1);
+    void markAllDirty();                    // Whole sprite, e.g. after a load or resize
     void initializeDefaultPalette();
+    bool commitLoadedSprite(int width, int height, const uint8_t* pixels,
+                            const uint8_t* palette);  // Helper: store a successful load, repack if needed
     bool resamplePNGAtOffset();             // Helper: downsample PNG from current offset
+    void preparePNGImport();                // Helper: steps B/C into the import cache
+    void releasePNGImport();                // Helper: free the source and cached steps
 };
 
 } // namespace SPRED
@@ -0,0 +1,234 @@
+//
+//  SpriteDictionary.cpp
+//  SPRED - Sprite Editor
+//
+//  Preset dictionary registry, SPRTD files and dictionary trainer
+//
+
+#include "SpriteDictionary.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint16_t SPRTD_VERSION = 1;
+constexpr size_t SPRTD_HEADER_SIZE = 16;
+
+constexpr int TRAIN_DMER_SIZE = 6;       // Substring length used for scoring
+constexpr int TRAIN_SEGMENT_SIZE = 32;   // Bytes copied into the dictionary per pick
+
+std::vector<uint8_t> g_dictionaries[256];
+
+uint64_t readDmer(const uint8_t* p) {
+    uint64_t value = 0;
+    std::memcpy(&value, p, TRAIN_DMER_SIZE);
+    return value;
+}
+
+} // namespace
+
+// =============================================================================
+// Registry
+// =============================================================================
+
+bool SpriteDictionary::registerDictionary(uint8_t dictionaryID, const uint8_t* data, size_t size) {
+    if (dictionaryID == 0 || !data || size == 0 || size > MAX_DICTIONARY_SIZE) {
+        return false;
+    }
+    g_dictionaries[dictionaryID].assign(data, data + size);
+    return true;
+}
+
+void SpriteDictionary::unregisterDictionary(uint8_t dictionaryID) {
+    g_dictionaries[dictionaryID].clear();
+    g_dictionaries[dictionaryID].shrink_to_fit();
+}
+
+bool SpriteDictionary::getDictionary(uint8_t dictionaryID, const uint8_t*& outData, size_t& outSize) {
+    const std::vector<uint8_t>& dictionary = g_dictionaries[dictionaryID];
+    if (dictionaryID == 0 || dictionary.empty()) {
+        return false;
+    }
+    outData = dictionary.data();
+    outSize = dictionary.size();
+    return true;
+}
+
+bool SpriteDictionary::isRegistered(uint8_t dictionaryID) {
+    return dictionaryID != 0 && !g_dictionaries[dictionaryID].empty();
+}
+
+// =============================================================================
+// SPRTD Files
+// =============================================================================
+
+bool SpriteDictionary::loadFile(const std::string& filename, uint8_t& outDictionaryID) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    if (image.size() < SPRTD_HEADER_SIZE ||
+        image[0] != 'S' || image[1] != 'P' || image[2] != 'T' || image[3] != 'D') {
+        return false;
+    }
+
+    uint16_t version;
+    uint32_t size;
+    uint32_t checksum;
+    std::memcpy(&version, image.data() + 4, sizeof(version));
+    std::memcpy(&size, image.data() + 8, sizeof(size));
+    std::memcpy(&checksum, image.data() + 12, sizeof(checksum));
+    uint8_t dictionaryID = image[6];
+
+    if (version != SPRTD_VERSION || size != image.size() - SPRTD_HEADER_SIZE) {
+        return false;
+    }
+
+    const uint8_t* data = image.data() + SPRTD_HEADER_SIZE;
+    if (adler32(adler32(0, nullptr, 0), data, size) != checksum) {
+        return false;
+    }
+
+    if (!registerDictionary(dictionaryID, data, size)) {
+        return false;
+    }
+    outDictionaryID = dictionaryID;
+    return true;
+}
+
+bool SpriteDictionary::saveFile(const std::string& filename, uint8_t dictionaryID,
+                                const uint8_t* data, size_t size) {
+    if (dictionaryID == 0 || !data || size == 0 || size > MAX_DICTIONARY_SIZE) {
+        return false;
+    }
+
+    std::vector<uint8_t> image(SPRTD_HEADER_SIZE + size);
+    uint16_t version = SPRTD_VERSION;
+    uint32_t size32 = static_cast<uint32_t>(size);
+    uint32_t checksum = static_cast<uint32_t>(adler32(adler32(0, nullptr, 0), data, size32));
+
+    std::memcpy(image.data(), "SPTD", 4);
+    std::memcpy(image.data() + 4, &version, sizeof(version));
+    image[6] = dictionaryID;
+    image[7] = 0;
+    std::memcpy(image.data() + 8, &size32, sizeof(size32));
+    std::memcpy(image.data() + 12, &checksum, sizeof(checksum));
+    std::memcpy(image.data() + SPRTD_HEADER_SIZE, data, size);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return file.good();
+}
+
+// =============================================================================
+// Trainer
+// =============================================================================
+
+bool SpriteDictionary::train(const std::vector<std::vector<uint8_t>>& samples, size_t maxSize,
+                             std::vector<uint8_t>& outDictionary) {
+    outDictionary.clear();
+    maxSize = std::min(maxSize, MAX_DICTIONARY_SIZE);
+    if (samples.empty() || maxSize < static_cast<size_t>(TRAIN_DMER_SIZE)) {
+        return false;
+    }
+
+    // Count how many samples contain each d-mer (once per sample)
+    std::unordered_map<uint64_t, uint32_t> frequency;
+    std::vector<uint64_t> dmers;
+    for (const std::vector<uint8_t>& sample : samples) {
+        if (sample.size() < static_cast<size_t>(TRAIN_DMER_SIZE)) {
+            continue;
+        }
+        dmers.clear();
+        for (size_t i = 0; i + TRAIN_DMER_SIZE <= sample.size(); i++) {
+            dmers.push_back(readDmer(sample.data() + i));
+        }
+        std::sort(dmers.begin(), dmers.end());
+        dmers.erase(std::unique(dmers.begin(), dmers.end()), dmers.end());
+        for (uint64_t dmer : dmers) {
+            frequency[dmer]++;
+        }
+    }
+
+    // Each epoch covers a slice of the samples and contributes its best segment.
+    // Picked d-mers stop scoring, so later picks cover different content.
+    size_t segmentCount = std::max<size_t>(1, maxSize / TRAIN_SEGMENT_SIZE);
+    size_t epochs = std::min(segmentCount, samples.size());
+    std::vector<std::vector<uint8_t>> segments;
+    size_t total = 0;
+    std::vector<uint64_t> prefix;
+
+    bool progress = true;
+    while (total < maxSize && progress) {
+        progress = false;
+        for (size_t epoch = 0; epoch < epochs && total < maxSize; epoch++) {
+            uint64_t bestScore = 0;
+            const uint8_t* bestStart = nullptr;
+            size_t bestLength = 0;
+
+            for (size_t s = epoch; s < samples.size(); s += epochs) {
+                const std::vector<uint8_t>& sample = samples[s];
+                if (sample.size() < static_cast<size_t>(TRAIN_DMER_SIZE)) {
+                    continue;
+                }
+
+                // Prefix sums of d-mer scores so each window is scored in O(1)
+                size_t dmerCount = sample.size() - TRAIN_DMER_SIZE + 1;
+                prefix.assign(dmerCount + 1, 0);
+                for (size_t i = 0; i < dmerCount; i++) {
+                    auto it = frequency.find(readDmer(sample.data() + i));
+                    prefix[i + 1] = prefix[i] + (it != frequency.end() ? it->second : 0);
+                }
+
+                size_t length = std::min<size_t>(TRAIN_SEGMENT_SIZE, sample.size());
+                size_t windowDmers = length - TRAIN_DMER_SIZE + 1;
+                for (size_t start = 0; start + length <= sample.size(); start++) {
+                    uint64_t score = prefix[start + windowDmers] - prefix[start];
+                    if (score > bestScore) {
+                        bestScore = score;
+                        bestStart = sample.data() + start;
+                        bestLength = length;
+                    }
+                }
+            }
+
+            // A d-mer seen in only one sample never helps another sprite
+            if (bestScore <= bestLength - TRAIN_DMER_SIZE + 1) {
+                continue;
+            }
+
+            bestLength = std::min(bestLength, maxSize - total);
+            segments.emplace_back(bestStart, bestStart + bestLength);
+            total += bestLength;
+            progress = true;
+
+            for (size_t i = 0; i + TRAIN_DMER_SIZE <= bestLength; i++) {
+                auto it = frequency.find(readDmer(bestStart + i));
+                if (it != frequency.end()) {
+                    it->second = 0;
+                }
+            }
+        }
+    }
+
+    // Strongest segments last: deflate reaches the end of the dictionary with the shortest distances
+    outDictionary.reserve(total);
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+        outDictionary.insert(outDictionary.end(), it->begin(), it->end());
+    }
+    return !outDictionary.empty();
+}
+
+} // namespace SPRED
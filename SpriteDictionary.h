@@ -0,0 +1,83 @@
+//
+//  SpriteDictionary.h
+//  SPRED - Sprite Editor
+//
+//  Preset compression dictionaries for small SPRTZ sprites
+//
+
+#ifndef SPRED_SPRITE_DICTIONARY_H
+#define SPRED_SPRITE_DICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SPRED {
+
+/// SPRTD Dictionary File Format
+/// ============================
+///
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 4    | char[4] | Magic: "SPTD"
+/// 0x04   | 2    | uint16  | Version (1)
+/// 0x06   | 1    | uint8   | Dictionary ID (1-255)
+/// 0x07   | 1    | uint8   | Reserved (0)
+/// 0x08   | 4    | uint32  | Dictionary size in bytes
+/// 0x0C   | 4    | uint32  | Adler-32 of the dictionary (as zlib reports it)
+/// 0x10   | size | uint8[] | Dictionary bytes (pixel index strings)
+///
+/// A SPRTZ v3 zlib payload compressed against a dictionary stores the
+/// dictionary ID in header byte 0x13 (see SpriteCompression.h). Decoding
+/// such a sprite requires the same dictionary to be registered under that ID.
+
+/// SpriteDictionary - Registry and trainer for preset dictionaries
+///
+/// Dictionaries are process-wide, like the standard palette library. Register
+/// them once at startup, before encoding or decoding on other threads.
+class SpriteDictionary {
+public:
+    /// Largest dictionary zlib can use (its window size)
+    static constexpr size_t MAX_DICTIONARY_SIZE = 32768;
+
+    /// Register a dictionary (replaces any dictionary with the same ID)
+    /// @param dictionaryID ID 1-255 (0 means "no dictionary" in files)
+    /// @return true if successful
+    static bool registerDictionary(uint8_t dictionaryID, const uint8_t* data, size_t size);
+
+    /// Remove a dictionary
+    static void unregisterDictionary(uint8_t dictionaryID);
+
+    /// Get a registered dictionary
+    /// @return true and the dictionary bytes if the ID is registered
+    static bool getDictionary(uint8_t dictionaryID, const uint8_t*& outData, size_t& outSize);
+
+    static bool isRegistered(uint8_t dictionaryID);
+
+    /// Load an SPRTD file and register it under its stored ID
+    /// @param outDictionaryID Output: ID the dictionary was registered under
+    /// @return true if successful
+    static bool loadFile(const std::string& filename, uint8_t& outDictionaryID);
+
+    /// Save a dictionary as an SPRTD file
+    static bool saveFile(const std::string& filename, uint8_t dictionaryID,
+                         const uint8_t* data, size_t size);
+
+    /// Build a dictionary from sample pixel buffers
+    ///
+    /// Greedy segment selection in the style of zstd's COVER trainer: samples are
+    /// scored by how many samples share each short substring, the best-scoring
+    /// segments are kept, and the strongest segments are placed at the end of
+    /// the dictionary where deflate reaches them with the shortest distances.
+    /// @param samples Pixel index buffers (one per sprite)
+    /// @param maxSize Dictionary size limit (at most MAX_DICTIONARY_SIZE)
+    /// @param outDictionary Output dictionary bytes
+    /// @return true if a non-empty dictionary was built
+    static bool train(const std::vector<std::vector<uint8_t>>& samples, size_t maxSize,
+                      std::vector<uint8_t>& outDictionary);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_DICTIONARY_H
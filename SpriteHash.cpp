@@ -0,0 +1,53 @@
+//
+//  SpriteHash.cpp
+//  SPRED - Sprite Editor
+//
+//  Fast 64-bit content hashing for sprite pixel data
+//
+
+#include "SpriteHash.h"
+#include <cstring>
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint64_t HASH_P0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t HASH_P1 = 0xe7037ed1a0b428dbULL;
+constexpr uint64_t HASH_P2 = 0x8ebc6af09c88c6e3ULL;
+constexpr uint64_t HASH_P3 = 0x589965cc75374cc3ULL;
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/// Multiply to 128 bits and fold the halves together
+inline uint64_t mix(uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+} // namespace
+
+uint64_t SpriteHash::hash64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t acc = seed ^ mix(seed ^ HASH_P0, HASH_P1);
+
+    size_t remaining = size;
+    while (remaining > 16) {
+        acc = mix(read64(p) ^ HASH_P1, read64(p + 8) ^ acc);
+        p += 16;
+        remaining -= 16;
+    }
+
+    // Last 1-16 bytes, zero-padded
+    uint8_t tail[16] = {};
+    std::memcpy(tail, p, remaining);
+    uint64_t a = read64(tail) ^ HASH_P1;
+    uint64_t b = read64(tail + 8) ^ acc;
+    return mix(HASH_P1 ^ size, mix(a, b) ^ HASH_P2) ^ HASH_P3;
+}
+
+} // namespace SPRED
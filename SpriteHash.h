@@ -0,0 +1,32 @@
+//
+//  SpriteHash.h
+//  SPRED - Sprite Editor
+//
+//  Fast 64-bit content hashing for sprite pixel data
+//
+
+#ifndef SPRED_SPRITE_HASH_H
+#define SPRED_SPRITE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPRED {
+
+/// SpriteHash - Non-cryptographic 64-bit hashing
+///
+/// Multiply-fold hash in the style of wyhash: 16 bytes per step, one
+/// 64×64→128-bit multiply each. Fast enough to hash a 40×40 sprite in well
+/// under a microsecond, so caches can key on content and loaders can check
+/// decoded pixels on every load. Values are stable across runs and platforms
+/// (little-endian), so they may be stored in files.
+class SpriteHash {
+public:
+    /// Hash a byte range
+    /// @param seed Chains hashes: pass the hash of the preceding data
+    static uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_HASH_H
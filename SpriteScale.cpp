@@ -0,0 +1,263 @@
+//
+//  SpriteScale.cpp
+//  SPRED - Sprite Editor
+//
+//  Integer upscaling kernels and scaled image cache
+//
+
+#include "SpriteScale.h"
+#include "SpriteData.h"
+#include "SpriteHash.h"
+#include "PaletteExpand.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRED_SCALE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPRED_SCALE_NEON 1
+#endif
+
+namespace SPRED {
+
+namespace {
+
+/// Repeat each pixel twice; returns the number of pixels done
+size_t scaleRow2x(const uint8_t* src, size_t count, uint8_t* dst) {
+    size_t i = 0;
+#if defined(SPRED_SCALE_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8), _mm_unpacklo_epi32(pixels, pixels));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8 + 16), _mm_unpackhi_epi32(pixels, pixels));
+    }
+#elif defined(SPRED_SCALE_NEON)
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t pixels = vld1q_u32(reinterpret_cast<const uint32_t*>(src + i * 4));
+        uint32x4x2_t pairs = {{pixels, pixels}};
+        vst2q_u32(reinterpret_cast<uint32_t*>(dst + i * 8), pairs);
+    }
+#endif
+    return i;
+}
+
+/// Repeat each pixel four times; returns the number of pixels done
+size_t scaleRow4x(const uint8_t* src, size_t count, uint8_t* dst) {
+    size_t i = 0;
+#if defined(SPRED_SCALE_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i * 16);
+        _mm_storeu_si128(out + 0, _mm_shuffle_epi32(pixels, 0x00));
+        _mm_storeu_si128(out + 1, _mm_shuffle_epi32(pixels, 0x55));
+        _mm_storeu_si128(out + 2, _mm_shuffle_epi32(pixels, 0xAA));
+        _mm_storeu_si128(out + 3, _mm_shuffle_epi32(pixels, 0xFF));
+    }
+#elif defined(SPRED_SCALE_NEON)
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t pixels = vld1q_u32(reinterpret_cast<const uint32_t*>(src + i * 4));
+        uint32x4x4_t quads = {{pixels, pixels, pixels, pixels}};
+        vst4q_u32(reinterpret_cast<uint32_t*>(dst + i * 16), quads);
+    }
+#endif
+    return i;
+}
+
+/// Everything an image depends on: size, full palette and indices
+std::shared_ptr<const std::vector<uint8_t>> spriteContent(const SpriteData& sprite) {
+    const int32_t size[2] = {sprite.getWidth(), sprite.getHeight()};
+    const size_t pixelCount = size_t(size[0]) * size[1];
+    auto content = std::make_shared<std::vector<uint8_t>>(sizeof(size) + PALETTE_BYTES + pixelCount);
+    uint8_t* out = content->data();
+    std::memcpy(out, size, sizeof(size));
+    std::memcpy(out + sizeof(size), sprite.getPaletteData(), PALETTE_BYTES);
+
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    std::memcpy(out + sizeof(size) + PALETTE_BYTES, sprite.getUnpackedPixels(scratch), pixelCount);
+    return content;
+}
+
+uint64_t scaleKey(uint64_t spriteHash, int scale) {
+    int32_t value = scale;
+    return SpriteHash::hash64(&value, sizeof(value), spriteHash);
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+void SpriteScale::scaleRow(const uint8_t* src, size_t count, int scale, uint8_t* dst) {
+    size_t done = 0;
+    if (scale == 1) {
+        std::memcpy(dst, src, count * 4);
+        return;
+    }
+    if (scale == 2) {
+        done = scaleRow2x(src, count, dst);
+    } else if (scale == 4) {
+        done = scaleRow4x(src, count, dst);
+    }
+
+    for (size_t i = done; i < count; i++) {
+        uint32_t pixel;
+        std::memcpy(&pixel, src + i * 4, 4);
+        uint8_t* out = dst + i * scale * 4;
+        for (int s = 0; s < scale; s++) {
+            std::memcpy(out + s * 4, &pixel, 4);
+        }
+    }
+}
+
+void SpriteScale::scaleImage(const uint8_t* src, int width, int height, int scale, uint8_t* dst) {
+    const size_t rowBytes = size_t(width) * scale * 4;
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = dst + size_t(y) * scale * rowBytes;
+        scaleRow(src + size_t(y) * width * 4, width, scale, row);
+        for (int s = 1; s < scale; s++) {
+            std::memcpy(row + s * rowBytes, row, rowBytes);
+        }
+    }
+}
+
+bool SpriteScale::expandScaled(const uint8_t* indices, int width, int height, const uint32_t* table,
+                               const int* scales, int scaleCount, uint8_t* const* outImages) {
+    for (int i = 0; i < scaleCount; i++) {
+        if (scales[i] < 1 || scales[i] > MAX_SCALE) {
+            return false;
+        }
+    }
+
+    // Each row is expanded once and widened into every output
+    std::vector<uint8_t> row(size_t(width) * 4);
+    for (int y = 0; y < height; y++) {
+        PaletteExpand::expandRow(indices + size_t(y) * width, width, table, row.data());
+        for (int i = 0; i < scaleCount; i++) {
+            const int scale = scales[i];
+            const size_t rowBytes = size_t(width) * scale * 4;
+            uint8_t* dst = outImages[i] + size_t(y) * scale * rowBytes;
+            scaleRow(row.data(), width, scale, dst);
+            for (int s = 1; s < scale; s++) {
+                std::memcpy(dst + s * rowBytes, dst, rowBytes);
+            }
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+ScaledSpriteCache::ScaledSpriteCache(size_t maxBytes)
+    : m_maxBytes(maxBytes)
+{
+}
+
+ScaledSpriteCache& ScaledSpriteCache::shared() {
+    static ScaledSpriteCache cache;
+    return cache;
+}
+
+bool ScaledSpriteCache::get(const SpriteData& sprite, const int* scales, int scaleCount, Image* outImages) {
+    for (int i = 0; i < scaleCount; i++) {
+        if (scales[i] < 1 || scales[i] > SpriteScale::MAX_SCALE) {
+            return false;
+        }
+    }
+
+    // Hits are confirmed against the stored content, so a hash collision is a miss
+    const std::shared_ptr<const std::vector<uint8_t>> content = spriteContent(sprite);
+    const uint64_t spriteHash = SpriteHash::hash64(content->data(), content->size());
+    std::vector<int> missing;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < scaleCount; i++) {
+            auto it = m_entries.find(scaleKey(spriteHash, scales[i]));
+            if (it == m_entries.end() || *it->second.content != *content) {
+                missing.push_back(i);
+                continue;
+            }
+            m_recent.splice(m_recent.begin(), m_recent, it->second.recent);
+            outImages[i] = it->second.image;
+            m_stats.hits++;
+        }
+    }
+    if (missing.empty()) {
+        return true;
+    }
+
+    // Expand outside the lock; one pass covers every missing scale
+    const int width = sprite.getWidth();
+    const int height = sprite.getHeight();
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    PaletteExpand::buildTable(sprite.getPaletteData(), SurfaceFormat::RGBA, table);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    const uint8_t* pixels = sprite.getUnpackedPixels(scratch);
+
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> images;
+    std::vector<int> missingScales;
+    std::vector<uint8_t*> outputs;
+    for (int i : missing) {
+        size_t bytes = size_t(width) * height * scales[i] * scales[i] * 4;
+        images.push_back(std::make_shared<std::vector<uint8_t>>(bytes));
+        missingScales.push_back(scales[i]);
+        outputs.push_back(images.back()->data());
+    }
+    SpriteScale::expandScaled(pixels, width, height, table, missingScales.data(),
+                              static_cast<int>(missingScales.size()), outputs.data());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t m = 0; m < missing.size(); m++) {
+        const uint64_t key = scaleKey(spriteHash, scales[missing[m]]);
+        outImages[missing[m]] = images[m];
+        m_stats.misses++;
+        if (m_entries.count(key)) {
+            continue;   // Another thread inserted the image meanwhile, or a colliding sprite holds the key
+        }
+        m_recent.push_front(key);
+        m_entries[key] = {images[m], content, m_recent.begin()};
+        m_stats.imageCount++;
+        m_stats.bytes += images[m]->size();
+    }
+    evict();
+    return true;
+}
+
+ScaledSpriteCache::Image ScaledSpriteCache::get(const SpriteData& sprite, int scale) {
+    Image image;
+    return get(sprite, &scale, 1, &image) ? image : nullptr;
+}
+
+ScaledSpriteCacheStats ScaledSpriteCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ScaledSpriteCache::setMaxBytes(size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+void ScaledSpriteCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_recent.clear();
+    m_stats.imageCount = 0;
+    m_stats.bytes = 0;
+}
+
+void ScaledSpriteCache::evict() {
+    while (m_stats.bytes > m_maxBytes && !m_recent.empty()) {
+        auto it = m_entries.find(m_recent.back());
+        m_stats.bytes -= it->second.image->size();
+        m_stats.imageCount--;
+        m_entries.erase(it);
+        m_recent.pop_back();
+    }
+}
+
+} // namespace SPRED
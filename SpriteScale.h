@@ -0,0 +1,115 @@
+//
+//  SpriteScale.h
+//  SPRED - Sprite Editor
+//
+//  Integer nearest-neighbour upscaling and a cache of scaled sprite images
+//
+
+#ifndef SPRED_SPRITE_SCALE_H
+#define SPRED_SPRITE_SCALE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// SpriteScale - Pixel and row replication for integer export scales
+///
+/// A scaled row is built once (pixels widened with SSE2 or NEON unpacks for
+/// 2x and 4x) and then copied scale - 1 times. Several scales are produced
+/// from one palette expansion of the sprite.
+class SpriteScale {
+public:
+    /// Largest supported scale factor
+    static constexpr int MAX_SCALE = 16;
+
+    /// Repeat each 32-bit pixel of a row scale times
+    /// @param src Input pixels (count × 4 bytes)
+    /// @param dst Output pixels (count × scale × 4 bytes)
+    static void scaleRow(const uint8_t* src, size_t count, int scale, uint8_t* dst);
+
+    /// Scale a 32-bit image
+    /// @param dst Output image (width × scale by height × scale pixels, tightly packed)
+    static void scaleImage(const uint8_t* src, int width, int height, int scale, uint8_t* dst);
+
+    /// Expand indices through a PaletteExpand table once and emit every scale
+    /// @param scales Scale factors (1 to MAX_SCALE)
+    /// @param outImages One output per scale (width × s by height × s pixels each)
+    /// @return false if a scale is out of range
+    static bool expandScaled(const uint8_t* indices, int width, int height, const uint32_t* table,
+                             const int* scales, int scaleCount, uint8_t* const* outImages);
+};
+
+/// Totals for a ScaledSpriteCache
+struct ScaledSpriteCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;            // Images expanded and inserted
+    size_t imageCount = 0;
+    size_t bytes = 0;               // Image bytes currently cached (sprite content not counted)
+};
+
+/// ScaledSpriteCache - RGBA images of sprites at integer scales
+///
+/// Entries are keyed by a hash of the sprite's size, indices and full
+/// palette, so any pixel or palette edit yields a new key and stale images
+/// are simply never requested again. Each entry also keeps those bytes, and
+/// a hit is only taken when they match, so a hash collision is never served.
+/// The least recently used images are dropped once the cache exceeds its
+/// byte budget. Thread-safe.
+///
+/// Usage:
+///   const int scales[3] = {1, 2, 4};
+///   ScaledSpriteCache::Image images[3];
+///   ScaledSpriteCache::shared().get(sprite, scales, 3, images);
+///   PNGConverter::savePNGFile("ship@4x.png", images[2]->data(), w * 4, h * 4);
+class ScaledSpriteCache {
+public:
+    /// Cached RGBA image (stays valid while held, even after eviction)
+    using Image = std::shared_ptr<const std::vector<uint8_t>>;
+
+    /// @param maxBytes Pixel byte budget before the least recently used images are dropped
+    explicit ScaledSpriteCache(size_t maxBytes = 64 * 1024 * 1024);
+
+    /// Cache used by SpriteData::exportPNG (for scales up to SpriteScale::MAX_SCALE)
+    static ScaledSpriteCache& shared();
+
+    /// Get a sprite at several scales; missing scales are expanded in one pass
+    /// @param outImages One image per scale (width × s by height × s RGBA pixels)
+    /// @return false if a scale is out of range
+    bool get(const SpriteData& sprite, const int* scales, int scaleCount, Image* outImages);
+
+    /// Get a sprite at one scale
+    /// @return nullptr if the scale is out of range
+    Image get(const SpriteData& sprite, int scale);
+
+    ScaledSpriteCacheStats getStats() const;
+
+    void setMaxBytes(size_t maxBytes);
+    void clear();
+
+private:
+    struct Entry {
+        Image image;
+        std::shared_ptr<const std::vector<uint8_t>> content;   // Size, palette and indices the image was made from
+        std::list<uint64_t>::iterator recent;
+    };
+
+    mutable std::mutex m_mutex;
+    size_t m_maxBytes;
+    std::unordered_map<uint64_t, Entry> m_entries;  // hash(content, scale) -> image
+    std::list<uint64_t> m_recent;                   // Most recently used first
+    ScaledSpriteCacheStats m_stats;
+
+    void evict();
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_SCALE_H
@@ -0,0 +1,450 @@
+//
+//  SpriteStore.cpp
+//  SPRED - Sprite Editor
+//
+//  Content-addressed sprite store implementation
+//
+
+#include "SpriteStore.h"
+#include "SpriteCodecs.h"
+#include "SpriteCompression.h"
+#include "SpriteHash.h"
+#include "PaletteLibrary.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace SuperTerminal;
+
+namespace SPRED {
+
+namespace {
+
+constexpr uint16_t STORE_VERSION = 1;
+constexpr size_t STORE_HEADER_SIZE = 32;
+constexpr size_t STORE_BLOCK_ENTRY_SIZE = 8;
+constexpr size_t STORE_SPRITE_ENTRY_SIZE = 12;
+constexpr int STORE_MAX_PIXELS = 40 * 40;
+
+struct StoreHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t spriteCount;
+    uint32_t blockCount;
+    uint32_t paletteCount;
+    uint32_t namesSize;
+    uint8_t reserved2[8];
+};
+
+static_assert(sizeof(StoreHeader) == STORE_HEADER_SIZE, "SPRTS header must be 32 bytes");
+
+/// Block hashes include the dimensions, so an 8×32 block never matches a 16×16 one
+uint64_t hashBlock(int width, int height, const uint8_t* pixels) {
+    uint8_t seed[2] = {static_cast<uint8_t>(width), static_cast<uint8_t>(height)};
+    return SpriteHash::hash64(pixels, width * height, SpriteHash::hash64(seed, sizeof(seed)));
+}
+
+template <typename T>
+void appendValue(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T readValue(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+// =============================================================================
+// Adding Content
+// =============================================================================
+
+uint32_t SpriteStore::addPixelBlock(int width, int height, const uint8_t* pixels) {
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<uint32_t>& candidates = m_blockIndex[hashBlock(width, height, pixels)];
+    for (uint32_t blockID : candidates) {
+        const Block& block = m_blocks[blockID];
+        if (block.width == width && block.height == height &&
+            std::memcmp(block.pixels.data(), pixels, pixelCount) == 0) {
+            return blockID;
+        }
+    }
+
+    uint32_t blockID = static_cast<uint32_t>(m_blocks.size());
+    m_blocks.push_back({static_cast<uint8_t>(width), static_cast<uint8_t>(height),
+                        std::vector<uint8_t>(pixels, pixels + pixelCount)});
+    candidates.push_back(blockID);
+    m_stats.pixelBlockCount++;
+    m_stats.uniquePixelBytes += pixelCount;
+    return blockID;
+}
+
+bool SpriteStore::addPalette(const uint8_t* palette, uint16_t& outPaletteID) {
+    // Colors 2-15, RGB only, as embedded in SPRTZ files
+    uint8_t rgb[PALETTE_SIZE];
+    for (int i = 2; i < 16; i++) {
+        std::memcpy(rgb + (i - 2) * 3, palette + i * 4, 3);
+    }
+    return addPaletteRGB(rgb, outPaletteID);
+}
+
+bool SpriteStore::addPaletteRGB(const uint8_t* rgb, uint16_t& outPaletteID) {
+    std::vector<uint16_t>& candidates = m_paletteIndex[SpriteHash::hash64(rgb, PALETTE_SIZE)];
+    for (uint16_t paletteID : candidates) {
+        if (std::memcmp(m_palettes.data() + paletteID * PALETTE_SIZE, rgb, PALETTE_SIZE) == 0) {
+            outPaletteID = paletteID;
+            return true;
+        }
+    }
+
+    size_t paletteID = getPaletteCount();
+    if (paletteID >= STANDARD_PALETTE) {
+        return false;
+    }
+    m_palettes.insert(m_palettes.end(), rgb, rgb + PALETTE_SIZE);
+    candidates.push_back(static_cast<uint16_t>(paletteID));
+    m_stats.paletteCount++;
+    m_stats.uniquePaletteBytes += PALETTE_SIZE;
+    outPaletteID = static_cast<uint16_t>(paletteID);
+    return true;
+}
+
+bool SpriteStore::addRecord(const std::string& name, uint32_t blockID, uint8_t paletteMode,
+                            const uint8_t* rgb) {
+    uint16_t paletteID = STANDARD_PALETTE;
+    if (paletteMode == 0xFF && !addPaletteRGB(rgb, paletteID)) {
+        return false;
+    }
+
+    m_names.emplace(name, m_sprites.size());
+    m_sprites.push_back({name, blockID, paletteID, paletteMode});
+
+    const Block& block = m_blocks[blockID];
+    m_stats.spriteCount++;
+    m_stats.pixelBytes += block.pixels.size();
+    if (paletteMode == 0xFF) {
+        m_stats.customPaletteRefs++;
+        m_stats.paletteBytes += PALETTE_SIZE;
+    }
+    return true;
+}
+
+bool SpriteStore::addSprite(const std::string& name, int width, int height, const uint8_t* pixels,
+                            uint8_t paletteMode, const uint8_t* palette) {
+    if (name.empty() || m_names.count(name) || !pixels ||
+        width <= 0 || height <= 0 || width * height > STORE_MAX_PIXELS ||
+        (paletteMode >= 32 && (paletteMode != 0xFF || !palette))) {
+        return false;
+    }
+
+    uint8_t rgb[PALETTE_SIZE];
+    if (paletteMode == 0xFF) {
+        for (int i = 2; i < 16; i++) {
+            std::memcpy(rgb + (i - 2) * 3, palette + i * 4, 3);
+        }
+    }
+    return addRecord(name, addPixelBlock(width, height, pixels), paletteMode,
+                     paletteMode == 0xFF ? rgb : nullptr);
+}
+
+bool SpriteStore::addSPRTZ(const std::string& name, const uint8_t* data, size_t size) {
+    if (name.empty() || m_names.count(name)) {
+        return false;
+    }
+
+    SPRTZInfo info;
+    uint8_t pixels[STORE_MAX_PIXELS];
+    if (!SpriteCompression::decodeSPRTZPixels(data, size, info, pixels)) {
+        return false;
+    }
+    return addRecord(name, addPixelBlock(info.width, info.height, pixels), info.paletteMode, info.palette);
+}
+
+bool SpriteStore::addFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    std::string name = std::filesystem::path(path).stem().string();
+    return addSPRTZ(name, image.data(), image.size());
+}
+
+int SpriteStore::addDirectory(const std::string& directory) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory, ec);
+    if (ec) {
+        return -1;
+    }
+
+    // Sort paths so IDs do not depend on directory order
+    std::vector<std::string> paths;
+    for (const auto& dirEntry : it) {
+        if (dirEntry.is_regular_file() && dirEntry.path().extension() == ".sprtz") {
+            paths.push_back(dirEntry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    int added = 0;
+    for (const std::string& path : paths) {
+        if (addFile(path)) {
+            added++;
+        }
+    }
+    return added;
+}
+
+// =============================================================================
+// Access
+// =============================================================================
+
+const SpriteStore::Sprite* SpriteStore::getSprite(size_t index) const {
+    if (index >= m_sprites.size()) {
+        return nullptr;
+    }
+    return &m_sprites[index];
+}
+
+int SpriteStore::findSprite(const std::string& name) const {
+    auto it = m_names.find(name);
+    return it != m_names.end() ? static_cast<int>(it->second) : -1;
+}
+
+bool SpriteStore::getPixelBlock(uint32_t blockID, int& outWidth, int& outHeight,
+                                const uint8_t*& outPixels) const {
+    if (blockID >= m_blocks.size()) {
+        return false;
+    }
+    const Block& block = m_blocks[blockID];
+    outWidth = block.width;
+    outHeight = block.height;
+    outPixels = block.pixels.data();
+    return true;
+}
+
+bool SpriteStore::getPalette(uint16_t paletteID, uint8_t* outPalette) const {
+    if (paletteID >= getPaletteCount()) {
+        return false;
+    }
+
+    // Fixed colors 0 (transparent) and 1 (opaque black)
+    std::memset(outPalette, 0, 8);
+    outPalette[7] = 255;
+
+    const uint8_t* rgb = m_palettes.data() + paletteID * PALETTE_SIZE;
+    for (int i = 2; i < 16; i++) {
+        std::memcpy(outPalette + i * 4, rgb + (i - 2) * 3, 3);
+        outPalette[i * 4 + 3] = 255;
+    }
+    return true;
+}
+
+bool SpriteStore::decodeSprite(size_t index, int& outWidth, int& outHeight,
+                               uint8_t* outPixels, uint8_t* outPalette,
+                               bool& outIsStandard, uint8_t& outPaletteID) const {
+    const Sprite* sprite = getSprite(index);
+    if (!sprite) {
+        return false;
+    }
+
+    bool paletteOK = sprite->paletteID == STANDARD_PALETTE
+        ? StandardPaletteLibrary::copyPaletteRGBA(sprite->paletteMode, outPalette)
+        : getPalette(sprite->paletteID, outPalette);
+    if (!paletteOK) {
+        return false;
+    }
+
+    const Block& block = m_blocks[sprite->blockID];
+    std::memcpy(outPixels, block.pixels.data(), block.pixels.size());
+    outWidth = block.width;
+    outHeight = block.height;
+    outIsStandard = sprite->paletteID == STANDARD_PALETTE;
+    outPaletteID = sprite->paletteMode;
+    return true;
+}
+
+// =============================================================================
+// SPRTS Files
+// =============================================================================
+
+void SpriteStore::build(std::vector<uint8_t>& out) const {
+    SpriteCodecContext context;
+    std::vector<std::vector<uint8_t>> payloads(m_blocks.size());
+    std::vector<SPRTZCodec> codecs(m_blocks.size());
+    for (size_t i = 0; i < m_blocks.size(); i++) {
+        const Block& block = m_blocks[i];
+        SpriteCodecs::encodeBest(SPRTZCodec::AutoSmallest, block.pixels.data(),
+                                 static_cast<int>(block.pixels.size()), payloads[i], codecs[i], &context);
+    }
+
+    std::vector<uint8_t> names;
+    std::vector<uint32_t> nameOffsets;
+    nameOffsets.reserve(m_sprites.size());
+    for (const Sprite& sprite : m_sprites) {
+        nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+        names.insert(names.end(), sprite.name.begin(), sprite.name.end());
+        names.push_back('\0');
+    }
+
+    StoreHeader header = {};
+    std::memcpy(header.magic, "SPTS", 4);
+    header.version = STORE_VERSION;
+    header.spriteCount = static_cast<uint32_t>(m_sprites.size());
+    header.blockCount = static_cast<uint32_t>(m_blocks.size());
+    header.paletteCount = static_cast<uint32_t>(getPaletteCount());
+    header.namesSize = static_cast<uint32_t>(names.size());
+
+    out.clear();
+    out.insert(out.end(), reinterpret_cast<const uint8_t*>(&header),
+               reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+    out.insert(out.end(), m_palettes.begin(), m_palettes.end());
+
+    for (size_t i = 0; i < m_blocks.size(); i++) {
+        out.push_back(m_blocks[i].width);
+        out.push_back(m_blocks[i].height);
+        out.push_back(static_cast<uint8_t>(codecs[i]));
+        out.push_back(0);
+        appendValue(out, static_cast<uint32_t>(payloads[i].size()));
+    }
+
+    out.insert(out.end(), names.begin(), names.end());
+
+    for (size_t i = 0; i < m_sprites.size(); i++) {
+        appendValue(out, nameOffsets[i]);
+        appendValue(out, m_sprites[i].blockID);
+        appendValue(out, m_sprites[i].paletteID);
+        out.push_back(m_sprites[i].paletteMode);
+        out.push_back(0);
+    }
+
+    for (const std::vector<uint8_t>& payload : payloads) {
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+}
+
+bool SpriteStore::write(const std::string& filename) const {
+    std::vector<uint8_t> image;
+    build(image);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return file.good();
+}
+
+bool SpriteStore::loadMemory(const uint8_t* data, size_t size) {
+    clear();
+    if (!data || size < STORE_HEADER_SIZE) {
+        return false;
+    }
+
+    StoreHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "SPTS", 4) != 0 || header.version != STORE_VERSION ||
+        header.paletteCount > STANDARD_PALETTE) {
+        return false;
+    }
+
+    // Validate the section sizes once so the loops below only check contents
+    uint64_t palettesEnd = STORE_HEADER_SIZE + uint64_t(header.paletteCount) * PALETTE_SIZE;
+    uint64_t blocksEnd = palettesEnd + uint64_t(header.blockCount) * STORE_BLOCK_ENTRY_SIZE;
+    uint64_t namesEnd = blocksEnd + header.namesSize;
+    uint64_t spritesEnd = namesEnd + uint64_t(header.spriteCount) * STORE_SPRITE_ENTRY_SIZE;
+    if (spritesEnd > size || (header.namesSize > 0 && data[namesEnd - 1] != '\0')) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.paletteCount; i++) {
+        uint16_t paletteID;
+        addPaletteRGB(data + STORE_HEADER_SIZE + i * PALETTE_SIZE, paletteID);
+    }
+    if (getPaletteCount() != header.paletteCount) {
+        clear();
+        return false;   // Duplicate palettes would shift every later ID
+    }
+
+    const uint8_t* payload = data + spritesEnd;
+    const uint8_t* end = data + size;
+    uint8_t pixels[STORE_MAX_PIXELS];
+    for (uint32_t i = 0; i < header.blockCount; i++) {
+        const uint8_t* entry = data + palettesEnd + i * STORE_BLOCK_ENTRY_SIZE;
+        int width = entry[0];
+        int height = entry[1];
+        uint8_t codec = entry[2];
+        uint32_t payloadSize = readValue<uint32_t>(entry + 4);
+        if (width == 0 || height == 0 || width * height > STORE_MAX_PIXELS ||
+            !SpriteCodecs::isValidCodec(codec) || payloadSize > static_cast<size_t>(end - payload) ||
+            !SpriteCodecs::decode(static_cast<SPRTZCodec>(codec), payload, payloadSize, pixels, width * height)) {
+            clear();
+            return false;
+        }
+        payload += payloadSize;
+
+        // Blocks in a well-formed store are unique, so IDs are preserved
+        if (addPixelBlock(width, height, pixels) != i) {
+            clear();
+            return false;
+        }
+    }
+
+    const char* names = reinterpret_cast<const char*>(data + blocksEnd);
+    for (uint32_t i = 0; i < header.spriteCount; i++) {
+        const uint8_t* entry = data + namesEnd + i * STORE_SPRITE_ENTRY_SIZE;
+        uint32_t nameOffset = readValue<uint32_t>(entry);
+        uint32_t blockID = readValue<uint32_t>(entry + 4);
+        uint16_t paletteID = readValue<uint16_t>(entry + 8);
+        uint8_t paletteMode = entry[10];
+
+        bool standard = paletteID == STANDARD_PALETTE;
+        if (nameOffset >= header.namesSize || blockID >= header.blockCount ||
+            standard != (paletteMode != 0xFF) || (standard && paletteMode >= 32) ||
+            (!standard && paletteID >= header.paletteCount)) {
+            clear();
+            return false;
+        }
+
+        std::string name(names + nameOffset);
+        const uint8_t* rgb = standard ? nullptr : m_palettes.data() + paletteID * PALETTE_SIZE;
+        if (name.empty() || m_names.count(name) || !addRecord(name, blockID, paletteMode, rgb)) {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SpriteStore::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        clear();
+        return false;
+    }
+
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    return loadMemory(image.data(), image.size());
+}
+
+void SpriteStore::clear() {
+    m_blocks.clear();
+    m_palettes.clear();
+    m_sprites.clear();
+    m_blockIndex.clear();
+    m_paletteIndex.clear();
+    m_names.clear();
+    m_stats = SpriteStoreStats();
+}
+
+} // namespace SPRED
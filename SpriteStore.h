@@ -0,0 +1,193 @@
+//
+//  SpriteStore.h
+//  SPRED - Sprite Editor
+//
+//  Content-addressed sprite store (deduplicated pixel blocks and palettes)
+//
+
+#ifndef SPRED_SPRITE_STORE_H
+#define SPRED_SPRITE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SPRED {
+
+/// SPRTS Store File Format
+/// =======================
+///
+/// Every unique pixel block and every unique custom palette is stored once;
+/// sprites are (name, block ID, palette) records that reference them.
+///
+/// Header (32 bytes):
+/// ------------------
+/// Offset | Size | Type    | Description
+/// -------|------|---------|----------------------------------
+/// 0x00   | 4    | char[4] | Magic: "SPTS"
+/// 0x04   | 2    | uint16  | Version (1)
+/// 0x06   | 2    | uint16  | Reserved (0)
+/// 0x08   | 4    | uint32  | Sprite count
+/// 0x0C   | 4    | uint32  | Pixel block count
+/// 0x10   | 4    | uint32  | Custom palette count
+/// 0x14   | 4    | uint32  | Name table size
+/// 0x18   | 8    | uint8[] | Reserved (0)
+///
+/// Sections, in order, directly after the header:
+///   Palettes      palette count × 42 bytes (colors 2-15, RGB, as in SPRTZ)
+///   Block table   block count × 8 bytes: width u8, height u8, codec u8,
+///                 reserved u8, payload size u32 (codecs as in SpriteCodecs.h)
+///   Names         name table size bytes of zero-terminated UTF-8 names
+///   Sprites       sprite count × 12 bytes: name offset u32, block ID u32,
+///                 palette ID u16 (0xFFFF = standard palette), palette mode u8,
+///                 reserved u8
+///   Payloads      block payloads back to back, in block order
+
+/// Deduplication totals for a store
+struct SpriteStoreStats {
+    size_t spriteCount = 0;
+    size_t pixelBlockCount = 0;         // Unique pixel blocks
+    size_t customPaletteRefs = 0;       // Sprites using a custom palette
+    size_t paletteCount = 0;            // Unique custom palettes
+    uint64_t pixelBytes = 0;            // Index bytes if every sprite kept its own copy
+    uint64_t uniquePixelBytes = 0;
+    uint64_t paletteBytes = 0;          // Embedded palette bytes if every sprite kept its own copy
+    uint64_t uniquePaletteBytes = 0;
+
+    /// Raw bytes before / after deduplication
+    double getDedupRatio() const {
+        uint64_t unique = uniquePixelBytes + uniquePaletteBytes;
+        return unique > 0 ? double(pixelBytes + paletteBytes) / unique : 1.0;
+    }
+};
+
+/// SpriteStore - Deduplicating sprite library
+///
+/// Pixel blocks and palettes are keyed by SpriteHash::hash64 and compared
+/// byte for byte on a hash match, so IDs are stable for identical content.
+///
+/// Usage:
+///   SpriteStore store;
+///   store.addDirectory("sprites/");
+///   store.write("sprites.sprts");
+///   printf("%.2fx\n", store.getStats().getDedupRatio());
+class SpriteStore {
+public:
+    /// Palette ID of sprites that reference a standard palette
+    static constexpr uint16_t STANDARD_PALETTE = 0xFFFF;
+
+    /// Sprite record (references shared content by ID)
+    struct Sprite {
+        std::string name;
+        uint32_t blockID;
+        uint16_t paletteID;         // Custom palette ID, or STANDARD_PALETTE
+        uint8_t paletteMode;        // Standard palette ID (0-31), or 0xFF for custom
+    };
+
+    /// Add a pixel block, or find the identical block already stored
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @return Block ID
+    uint32_t addPixelBlock(int width, int height, const uint8_t* pixels);
+
+    /// Add a custom palette, or find the identical palette already stored
+    /// Only colors 2-15 (RGB) are kept, as in SPRTZ files.
+    /// @param palette Full 64-byte palette (RGBA)
+    /// @param outPaletteID Output palette ID
+    /// @return false if the store already holds the maximum number of palettes
+    bool addPalette(const uint8_t* palette, uint16_t& outPaletteID);
+
+    /// Add a sprite
+    /// @param name Sprite name (must be unique within the store)
+    /// @param pixels Raw pixel data (width × height indices)
+    /// @param paletteMode Standard palette ID (0-31), or 0xFF for custom
+    /// @param palette Full 64-byte palette (RGBA), only read when paletteMode is 0xFF
+    /// @return true if added
+    bool addSprite(const std::string& name, int width, int height, const uint8_t* pixels,
+                   uint8_t paletteMode, const uint8_t* palette);
+
+    /// Add a SPRTZ file image (any version); standard palettes need not be loaded
+    bool addSPRTZ(const std::string& name, const uint8_t* data, size_t size);
+
+    /// Add a .sprtz file, named after its file name without extension
+    bool addFile(const std::string& path);
+
+    /// Add every .sprtz file in a directory (not recursive)
+    /// @return Number of files added, or -1 if the directory cannot be read
+    int addDirectory(const std::string& directory);
+
+    size_t getSpriteCount() const { return m_sprites.size(); }
+    size_t getPixelBlockCount() const { return m_blocks.size(); }
+    size_t getPaletteCount() const { return m_palettes.size() / PALETTE_SIZE; }
+
+    /// Get sprite record
+    /// @return Pointer to the record, or nullptr if invalid
+    const Sprite* getSprite(size_t index) const;
+
+    /// Find sprite by name
+    /// @return Sprite index, or -1 if not found
+    int findSprite(const std::string& name) const;
+
+    /// Get a pixel block
+    /// @return true if the ID is valid
+    bool getPixelBlock(uint32_t blockID, int& outWidth, int& outHeight, const uint8_t*& outPixels) const;
+
+    /// Build the 64-byte RGBA form of a custom palette
+    /// @return true if the ID is valid
+    bool getPalette(uint16_t paletteID, uint8_t* outPalette) const;
+
+    /// Build the pixels and palette of a sprite
+    /// @param outPixels Output pixel buffer (must be at least 40×40 = 1600 bytes)
+    /// @param outPalette Output palette buffer (must be 64 bytes)
+    /// @param outIsStandard Output: true if using standard palette, false if custom
+    /// @param outPaletteID Output: standard palette ID (0-31) or 0xFF if custom
+    /// @return true if successful (standard palettes must be loaded)
+    bool decodeSprite(size_t index, int& outWidth, int& outHeight,
+                      uint8_t* outPixels, uint8_t* outPalette,
+                      bool& outIsStandard, uint8_t& outPaletteID) const;
+
+    /// Deduplication totals for everything added so far
+    const SpriteStoreStats& getStats() const { return m_stats; }
+
+    /// Build the SPRTS image in memory (blocks encoded with the smallest codec)
+    void build(std::vector<uint8_t>& out) const;
+
+    /// Write the store with a single write call
+    bool write(const std::string& filename) const;
+
+    /// Replace the contents with an SPRTS image
+    /// @return true if successful (the store is left empty on failure)
+    bool loadMemory(const uint8_t* data, size_t size);
+
+    /// Replace the contents with an SPRTS file
+    bool load(const std::string& filename);
+
+    void clear();
+
+private:
+    static constexpr size_t PALETTE_SIZE = 42;
+
+    struct Block {
+        uint8_t width;
+        uint8_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    std::vector<Block> m_blocks;
+    std::vector<uint8_t> m_palettes;    // PALETTE_SIZE bytes per palette
+    std::vector<Sprite> m_sprites;
+    SpriteStoreStats m_stats;
+
+    // Content hash -> IDs with that hash (more than one only on a collision)
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_blockIndex;
+    std::unordered_map<uint64_t, std::vector<uint16_t>> m_paletteIndex;
+    std::unordered_map<std::string, size_t> m_names;
+
+    bool addPaletteRGB(const uint8_t* rgb, uint16_t& outPaletteID);
+    bool addRecord(const std::string& name, uint32_t blockID, uint8_t paletteMode, const uint8_t* rgb);
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_STORE_H
@@ -0,0 +1,185 @@
+//
+//  SpriteTrace.cpp
+//  SPRED - Sprite Editor
+//
+//  Trace counters and Chrome-trace JSON output
+//
+
+#include "SpriteTrace.h"
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SPRED {
+
+std::atomic<bool> SpriteTrace::s_enabled(false);
+std::atomic<bool> SpriteTrace::s_verbose(false);
+std::atomic<bool> SpriteTrace::s_capture(false);
+
+namespace {
+
+constexpr int STAGE_COUNT = static_cast<int>(TraceStage::Count);
+
+struct StageCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> nanoseconds{0};
+};
+
+struct TraceEvent {
+    TraceStage stage;
+    uint32_t threadID;
+    int64_t startNanoseconds;   // Relative to the trace epoch
+    uint64_t nanoseconds;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+};
+
+StageCounters g_counters[STAGE_COUNT];
+
+std::mutex g_eventMutex;
+std::vector<TraceEvent> g_events;
+size_t g_maxEvents = 1000000;
+std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+/// Small sequential thread IDs read better in trace viewers than hashed ones
+uint32_t currentThreadID() {
+    static std::atomic<uint32_t> nextID(1);
+    thread_local uint32_t id = nextID++;
+    return id;
+}
+
+} // namespace
+
+void SpriteTrace::setCaptureEvents(bool capture, size_t maxEvents) {
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_maxEvents = maxEvents;
+    if (capture && !s_capture.load(std::memory_order_relaxed)) {
+        g_epoch = std::chrono::steady_clock::now();
+    }
+    s_capture.store(capture, std::memory_order_relaxed);
+}
+
+void SpriteTrace::record(TraceStage stage, std::chrono::steady_clock::time_point start,
+                         uint64_t nanoseconds, uint64_t bytesIn, uint64_t bytesOut) {
+    int index = static_cast<int>(stage);
+    if (index < 0 || index >= STAGE_COUNT) {
+        return;
+    }
+
+    StageCounters& counters = g_counters[index];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+    counters.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+    counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    if (!s_capture.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    uint32_t threadID = currentThreadID();
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    if (g_events.size() < g_maxEvents) {
+        int64_t relative = std::chrono::duration_cast<std::chrono::nanoseconds>(start - g_epoch).count();
+        g_events.push_back({stage, threadID, relative, nanoseconds, bytesIn, bytesOut});
+    }
+}
+
+TraceCounters SpriteTrace::getCounters(TraceStage stage) {
+    TraceCounters result;
+    int index = static_cast<int>(stage);
+    if (index < 0 || index >= STAGE_COUNT) {
+        return result;
+    }
+
+    const StageCounters& counters = g_counters[index];
+    result.calls = counters.calls.load(std::memory_order_relaxed);
+    result.bytesIn = counters.bytesIn.load(std::memory_order_relaxed);
+    result.bytesOut = counters.bytesOut.load(std::memory_order_relaxed);
+    result.nanoseconds = counters.nanoseconds.load(std::memory_order_relaxed);
+    return result;
+}
+
+void SpriteTrace::reset() {
+    for (StageCounters& counters : g_counters) {
+        counters.calls.store(0, std::memory_order_relaxed);
+        counters.bytesIn.store(0, std::memory_order_relaxed);
+        counters.bytesOut.store(0, std::memory_order_relaxed);
+        counters.nanoseconds.store(0, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_events.clear();
+    g_epoch = std::chrono::steady_clock::now();
+}
+
+const char* SpriteTrace::getStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::Compress: return "Compress";
+        case TraceStage::Decompress: return "Decompress";
+        case TraceStage::ImportLoad: return "Import A: Load";
+        case TraceStage::ImportQuantize: return "Import B: Quantize";
+        case TraceStage::ImportCrop: return "Import C: Crop";
+        case TraceStage::ImportResize: return "Import D: Resize";
+        case TraceStage::ImportRequantize: return "Import E: Requantize";
+        case TraceStage::ImportPalette: return "Import F: Palette";
+        case TraceStage::ImportConvert: return "Import G: Convert";
+        case TraceStage::PaletteMatch: return "Palette Match";
+        case TraceStage::Count: break;
+    }
+    return "Unknown";
+}
+
+void SpriteTrace::printSummary(FILE* out) {
+    std::fprintf(out, "%-22s %10s %12s %12s %12s %10s\n",
+                 "Stage", "Calls", "Bytes In", "Bytes Out", "Total ms", "MB/s");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        TraceStage stage = static_cast<TraceStage>(i);
+        TraceCounters counters = getCounters(stage);
+        if (counters.calls == 0) {
+            continue;
+        }
+        double ms = counters.nanoseconds / 1e6;
+        double rate = counters.nanoseconds > 0
+            ? counters.bytesIn / (counters.nanoseconds / 1e9) / (1024.0 * 1024.0) : 0.0;
+        std::fprintf(out, "%-22s %10llu %12llu %12llu %12.3f %10.1f\n",
+                     getStageName(stage),
+                     static_cast<unsigned long long>(counters.calls),
+                     static_cast<unsigned long long>(counters.bytesIn),
+                     static_cast<unsigned long long>(counters.bytesOut),
+                     ms, rate);
+    }
+}
+
+bool SpriteTrace::writeChromeTrace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+
+    // Complete ("X") events; timestamps and durations are in microseconds
+    file << "{\"traceEvents\":[\n";
+    char line[256];
+    for (size_t i = 0; i < g_events.size(); i++) {
+        const TraceEvent& event = g_events[i];
+        std::snprintf(line, sizeof(line),
+                      "{\"name\":\"%s\",\"cat\":\"spred\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"pid\":1,\"tid\":%u,\"args\":{\"bytesIn\":%llu,\"bytesOut\":%llu}}%s\n",
+                      getStageName(event.stage),
+                      event.startNanoseconds / 1000.0,
+                      event.nanoseconds / 1000.0,
+                      event.threadID,
+                      static_cast<unsigned long long>(event.bytesIn),
+                      static_cast<unsigned long long>(event.bytesOut),
+                      i + 1 < g_events.size() ? "," : "");
+        file << line;
+    }
+    file << "],\"displayTimeUnit\":\"ns\"}\n";
+    return file.good();
+}
+
+} // namespace SPRED
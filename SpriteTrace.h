@@ -0,0 +1,146 @@
+//
+//  SpriteTrace.h
+//  SPRED - Sprite Editor
+//
+//  Lightweight per-stage counters and Chrome-trace capture for the
+//  SPRTZ codec and PNG import hot paths
+//
+
+#ifndef SPRED_SPRITE_TRACE_H
+#define SPRED_SPRITE_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/// Build with -DSPRED_ENABLE_TRACE=0 to compile every trace point out.
+/// When compiled in, tracing is off until enabled at runtime and a disabled
+/// trace point costs one relaxed load and a branch.
+#ifndef SPRED_ENABLE_TRACE
+#define SPRED_ENABLE_TRACE 1
+#endif
+
+namespace SPRED {
+
+/// Instrumented stages
+enum class TraceStage : uint8_t {
+    Compress = 0,       // SpriteCodecs encode (every codec trial)
+    Decompress,         // SpriteCodecs decode
+    ImportLoad,         // Step A: load source PNG
+    ImportQuantize,     // Step B: quantize source and key out background
+    ImportCrop,         // Step C: crop transparent borders
+    ImportResize,       // Step D: resize to target size
+    ImportRequantize,   // Step E: quantize resized image
+    ImportPalette,      // Step F: extract palette
+    ImportConvert,      // Step G: map pixels to palette indices
+    PaletteMatch,       // findClosestStandardPalette
+    Count
+};
+
+/// Aggregate counters for one stage
+struct TraceCounters {
+    uint64_t calls = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t nanoseconds = 0;
+};
+
+/// SpriteTrace - Process-wide trace switches, counters and event capture
+class SpriteTrace {
+public:
+    /// Enable per-stage counters (and event capture, if requested)
+    static void setEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /// Print diagnostic messages from SPRED_TRACE_LOG (off by default)
+    static void setVerbose(bool verbose) { s_verbose.store(verbose, std::memory_order_relaxed); }
+    static bool isVerbose() { return s_verbose.load(std::memory_order_relaxed); }
+
+    /// Keep individual events for writeChromeTrace (only while enabled)
+    /// @param maxEvents Events kept before further events are dropped
+    static void setCaptureEvents(bool capture, size_t maxEvents = 1000000);
+
+    /// Record one completed stage (called by TraceScope)
+    static void record(TraceStage stage, std::chrono::steady_clock::time_point start,
+                       uint64_t nanoseconds, uint64_t bytesIn, uint64_t bytesOut);
+
+    /// Snapshot of a stage's counters
+    static TraceCounters getCounters(TraceStage stage);
+
+    /// Clear counters and captured events
+    static void reset();
+
+    static const char* getStageName(TraceStage stage);
+
+    /// Print a table of every stage that was hit
+    static void printSummary(FILE* out = stdout);
+
+    /// Write captured events as Chrome trace JSON (chrome://tracing, Perfetto)
+    /// @return true if successful
+    static bool writeChromeTrace(const std::string& filename);
+
+private:
+    static std::atomic<bool> s_enabled;
+    static std::atomic<bool> s_verbose;
+    static std::atomic<bool> s_capture;
+};
+
+/// TraceScope - Times a stage from construction to end() or destruction
+class TraceScope {
+public:
+    explicit TraceScope(TraceStage stage)
+        : m_stage(stage)
+        , m_active(SpriteTrace::isEnabled())
+    {
+        if (m_active) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceScope() { end(); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void setBytes(uint64_t bytesIn, uint64_t bytesOut) {
+        m_bytesIn = bytesIn;
+        m_bytesOut = bytesOut;
+    }
+
+    void end() {
+        if (!m_active) {
+            return;
+        }
+        m_active = false;
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        SpriteTrace::record(m_stage, m_start,
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                            m_bytesIn, m_bytesOut);
+    }
+
+private:
+    TraceStage m_stage;
+    bool m_active;
+    uint64_t m_bytesIn = 0;
+    uint64_t m_bytesOut = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace SPRED
+
+#if SPRED_ENABLE_TRACE
+#define SPRED_TRACE_SCOPE(name, stage) SPRED::TraceScope name(stage)
+#define SPRED_TRACE_BYTES(name, bytesIn, bytesOut) name.setBytes((bytesIn), (bytesOut))
+#define SPRED_TRACE_END(name) name.end()
+#define SPRED_TRACE_LOG(...) \
+    do { if (SPRED::SpriteTrace::isVerbose()) std::printf(__VA_ARGS__); } while (0)
+#else
+#define SPRED_TRACE_SCOPE(name, stage) ((void)0)
+#define SPRED_TRACE_BYTES(name, bytesIn, bytesOut) ((void)0)
+#define SPRED_TRACE_END(name) ((void)0)
+#define SPRED_TRACE_LOG(...) ((void)0)
+#endif
+
+#endif // SPRED_SPRITE_TRACE_H
@@ -0,0 +1,155 @@
+//
+//  SpriteTransform.cpp
+//  SPRED - Sprite Editor
+//
+//  Sprite symmetry and shift kernels
+//
+
+#include "SpriteTransform.h"
+#include "SpriteData.h"
+#include <cstring>
+
+namespace SPRED {
+
+namespace {
+
+/// dst(x', y') for each orientation, with (w, h) the source size.
+/// FixedW / FixedH > 0 make the bounds compile-time constants.
+template <int FixedW, int FixedH>
+void transformKernel(const uint8_t* src, int width, int height, SpriteOrientation orientation, uint8_t* dst) {
+    const int w = FixedW > 0 ? FixedW : width;
+    const int h = FixedH > 0 ? FixedH : height;
+
+    switch (orientation) {
+        case SpriteOrientation::Identity:
+            std::memcpy(dst, src, size_t(w) * h);
+            break;
+        case SpriteOrientation::FlipHorizontal:
+            for (int y = 0; y < h; y++) {
+                const uint8_t* row = src + y * w;
+                uint8_t* out = dst + y * w;
+                for (int x = 0; x < w; x++) {
+                    out[x] = row[w - 1 - x];
+                }
+            }
+            break;
+        case SpriteOrientation::FlipVertical:
+            for (int y = 0; y < h; y++) {
+                std::memcpy(dst + y * w, src + (h - 1 - y) * w, w);
+            }
+            break;
+        case SpriteOrientation::Rotate180:
+            for (int y = 0; y < h; y++) {
+                const uint8_t* row = src + (h - 1 - y) * w;
+                uint8_t* out = dst + y * w;
+                for (int x = 0; x < w; x++) {
+                    out[x] = row[w - 1 - x];
+                }
+            }
+            break;
+
+        // Output is h wide and w tall; walk the source row by row so reads stay sequential
+        case SpriteOrientation::Transpose:          // dst(x', y') = src(y', x')
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    dst[x * h + y] = src[y * w + x];
+                }
+            }
+            break;
+        case SpriteOrientation::Rotate90CW:         // dst(x', y') = src(y', h - 1 - x')
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    dst[x * h + (h - 1 - y)] = src[y * w + x];
+                }
+            }
+            break;
+        case SpriteOrientation::Rotate90CCW:        // dst(x', y') = src(w - 1 - y', x')
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    dst[(w - 1 - x) * h + y] = src[y * w + x];
+                }
+            }
+            break;
+        case SpriteOrientation::AntiTranspose:      // dst(x', y') = src(w - 1 - y', h - 1 - x')
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    dst[(w - 1 - x) * h + (h - 1 - y)] = src[y * w + x];
+                }
+            }
+            break;
+    }
+}
+
+/// Wrap a shift amount into [0, size)
+int wrap(int value, int size) {
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+} // anonymous namespace
+
+SpriteOrientation SpriteTransform::inverse(SpriteOrientation orientation) {
+    switch (orientation) {
+        case SpriteOrientation::Rotate90CW:
+            return SpriteOrientation::Rotate90CCW;
+        case SpriteOrientation::Rotate90CCW:
+            return SpriteOrientation::Rotate90CW;
+        default:
+            return orientation;     // Flips, transposes and 180° undo themselves
+    }
+}
+
+void SpriteTransform::apply(const uint8_t* src, int width, int height, SpriteOrientation orientation,
+                            uint8_t* dst) {
+    if (width == 8 && height == 8) {
+        transformKernel<8, 8>(src, width, height, orientation, dst);
+    } else if (width == 16 && height == 16) {
+        transformKernel<16, 16>(src, width, height, orientation, dst);
+    } else if (width == 40 && height == 40) {
+        transformKernel<40, 40>(src, width, height, orientation, dst);
+    } else {
+        transformKernel<0, 0>(src, width, height, orientation, dst);
+    }
+}
+
+void SpriteTransform::shift(const uint8_t* src, int width, int height, int dx, int dy, uint8_t* dst) {
+    // Each destination row is its source row rotated right by dx: two copies
+    dx = wrap(dx, width);
+    dy = wrap(dy, height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + size_t(wrap(y - dy, height)) * width;
+        uint8_t* out = dst + size_t(y) * width;
+        std::memcpy(out + dx, row, width - dx);
+        std::memcpy(out, row + width - dx, dx);
+    }
+}
+
+// ============================================================================
+// Orientation set
+// ============================================================================
+
+void SpriteOrientationSet::build(const SpriteData& sprite) {
+    m_width = sprite.getWidth();
+    m_height = sprite.getHeight();
+    m_source = &sprite;
+    m_generation = sprite.getGeneration();
+
+    const size_t pixelCount = size_t(m_width) * m_height;
+    m_pixels.resize(pixelCount * SPRITE_ORIENTATION_COUNT);
+    uint8_t scratch[MAX_SPRITE_PIXELS];
+    const uint8_t* pixels = sprite.getUnpackedPixels(scratch);
+    for (int o = 0; o < SPRITE_ORIENTATION_COUNT; o++) {
+        SpriteTransform::apply(pixels, m_width, m_height, static_cast<SpriteOrientation>(o),
+                               &m_pixels[o * pixelCount]);
+    }
+}
+
+bool SpriteOrientationSet::update(const SpriteData& sprite) {
+    if (m_source == &sprite && m_generation == sprite.getGeneration() && !m_pixels.empty()) {
+        return false;
+    }
+    build(sprite);
+    return true;
+}
+
+} // namespace SPRED
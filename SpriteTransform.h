@@ -0,0 +1,104 @@
+//
+//  SpriteTransform.h
+//  SPRED - Sprite Editor
+//
+//  Flip, rotate and shift kernels plus cached orientation sets
+//
+
+#ifndef SPRED_SPRITE_TRANSFORM_H
+#define SPRED_SPRITE_TRANSFORM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPRED {
+
+class SpriteData;
+
+/// The eight symmetries of a sprite (dihedral group D4)
+enum class SpriteOrientation : uint8_t {
+    Identity = 0,
+    FlipHorizontal = 1,     // Mirror left-right
+    FlipVertical = 2,       // Mirror top-bottom
+    Rotate180 = 3,          // Both flips
+    Transpose = 4,          // Mirror across the main diagonal
+    Rotate90CW = 5,
+    Rotate90CCW = 6,
+    AntiTranspose = 7       // Mirror across the other diagonal
+};
+
+/// Number of SpriteOrientation values
+constexpr int SPRITE_ORIENTATION_COUNT = 8;
+
+/// SpriteTransform - Index-buffer kernels for sprite symmetries and shifts
+///
+/// Orientations 0-3 keep the size; 4-7 swap width and height. The low two
+/// bits of orientations 0-3 match the SpriteFlip flags of SpriteCompositor.
+/// The 8x8, 16x16 and 40x40 sprite sizes get kernels with compile-time
+/// bounds, which the compiler unrolls and vectorizes; other sizes use the
+/// same loops with runtime bounds.
+class SpriteTransform {
+public:
+    /// True if the orientation swaps width and height
+    static bool swapsAxes(SpriteOrientation orientation) {
+        return static_cast<uint8_t>(orientation) >= static_cast<uint8_t>(SpriteOrientation::Transpose);
+    }
+
+    /// Orientation that undoes another
+    static SpriteOrientation inverse(SpriteOrientation orientation);
+
+    /// Transform byte-per-pixel indices
+    /// @param src Input indices (width × height)
+    /// @param dst Output indices (width × height, must not overlap src)
+    static void apply(const uint8_t* src, int width, int height, SpriteOrientation orientation, uint8_t* dst);
+
+    /// Shift with wrap-around: the pixel at (x, y) moves to (x + dx, y + dy)
+    /// @param dst Output indices (width × height, must not overlap src)
+    static void shift(const uint8_t* src, int width, int height, int dx, int dy, uint8_t* dst);
+};
+
+/// SpriteOrientationSet - All eight orientations of one sprite, precomputed
+///
+/// Flipped and rotated draws read the stored orientation directly instead
+/// of remapping pixels per frame. update() rebuilds only when the source
+/// sprite's generation has changed.
+///
+/// Usage:
+///   SpriteOrientationSet orientations;
+///   orientations.update(ship);                            // Once, and after edits
+///   const uint8_t* pixels = orientations.getPixels(SpriteOrientation::Rotate90CW);
+class SpriteOrientationSet {
+public:
+    /// Compute every orientation of a sprite
+    void build(const SpriteData& sprite);
+
+    /// Rebuild if the sprite is a different object or has been edited since
+    /// @return true if the set was rebuilt
+    bool update(const SpriteData& sprite);
+
+    /// Indices of one orientation (getWidth × getHeight bytes)
+    const uint8_t* getPixels(SpriteOrientation orientation) const {
+        return m_pixels.data() + static_cast<size_t>(orientation) * m_width * m_height;
+    }
+    int getWidth(SpriteOrientation orientation) const {
+        return SpriteTransform::swapsAxes(orientation) ? m_height : m_width;
+    }
+    int getHeight(SpriteOrientation orientation) const {
+        return SpriteTransform::swapsAxes(orientation) ? m_width : m_height;
+    }
+
+    /// Bytes held for all eight orientations
+    size_t getMemoryUsage() const { return m_pixels.size(); }
+
+private:
+    int m_width = 0;                        // Identity size
+    int m_height = 0;
+    std::vector<uint8_t> m_pixels;          // Eight orientations back to back
+    const SpriteData* m_source = nullptr;
+    uint64_t m_generation = 0;
+};
+
+} // namespace SPRED
+
+#endif // SPRED_SPRITE_TRANSFORM_H
@@ -0,0 +1,513 @@
+//
+//  sprtz_tool.cpp
+//  SPRED - SPRTZ / SPRTB Command Line Tool
+//
+//  Packs directories of .sprtz files into SPRTB banks, inspects banks and
+//  re-encodes sprite libraries
+//
+
+#include "PNGConverter.h"
+#include "SpriteAtlas.h"
+#include "SpriteBank.h"
+#include "SpriteBatchEncoder.h"
+#include "SpriteData.h"
+#include "SpriteDictionary.h"
+#include "SpriteStore.h"
+#include "SpriteTrace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace SPRED;
+
+/// Dictionary loaded with --dict (0 = none)
+uint8_t g_dictionaryID = 0;
+
+void printUsage(const char* programName) {
+    std::cout << "SPRTZ Tool\n";
+    std::cout << "==========\n\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << programName << " pack <sprite_dir> <output.sprtb>\n";
+    std::cout << "  " << programName << " list <bank.sprtb>\n";
+    std::cout << "  " << programName << " verify <bank.sprtb>\n";
+    std::cout << "  " << programName << " reencode <sprite_dir> <output_dir> [codec] [threads]\n";
+    std::cout << "  " << programName << " train-dict <sprite_dir> <output.sprtd> [id] [max_bytes]\n";
+    std::cout << "  " << programName << " dedup-report <sprite_dir> [output.sprts]\n";
+    std::cout << "  " << programName << " atlas <sprite_dir> <output_prefix> [page_size] [indexed|rgba]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  pack        Pack every .sprtz file in a directory into one bank\n";
+    std::cout << "  list        Print the index of a bank\n";
+    std::cout << "  verify      Decode every entry of a bank and check its content hash\n";
+    std::cout << "  reencode    Re-encode every .sprtz file in a directory as SPRTZ v3\n";
+    std::cout << "  train-dict  Train a preset zlib dictionary (default id 1, 4096 bytes)\n";
+    std::cout << "  dedup-report Report duplicate pixel data and palettes (optionally write a store)\n";
+    std::cout << "  atlas       Pack sprites into pages (default 1024, indexed) plus an .spta table\n\n";
+    std::cout << "Codecs: smallest (default), fastest, stored, rle, zlib, lz, masked\n";
+    std::cout << "Threads: 0 = one per core (default)\n\n";
+    std::cout << "Options (any command):\n";
+    std::cout << "  --dict <file.sprtd>  Register a dictionary (reencode compresses with it)\n";
+    std::cout << "  --trace <file.json>  Print per-stage counters and write a Chrome trace\n";
+    std::cout << "  --verbose            Print diagnostic messages\n";
+}
+
+bool parseCodec(const std::string& name, SPRTZCodec& outCodec) {
+    const SPRTZCodec codecs[] = {SPRTZCodec::AutoSmallest, SPRTZCodec::AutoFastest, SPRTZCodec::Stored,
+                                 SPRTZCodec::RLE, SPRTZCodec::Zlib, SPRTZCodec::LZ, SPRTZCodec::Masked};
+    const char* names[] = {"smallest", "fastest", "stored", "rle", "zlib", "lz", "masked"};
+    for (int i = 0; i < 7; i++) {
+        if (name == names[i]) {
+            outCodec = codecs[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Parse a whole decimal argument (no trailing text, no overflow)
+bool parseNumber(const char* text, long& outValue) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    outValue = value;
+    return true;
+}
+
+int packBank(const std::string& directory, const std::string& output) {
+    SpriteBankWriter writer;
+    int added = writer.addDirectory(directory);
+    if (added < 0) {
+        std::cerr << "Failed to read directory: " << directory << "\n";
+        return 1;
+    }
+
+    if (!writer.write(output)) {
+        std::cerr << "Failed to write bank: " << output << "\n";
+        return 1;
+    }
+
+    std::cout << "[OK] Packed " << added << " sprites into " << output << "\n";
+    return 0;
+}
+
+int listBank(const std::string& filename) {
+    SpriteBankReader reader;
+    if (!reader.open(filename)) {
+        std::cerr << "Failed to open bank: " << filename << "\n";
+        return 1;
+    }
+
+    std::cout << "Bank: " << filename << " (" << reader.getEntryCount() << " entries)\n\n";
+    std::cout << "  Index  Size   Bytes  Palette  Name\n";
+    for (uint32_t i = 0; i < reader.getEntryCount(); i++) {
+        const SpriteBankEntry* entry = reader.getEntry(i);
+        std::string size = std::to_string(entry->width) + "x" + std::to_string(entry->height);
+        std::string palette = entry->paletteMode == 0xFF ? "custom" : std::to_string(entry->paletteMode);
+        std::cout << "  " << std::setw(5) << i
+                  << "  " << std::setw(5) << size
+                  << "  " << std::setw(5) << entry->size
+                  << "  " << std::setw(7) << palette
+                  << "  " << reader.getEntryName(i) << "\n";
+    }
+    return 0;
+}
+
+int verifyBank(const std::string& filename) {
+    SpriteBankReader reader;
+    if (!reader.open(filename)) {
+        std::cerr << "Failed to open bank: " << filename << "\n";
+        return 1;
+    }
+
+    uint32_t hashed = 0;
+    for (uint32_t i = 0; i < reader.getEntryCount(); i++) {
+        uint64_t hash;
+        if (reader.getContentHash(i, hash)) {
+            hashed++;
+        }
+    }
+
+    std::vector<uint32_t> failed;
+    reader.validate(failed);
+    for (uint32_t index : failed) {
+        std::cout << "  [FAIL] " << index << "  " << reader.getEntryName(index) << "\n";
+    }
+
+    std::cout << (failed.empty() ? "[OK] " : "[FAIL] ")
+              << reader.getEntryCount() - failed.size() << "/" << reader.getEntryCount()
+              << " entries valid (" << hashed << " with content hash)\n";
+    return failed.empty() ? 0 : 1;
+}
+
+/// List the .sprtz files in a directory, sorted by path
+bool listSpriteFiles(const std::string& directory, std::vector<std::filesystem::path>& outPaths) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory, ec);
+    if (ec) {
+        std::cerr << "Failed to read directory: " << directory << "\n";
+        return false;
+    }
+
+    outPaths.clear();
+    for (const auto& dirEntry : it) {
+        if (dirEntry.is_regular_file() && dirEntry.path().extension() == ".sprtz") {
+            outPaths.push_back(dirEntry.path());
+        }
+    }
+    std::sort(outPaths.begin(), outPaths.end());
+    return true;
+}
+
+int reencodeDirectory(const std::string& directory, const std::string& output,
+                      SPRTZCodec codec, int threadCount) {
+    std::vector<std::filesystem::path> paths;
+    if (!listSpriteFiles(directory, paths)) {
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(output, ec);
+
+    // Load everything first so the encoder timing covers encoding and writing only
+    std::vector<SpriteData> sprites(paths.size());
+    SpriteBatchEncoder encoder(codec, threadCount);
+    encoder.setDictionaryID(g_dictionaryID);
+    int skipped = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        bool isStandard;
+        uint8_t paletteID;
+        if (!sprites[i].loadSPRTZv2(paths[i].string(), isStandard, paletteID)) {
+            std::cerr << "Skipping unreadable sprite: " << paths[i].string() << "\n";
+            skipped++;
+            continue;
+        }
+        std::filesystem::path target = std::filesystem::path(output) / paths[i].filename();
+        encoder.addSprite(target.string(), sprites[i], isStandard ? paletteID : 0xFF);
+    }
+
+    bool ok = encoder.writeFiles();
+    const SpriteBatchStats& stats = encoder.getStats();
+    std::cout << (ok ? "[OK]" : "[FAIL]") << " Re-encoded " << stats.spriteCount << " sprites ("
+              << SpriteCodecs::getCodecName(codec) << ")";
+    if (stats.failedCount > 0 || skipped > 0) {
+        std::cout << ", " << stats.failedCount << " failed, " << skipped << " skipped";
+    }
+    std::cout << "\n";
+    std::cout << "  " << stats.inputBytes << " pixel bytes -> " << stats.outputBytes << " file bytes in "
+              << std::fixed << std::setprecision(3) << stats.seconds * 1000.0 << " ms ("
+              << std::setprecision(1) << stats.getMegabytesPerSecond() << " MB/s)\n";
+    return ok ? 0 : 1;
+}
+
+int trainDictionary(const std::string& directory, const std::string& output,
+                    uint8_t dictionaryID, size_t maxSize) {
+    std::vector<std::filesystem::path> paths;
+    if (!listSpriteFiles(directory, paths)) {
+        return 1;
+    }
+
+    // Hold out every 5th sprite so the report measures unseen sprites
+    std::vector<std::vector<uint8_t>> training;
+    std::vector<std::vector<uint8_t>> holdout;
+    std::vector<std::pair<int, int>> trainingSizes;
+    std::vector<std::pair<int, int>> holdoutSizes;
+    size_t loaded = 0;
+    for (const std::filesystem::path& path : paths) {
+        SpriteData sprite;
+        bool isStandard;
+        uint8_t paletteID;
+        if (!sprite.loadSPRTZv2(path.string(), isStandard, paletteID)) {
+            std::cerr << "Skipping unreadable sprite: " << path.string() << "\n";
+            continue;
+        }
+        uint8_t scratch[MAX_SPRITE_PIXELS];
+        const uint8_t* pixels = sprite.getUnpackedPixels(scratch);
+        std::vector<uint8_t> sample(pixels, pixels + sprite.getWidth() * sprite.getHeight());
+        std::pair<int, int> size(sprite.getWidth(), sprite.getHeight());
+
+        bool hold = paths.size() >= 20 && loaded % 5 == 4;
+        (hold ? holdout : training).push_back(sample);
+        (hold ? holdoutSizes : trainingSizes).push_back(size);
+        loaded++;
+    }
+
+    std::vector<uint8_t> dictionary;
+    if (!SpriteDictionary::train(training, maxSize, dictionary)) {
+        std::cerr << "Not enough sprite data to train a dictionary\n";
+        return 1;
+    }
+    if (!SpriteDictionary::saveFile(output, dictionaryID, dictionary.data(), dictionary.size()) ||
+        !SpriteDictionary::registerDictionary(dictionaryID, dictionary.data(), dictionary.size())) {
+        std::cerr << "Failed to write dictionary: " << output << "\n";
+        return 1;
+    }
+    std::cout << "[OK] Trained dictionary " << int(dictionaryID) << " (" << dictionary.size()
+              << " bytes) from " << training.size() << " sprites into " << output << "\n";
+
+    // Zlib payload size with and without the dictionary, per sprite size class
+    bool inSample = holdout.empty();
+    const std::vector<std::vector<uint8_t>>& report = inSample ? training : holdout;
+    const std::vector<std::pair<int, int>>& reportSizes = inSample ? trainingSizes : holdoutSizes;
+
+    struct SizeClass { size_t count = 0; size_t raw = 0; size_t plain = 0; size_t primed = 0; };
+    std::map<std::pair<int, int>, SizeClass> classes;
+    std::vector<uint8_t> payload;
+    for (size_t i = 0; i < report.size(); i++) {
+        const std::vector<uint8_t>& sample = report[i];
+        int pixelCount = static_cast<int>(sample.size());
+        SizeClass& sizeClass = classes[reportSizes[i]];
+        sizeClass.count++;
+        sizeClass.raw += sample.size();
+        SpriteCodecs::encode(SPRTZCodec::Zlib, sample.data(), pixelCount, payload);
+        sizeClass.plain += payload.size();
+        SpriteCodecs::encode(SPRTZCodec::Zlib, sample.data(), pixelCount, payload, nullptr, dictionaryID);
+        sizeClass.primed += payload.size();
+    }
+
+    std::cout << "\nZlib payload size (" << (inSample ? "training sprites" : "held-out sprites") << ")\n";
+    std::cout << "  Size     Count   Raw avg   Plain avg   Dict avg   Gain\n";
+    for (const auto& entry : classes) {
+        const SizeClass& sizeClass = entry.second;
+        double plain = double(sizeClass.plain) / sizeClass.count;
+        double primed = double(sizeClass.primed) / sizeClass.count;
+        std::string size = std::to_string(entry.first.first) + "x" + std::to_string(entry.first.second);
+        std::cout << "  " << std::left << std::setw(7) << size << std::right
+                  << std::setw(7) << sizeClass.count
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << double(sizeClass.raw) / sizeClass.count
+                  << std::setw(12) << plain
+                  << std::setw(11) << primed
+                  << std::setw(6) << (100.0 * (plain - primed) / plain) << "%\n";
+    }
+    return 0;
+}
+
+int dedupReport(const std::string& directory, const std::string& output) {
+    std::vector<std::filesystem::path> paths;
+    if (!listSpriteFiles(directory, paths)) {
+        return 1;
+    }
+
+    SpriteStore store;
+    uint64_t fileBytes = 0;
+    size_t failed = 0;
+    for (const std::filesystem::path& path : paths) {
+        if (store.addFile(path.string())) {
+            fileBytes += std::filesystem::file_size(path);
+        } else {
+            failed++;
+        }
+    }
+
+    const SpriteStoreStats& stats = store.getStats();
+    std::vector<uint8_t> image;
+    store.build(image);
+
+    std::cout << "Directory: " << directory << " (" << stats.spriteCount << " sprites";
+    if (failed > 0) {
+        std::cout << ", " << failed << " unreadable";
+    }
+    std::cout << ")\n\n";
+    std::cout << "  Pixel blocks:  " << stats.pixelBlockCount << " unique of " << stats.spriteCount
+              << "  (" << stats.uniquePixelBytes << " of " << stats.pixelBytes << " bytes)\n";
+    std::cout << "  Palettes:      " << stats.paletteCount << " unique of " << stats.customPaletteRefs
+              << " custom  (" << stats.uniquePaletteBytes << " of " << stats.paletteBytes << " bytes)\n";
+    std::cout << "  Dedup ratio:   " << std::fixed << std::setprecision(2) << stats.getDedupRatio() << "x\n";
+    std::cout << "  .sprtz files:  " << fileBytes << " bytes\n";
+    std::cout << "  SPRTS store:   " << image.size() << " bytes";
+    if (fileBytes > 0) {
+        std::cout << " (" << std::setprecision(1) << (100.0 * image.size() / fileBytes) << "%)";
+    }
+    std::cout << "\n";
+
+    if (!output.empty()) {
+        if (!store.write(output)) {
+            std::cerr << "Failed to write store: " << output << "\n";
+            return 1;
+        }
+        std::cout << "\n[OK] Wrote " << output << "\n";
+    }
+    return 0;
+}
+
+int buildAtlas(const std::string& directory, const std::string& prefix, int pageSize, bool indexed) {
+    std::vector<std::filesystem::path> paths;
+    if (!listSpriteFiles(directory, paths)) {
+        return 1;
+    }
+
+    // Sprites stay in place while the builder holds pointers to them
+    std::vector<SpriteData> sprites(paths.size());
+    SpriteAtlasBuilder atlas(pageSize, pageSize);
+    for (size_t i = 0; i < paths.size(); i++) {
+        bool isStandard;
+        uint8_t paletteID;
+        if (!sprites[i].loadSPRTZv2(paths[i].string(), isStandard, paletteID)) {
+            std::cerr << "Skipping unreadable sprite: " << paths[i].string() << "\n";
+            continue;
+        }
+        atlas.addSprite(sprites[i]);
+    }
+
+    if (!atlas.build()) {
+        std::cerr << "Sprites do not fit a " << pageSize << "x" << pageSize << " page\n";
+        return 1;
+    }
+
+    AtlasPageFormat format = indexed ? AtlasPageFormat::Indexed4 : AtlasPageFormat::RGBA;
+    std::string tablePath = prefix + ".spta";
+    if (!atlas.writeTable(tablePath, format)) {
+        std::cerr << "Failed to write atlas table: " << tablePath << "\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> pixels;
+    for (int page = 0; page < atlas.getPageCount(); page++) {
+        std::string pagePath = prefix + "_" + std::to_string(page);
+        bool written;
+        if (indexed) {
+            pagePath += ".bin";
+            atlas.buildIndexedPage(page, pixels);
+            std::ofstream file(pagePath, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+            written = file.good();
+        } else {
+            pagePath += ".png";
+            atlas.buildRGBAPage(page, SurfaceFormat::RGBA, pixels);
+            written = PNGConverter::savePNGFile(pagePath, pixels.data(), pageSize, pageSize);
+        }
+        if (!written) {
+            std::cerr << "Failed to write page: " << pagePath << "\n";
+            return 1;
+        }
+        std::cout << "  " << pagePath << "  " << std::fixed << std::setprecision(1)
+                  << (100.0 * atlas.getPageOccupancy(page)) << "% occupied\n";
+    }
+
+    const AtlasStats& stats = atlas.getStats();
+    std::cout << "\n[OK] Packed " << stats.spriteCount << " sprites into " << stats.pageCount
+              << " pages (" << std::setprecision(1)
+              << (100.0 * stats.getOccupancy(atlas.getPageWidth(), atlas.getPageHeight()))
+              << "% occupied, " << stats.paletteCount << " palettes, "
+              << std::setprecision(2) << (stats.seconds * 1000.0) << " ms)\n";
+    std::cout << "[OK] Wrote " << tablePath << "\n";
+    return 0;
+}
+
+int runCommand(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "pack" && argc >= 4) {
+        return packBank(argv[2], argv[3]);
+    }
+    if (command == "list") {
+        return listBank(argv[2]);
+    }
+    if (command == "verify") {
+        return verifyBank(argv[2]);
+    }
+    if (command == "reencode" && argc >= 4) {
+        SPRTZCodec codec = SPRTZCodec::AutoSmallest;
+        if (argc >= 5 && !parseCodec(argv[4], codec)) {
+            std::cerr << "Unknown codec: " << argv[4] << "\n";
+            return 1;
+        }
+        long threadCount = 0;
+        if (argc >= 6 && (!parseNumber(argv[5], threadCount) || threadCount < 0 || threadCount > 256)) {
+            std::cerr << "Thread count must be a number from 0 to 256: " << argv[5] << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        return reencodeDirectory(argv[2], argv[3], codec, static_cast<int>(threadCount));
+    }
+    if (command == "dedup-report") {
+        return dedupReport(argv[2], argc >= 4 ? argv[3] : "");
+    }
+    if (command == "atlas" && argc >= 4) {
+        long pageSize = 1024;
+        std::string format = argc >= 6 ? argv[5] : "indexed";
+        if (argc >= 5 && !parseNumber(argv[4], pageSize)) {
+            pageSize = 0;
+        }
+        if (pageSize < 40 || pageSize > 8192 || (pageSize & 1)) {
+            std::cerr << "Page size must be an even number from 40 to 8192\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (format != "indexed" && format != "rgba") {
+            std::cerr << "Unknown page format: " << format << "\n";
+            return 1;
+        }
+        return buildAtlas(argv[2], argv[3], static_cast<int>(pageSize), format == "indexed");
+    }
+    if (command == "train-dict" && argc >= 4) {
+        long dictionaryID = 1;
+        long maxSize = 4096;
+        if (argc >= 5 && (!parseNumber(argv[4], dictionaryID) || dictionaryID < 1 || dictionaryID > 255)) {
+            std::cerr << "Dictionary id must be 1-255\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (argc >= 6 && (!parseNumber(argv[5], maxSize) || maxSize < 1)) {
+            std::cerr << "Dictionary size must be a positive number of bytes: " << argv[5] << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        return trainDictionary(argv[2], argv[3], static_cast<uint8_t>(dictionaryID), static_cast<size_t>(maxSize));
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    // Strip global options so commands only see their own arguments
+    std::string traceFile;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg == "--dict" && i + 1 < argc) {
+            if (!SpriteDictionary::loadFile(argv[++i], g_dictionaryID)) {
+                std::cerr << "Failed to load dictionary: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--verbose") {
+            SpriteTrace::setVerbose(true);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (!traceFile.empty()) {
+        SpriteTrace::setEnabled(true);
+        SpriteTrace::setCaptureEvents(true);
+    }
+
+    int result = runCommand(static_cast<int>(args.size()), args.data());
+
+    if (!traceFile.empty()) {
+        std::cout << "\n";
+        SpriteTrace::printSummary(stdout);
+        if (SpriteTrace::writeChromeTrace(traceFile)) {
+            std::cout << "[OK] Wrote trace: " << traceFile << "\n";
+        } else {
+            std::cerr << "Failed to write trace: " << traceFile << "\n";
+        }
+    }
+    return result;
+}
@@ -6,6 +6,9 @@
 //
 
 #include "PNGConverter.h"
+#include "PNGCodec.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -19,14 +22,16 @@ void printUsage(const char* programName) {
     std::cout << "Usage: " << programName << " <input.png> [target_width] [target_height]\n\n";
     std::cout << "This tool will:\n";
     std::cout << "  1. Load the input PNG\n";
-    std::cout << "  2. Test all 4 scaling methods:\n";
+    std::cout << "  2. Test all 5 scaling methods:\n";
     std::cout << "     - vImage (Accelerate/SIMD)\n";
     std::cout << "     - ImageIO (CoreGraphics)\n";
     std::cout << "     - CoreImage (GPU)\n";
     std::cout << "     - NSImage (original)\n";
+    std::cout << "     - AreaAverage (portable SIMD box filter)\n";
     std::cout << "  3. Benchmark each method's performance\n";
-    std::cout << "  4. Output scaled images to /tmp/spred_resized_*.png\n";
-    std::cout << "  5. Recommend the best method for your image\n\n";
+    std::cout << "  4. Benchmark the portable PNG decoder/encoder on the same image\n";
+    std::cout << "  5. Output scaled images to /tmp/spred_resized_*.png\n";
+    std::cout << "  6. Recommend the best method for your image\n\n";
     std::cout << "Default target size: 40x30 (SPRED sprite)\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << programName << " myimage.png\n";
@@ -74,7 +79,13 @@ void printMethodInfo() {
     std::cout << "   * Simple to use\n";
     std::cout << "   * Good quality\n";
     std::cout << "   * More overhead than other methods\n";
-    std::cout << "   * Best for: Simple cases, compatibility\n";
+    std::cout << "   * Best for: Simple cases, compatibility\n\n";
+    
+    std::cout << "[5] AreaAverage (Portable)\n";
+    std::cout << "   * Exact box filter: every source pixel weighted by its coverage\n";
+    std::cout << "   * Premultiplied alpha, so transparent pixels do not darken edges\n";
+    std::cout << "   * SSE2/NEON, no framework dependencies (runs on Linux)\n";
+    std::cout << "   * Best for: Large images shrunk to sprite size\n";
 }
 
 void testIndividualMethod(const std::string& methodName,
@@ -194,6 +205,64 @@ void compareLoadMethods(const std::string& filename) {
     }
 }
 
+void comparePortableCodec(const std::string& filename, const std::vector<uint8_t>& rgba,
+                          int width, int height) {
+    printHeader("PORTABLE PNG CODEC (zlib, row by row)");
+
+    const double megabytes = double(width) * height * 4 / 1024.0 / 1024.0;
+    // About 64 MB of pixels per measurement, capped for tiny images
+    const int passes = std::max(1, std::min(200, static_cast<int>(64.0 / megabytes)));
+
+    printSection("Decode");
+    std::vector<uint8_t> decoded(rgba.size());
+    bool decodeOK = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int pass = 0; pass < passes && decodeOK; pass++) {
+        PNGDecoder decoder;
+        decodeOK = decoder.open(filename) && decoder.getWidth() == width && decoder.getHeight() == height &&
+                   decoder.readImage(decoded.data(), size_t(width) * 4);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    if (decodeOK) {
+        double seconds = elapsed.count() / passes;
+        std::cout << "[OK] " << std::fixed << std::setprecision(3) << (seconds * 1000.0) << " ms per decode\n";
+        std::cout << "  Throughput: " << std::setprecision(2) << (megabytes / seconds) << " MB/s (RGBA out)\n";
+        if (decoded != rgba) {
+            std::cout << "  [WARN] Pixels differ from loadPNGFile_ImageIO (color management or 16-bit rounding)\n";
+        }
+    } else {
+        std::cout << "[FAIL] Failed\n";
+    }
+
+    printSection("Encode");
+    const std::string output = "/tmp/spred_portable_encode.png";
+    bool encodeOK = true;
+    start = std::chrono::high_resolution_clock::now();
+    for (int pass = 0; pass < passes && encodeOK; pass++) {
+        PNGEncoder encoder;
+        encodeOK = encoder.open(output, width, height);
+        for (int y = 0; y < height && encodeOK; y++) {
+            encodeOK = encoder.writeRow(rgba.data() + size_t(y) * width * 4);
+        }
+        encodeOK = encodeOK && encoder.finish();
+    }
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+    if (encodeOK) {
+        double seconds = elapsed.count() / passes;
+        std::cout << "[OK] " << std::fixed << std::setprecision(3) << (seconds * 1000.0) << " ms per encode\n";
+        std::cout << "  Throughput: " << std::setprecision(2) << (megabytes / seconds) << " MB/s (RGBA in)\n";
+        std::cout << "  Output: " << output << "\n";
+
+        PNGDecoder check;
+        std::vector<uint8_t> roundTrip(rgba.size());
+        if (!check.open(output) || !check.readImage(roundTrip.data(), size_t(width) * 4) || roundTrip != rgba) {
+            std::cout << "  [FAIL] Encoded file does not decode to the source pixels\n";
+        }
+    } else {
+        std::cout << "[FAIL] Failed\n";
+    }
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         printUsage(argv[0]);
@@ -252,6 +321,9 @@ int main(int argc, char* argv[]) {
     testIndividualMethod("NSImage (Original)", PNGScalingMethod::NSImage,
                         rgba, width, height, targetWidth, targetHeight);
     
+    testIndividualMethod("AreaAverage (Portable SIMD)", PNGScalingMethod::AreaAverage,
+                        rgba, width, height, targetWidth, targetHeight);
+    
     // Test Core Image filters
     testWithFilters(rgba, width, height, targetWidth, targetHeight);
     
@@ -264,13 +336,17 @@ int main(int argc, char* argv[]) {
         results
     );
     
+    // Portable codec on the same image
+    comparePortableCodec(inputFile, rgba, width, height);
+    
     // Output files info
     printHeader("OUTPUT FILES");
     std::cout << "\n[FILES] Generated files in /tmp/:\n";
     std::cout << "   * spred_resized_vimage.png    - vImage result\n";
     std::cout << "   * spred_resized_imageio.png   - ImageIO result\n";
     std::cout << "   * spred_resized_coreimage.png - CoreImage result\n";
-    std::cout << "   * spred_resized_temp.png      - NSImage result\n\n";
+    std::cout << "   * spred_resized_temp.png      - NSImage result\n";
+    std::cout << "   * spred_resized_area.png      - AreaAverage result\n\n";
     std::cout << "Compare visually:\n";
     std::cout << "   open /tmp/spred_resized_*.png\n\n";
     
@@ -299,6 +375,10 @@ int main(int argc, char* argv[]) {
                 std::cout << "ImageIO (CoreGraphics)\n";
                 std::cout << "   → Use PNGScalingMethod::ImageIO for production\n";
                 std::cout << "   → Best for: Large images, metadata handling\n";
+            } else if (results[fastestIdx].method == PNGScalingMethod::AreaAverage) {
+                std::cout << "AreaAverage (Portable)\n";
+                std::cout << "   → Use PNGScalingMethod::AreaAverage for production\n";
+                std::cout << "   → Best for: Downscaling to sprite size, non-Apple builds\n";
             } else if (results[fastestIdx].method == PNGScalingMethod::CoreImage) {
                 std::cout << "CoreImage (GPU)\n";
                 std::cout << "   → Use PNGScalingMethod::CoreImage for production\n";
@@ -310,7 +390,7 @@ int main(int argc, char* argv[]) {
             
             std::cout << "\n[INFO] USAGE EXAMPLES:\n\n";
             std::cout << "C++ code:\n";
-            std::cout << "  // Fastest (default)\n";
+            std::cout << "  // Default method (vImage on Apple, AreaAverage in portable builds)\n";
             std::cout << "  PNGConverter::resizePNG(src, w, h, 0, 0, tw, th, out);\n\n";
             std::cout << "  // Highest quality with filter\n";
             std::cout << "  PNGConverter::resizePNG(src, w, h, 0, 0, tw, th, out,\n";
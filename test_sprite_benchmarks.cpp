@@ -0,0 +1,1777 @@
+//
+//  test_sprite_benchmarks.cpp
+//  SPRED - Sprite Runtime Benchmarks
+//
+//  Benchmarks sprite storage, decoding and rendering paths on synthetic sprite banks
+//
+
+#include "SpriteData.h"
+#include "CollisionMask.h"
+#include "NibblePacking.h"
+#include "OpaqueSpans.h"
+#include "PNGConverter.h"
+#include "PaletteExpand.h"
+#include "PaletteMapper.h"
+#include "SpriteAtlas.h"
+#include "SpriteCodecs.h"
+#include "SpriteCompositor.h"
+#include "SpriteBatchEncoder.h"
+#include "SpriteCompression.h"
+#include "SpriteDictionary.h"
+#include "SpriteHash.h"
+#include "SpriteScale.h"
+#include "SpriteTrace.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace SPRED;
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+void printUsage(const char* programName) {
+    std::cout << "Sprite Runtime Benchmarks\n";
+    std::cout << "=========================\n\n";
+    std::cout << "Usage: " << programName << " [benchmark] [sprite_count]\n\n";
+    std::cout << "Benchmarks:\n";
+    std::cout << "  all      Run every benchmark (default)\n";
+    std::cout << "  layout   Byte-per-pixel vs nibble-packed pixel storage\n";
+    std::cout << "  codecs   SPRTZ v3 payload size and decode throughput per codec\n";
+    std::cout << "  batch    Per-sprite vs batch SPRTZ encoding of a whole library\n";
+    std::cout << "  trace    Cost of trace points when disabled, enabled and capturing\n";
+    std::cout << "  dict     Zlib payload size and decode speed with a trained dictionary\n";
+    std::cout << "  hash     Header-only content hash check vs full decode and validation\n";
+    std::cout << "  surface  SPRTZ to 32-bit sprite sheet: via RGBA buffer vs direct\n";
+    std::cout << "  expand   Index to RGBA expansion: scalar reference vs SIMD kernel\n";
+    std::cout << "  atlas    Skyline atlas packing time, page occupancy and page build\n";
+    std::cout << "  compose  Tile-binned CPU compositor: sprites per 60 Hz frame at 1080p\n";
+    std::cout << "  palswap  Color variants: recolor and expand each copy vs per-instance palette IDs\n";
+    std::cout << "  scale    1x/2x/4x export images: per-pixel rescale vs one pass vs cached\n";
+    std::cout << "  dirty    Brush strokes: full re-expansion vs dirty-rectangle update\n";
+    std::cout << "  transform Flip/rotate/shift: getPixel/setPixel loops vs kernels\n";
+    std::cout << "  collide  Pixel-perfect overlap: index bytes vs 1-bit collision masks\n";
+    std::cout << "  spans    Sparse blits: per-pixel transparency test vs opaque run lists\n";
+    std::cout << "  import   PNG import of a 4K source: first resample vs cached nudges and trims\n";
+    std::cout << "  palmap   RGBA to palette indices: linear nearest-color search vs 4096-entry table\n\n";
+    std::cout << "Default sprite count: 10000\n";
+}
+
+/// Correctness checks that failed; main returns non-zero if any did
+int g_failureCount = 0;
+
+/// Count a failed check and start its "[FAIL]" line
+std::ostream& reportFailure() {
+    g_failureCount++;
+    return std::cout << "  [FAIL] ";
+}
+
+void printHeader(const std::string& title) {
+    std::cout << "\n";
+    std::cout << "================================================================\n";
+    std::cout << "  " << title << "\n";
+    std::cout << "================================================================\n";
+}
+
+void printSection(const std::string& title) {
+    std::cout << "\n-- " << title << " " << std::string(60 - title.length(), '-') << "\n";
+}
+
+class BenchTimer {
+public:
+    BenchTimer() : m_start(std::chrono::high_resolution_clock::now()) {}
+    double seconds() const {
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - m_start;
+        return elapsed.count();
+    }
+private:
+    std::chrono::high_resolution_clock::time_point m_start;
+};
+
+void printRate(const std::string& label, double seconds, double bytes, double items, const char* itemName) {
+    std::cout << "  " << std::left << std::setw(34) << label << std::right
+              << std::fixed << std::setprecision(3) << std::setw(9) << (seconds * 1000.0) << " ms  "
+              << std::setprecision(1) << std::setw(9) << (bytes / seconds / 1024.0 / 1024.0) << " MB/s  "
+              << std::setprecision(2) << std::setw(9) << (items / seconds / 1e6) << " M" << itemName << "/s\n";
+}
+
+/// Sprite sizes used by SuperTerminalMetal, cycled through the synthetic bank
+const int kSpriteSizes[3] = {8, 16, 40};
+
+/// Deterministic sprite content: ~60% transparent with a few colored shapes
+/// Synthetic sprites keep the default Unpacked layout, so getPixelData() is
+/// never null for them; benchmarks that switch to Packed read through
+/// getPixel or getRGBAPixels.
+void fillSyntheticSprite(SpriteData& sprite, uint32_t seed) {
+    int w = sprite.getWidth();
+    int h = sprite.getHeight();
+    uint32_t state = seed * 2654435761u + 1;
+    auto next = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int dx = 2 * x - w + 1;
+            int dy = 2 * y - h + 1;
+            bool inside = dx * dx + dy * dy < (w * h * 6) / 10;
+            uint8_t index = inside ? static_cast<uint8_t>(2 + ((x / 3 + y / 2 + (next() & 1)) % 14)) : 0;
+            sprite.setPixel(x, y, index);
+        }
+    }
+}
+
+void buildSyntheticBank(std::vector<SpriteData>& sprites, int count) {
+    sprites.clear();
+    sprites.reserve(count);
+    for (int i = 0; i < count; i++) {
+        int size = kSpriteSizes[i % 3];
+        sprites.emplace_back(size, size);
+        fillSyntheticSprite(sprites.back(), static_cast<uint32_t>(i));
+    }
+}
+
+// =============================================================================
+// Pixel Layout: byte-per-pixel vs nibble-packed
+// =============================================================================
+
+void benchPixelLayout(int spriteCount) {
+    printHeader("PIXEL LAYOUT (" + std::to_string(spriteCount) + " sprites, kernel: " +
+                NibblePacking::getKernelName() + ")");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+
+    // Contiguous index banks in both layouts
+    size_t totalPixels = 0;
+    std::vector<size_t> offsets;
+    for (const SpriteData& sprite : sprites) {
+        offsets.push_back(totalPixels);
+        totalPixels += sprite.getWidth() * sprite.getHeight();
+    }
+
+    std::vector<uint8_t> unpackedBank(totalPixels);
+    std::vector<uint8_t> packedBank(totalPixels / 2 + sprites.size());
+    std::vector<uint8_t> roundTrip(totalPixels);
+    size_t packedBytes = 0;
+    for (size_t i = 0; i < sprites.size(); i++) {
+        size_t count = sprites[i].getWidth() * sprites[i].getHeight();
+        std::memcpy(unpackedBank.data() + offsets[i], sprites[i].getPixelData(), count);
+        packedBytes += NibblePacking::packedSize(count);
+    }
+
+    printSection("Memory");
+    std::cout << "  Byte-per-pixel indices: " << totalPixels << " bytes\n";
+    std::cout << "  Nibble-packed indices:  " << packedBytes << " bytes ("
+              << std::fixed << std::setprecision(1) << (100.0 * packedBytes / totalPixels) << "%)\n";
+
+    printSection("Kernels (whole bank)");
+    const int passes = 20;
+    {
+        BenchTimer timer;
+        for (int pass = 0; pass < passes; pass++) {
+            size_t out = 0;
+            for (size_t i = 0; i < sprites.size(); i++) {
+                size_t count = sprites[i].getWidth() * sprites[i].getHeight();
+                NibblePacking::pack(unpackedBank.data() + offsets[i], packedBank.data() + out, count);
+                out += NibblePacking::packedSize(count);
+            }
+        }
+        printRate("pack", timer.seconds(), double(totalPixels) * passes, double(totalPixels) * passes, "px");
+    }
+    {
+        BenchTimer timer;
+        for (int pass = 0; pass < passes; pass++) {
+            size_t in = 0;
+            for (size_t i = 0; i < sprites.size(); i++) {
+                size_t count = sprites[i].getWidth() * sprites[i].getHeight();
+                NibblePacking::unpack(packedBank.data() + in, roundTrip.data() + offsets[i], count);
+                in += NibblePacking::packedSize(count);
+            }
+        }
+        printRate("unpack", timer.seconds(), double(totalPixels) * passes, double(totalPixels) * passes, "px");
+    }
+    if (roundTrip != unpackedBank) {
+        reportFailure() << "Round trip mismatch\n";
+    }
+
+    printSection("Bank walk (opaque pixel count)");
+    {
+        BenchTimer timer;
+        size_t opaque = 0;
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < totalPixels; i++) {
+                opaque += unpackedBank[i] != 0;
+            }
+        }
+        printRate("byte-per-pixel", timer.seconds(), double(totalPixels) * passes, double(totalPixels) * passes, "px");
+        std::cout << "    (opaque: " << opaque / passes << ")\n";
+    }
+    {
+        BenchTimer timer;
+        size_t opaque = 0;
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < packedBytes; i++) {
+                uint8_t byte = packedBank[i];
+                opaque += (byte & 0x0F) != 0;
+                opaque += (byte >> 4) != 0;
+            }
+        }
+        printRate("nibble-packed", timer.seconds(), double(packedBytes) * passes, double(totalPixels) * passes, "px");
+        std::cout << "    (opaque: " << opaque / passes << ")\n";
+    }
+
+    printSection("SpriteData::getPixel walk");
+    for (PixelLayout layout : {PixelLayout::Unpacked, PixelLayout::Packed}) {
+        for (SpriteData& sprite : sprites) {
+            sprite.setPixelLayout(layout);
+        }
+
+        BenchTimer timer;
+        size_t checksum = 0;
+        for (int pass = 0; pass < 4; pass++) {
+            for (const SpriteData& sprite : sprites) {
+                for (int y = 0; y < sprite.getHeight(); y++) {
+                    for (int x = 0; x < sprite.getWidth(); x++) {
+                        checksum += sprite.getPixel(x, y);
+                    }
+                }
+            }
+        }
+        printRate(layout == PixelLayout::Packed ? "packed" : "unpacked", timer.seconds(),
+                  double(layout == PixelLayout::Packed ? packedBytes : totalPixels) * 4,
+                  double(totalPixels) * 4, "px");
+        std::cout << "    (checksum: " << checksum << ")\n";
+    }
+}
+
+// =============================================================================
+// Codecs: SPRTZ v3 payload size and decode speed
+// =============================================================================
+
+void benchCodecs(int spriteCount) {
+    printHeader("SPRTZ CODECS (" + std::to_string(spriteCount) + " sprites per size)");
+
+    const SPRTZCodec codecs[] = {SPRTZCodec::Stored, SPRTZCodec::RLE, SPRTZCodec::LZ, SPRTZCodec::Zlib,
+                                 SPRTZCodec::Masked};
+
+    for (int size : kSpriteSizes) {
+        int pixelCount = size * size;
+        std::vector<uint8_t> corpus(size_t(spriteCount) * pixelCount);
+        SpriteData sprite(size, size);
+        for (int i = 0; i < spriteCount; i++) {
+            fillSyntheticSprite(sprite, static_cast<uint32_t>(i));
+            std::memcpy(corpus.data() + size_t(i) * pixelCount, sprite.getPixelData(), pixelCount);
+        }
+
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " corpus (decode)");
+        std::vector<uint8_t> decoded(corpus.size());
+        for (SPRTZCodec codec : codecs) {
+            std::vector<std::vector<uint8_t>> payloads(spriteCount);
+            size_t payloadBytes = 0;
+            for (int i = 0; i < spriteCount; i++) {
+                SpriteCodecs::encode(codec, corpus.data() + size_t(i) * pixelCount, pixelCount, payloads[i]);
+                payloadBytes += payloads[i].size();
+            }
+
+            const int passes = 5;
+            bool ok = true;
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                for (int i = 0; i < spriteCount; i++) {
+                    ok &= SpriteCodecs::decode(codec, payloads[i].data(), payloads[i].size(),
+                                               decoded.data() + size_t(i) * pixelCount, pixelCount);
+                }
+            }
+            double seconds = timer.seconds();
+
+            std::string label = std::string(SpriteCodecs::getCodecName(codec)) + " (avg " +
+                                std::to_string(payloadBytes / spriteCount) + " B)";
+            printRate(label, seconds, double(corpus.size()) * passes, double(spriteCount) * passes, "sprites");
+            if (!ok || decoded != corpus) {
+                reportFailure() << "Round trip mismatch\n";
+            }
+        }
+
+        // Which codec each selection mode picks
+        for (SPRTZCodec mode : {SPRTZCodec::AutoSmallest, SPRTZCodec::AutoFastest}) {
+            int picks[5] = {0, 0, 0, 0, 0};
+            size_t payloadBytes = 0;
+            std::vector<uint8_t> payload;
+            for (int i = 0; i < spriteCount; i++) {
+                SPRTZCodec used;
+                SpriteCodecs::encodeBest(mode, corpus.data() + size_t(i) * pixelCount, pixelCount, payload, used);
+                picks[static_cast<int>(used)]++;
+                payloadBytes += payload.size();
+            }
+            std::cout << "  " << std::left << std::setw(14) << SpriteCodecs::getCodecName(mode) << std::right
+                      << "avg " << payloadBytes / spriteCount << " B  picks:";
+            for (SPRTZCodec codec : codecs) {
+                std::cout << " " << SpriteCodecs::getCodecName(codec) << "=" << picks[static_cast<int>(codec)];
+            }
+            std::cout << "\n";
+        }
+
+        // Drawing onto a surface: decode then test every pixel, vs walking the opaque spans
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " blit to 256x256 surface");
+        const int surfaceSize = 256;
+        std::vector<uint8_t> surface(surfaceSize * surfaceSize);
+        std::vector<std::vector<uint8_t>> lzPayloads(spriteCount);
+        std::vector<std::vector<uint8_t>> maskedPayloads(spriteCount);
+        for (int i = 0; i < spriteCount; i++) {
+            const uint8_t* pixels = corpus.data() + size_t(i) * pixelCount;
+            SpriteCodecs::encode(SPRTZCodec::LZ, pixels, pixelCount, lzPayloads[i]);
+            SpriteCodecs::encode(SPRTZCodec::Masked, pixels, pixelCount, maskedPayloads[i]);
+        }
+        const int passes = 5;
+        int columns = surfaceSize / size;
+        {
+            std::vector<uint8_t> scratch(pixelCount);
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                for (int i = 0; i < spriteCount; i++) {
+                    SpriteCodecs::decode(SPRTZCodec::LZ, lzPayloads[i].data(), lzPayloads[i].size(),
+                                         scratch.data(), pixelCount);
+                    int cell = i % (columns * columns);
+                    uint8_t* dst = surface.data() + (cell / columns) * size * surfaceSize + (cell % columns) * size;
+                    for (int y = 0; y < size; y++) {
+                        for (int x = 0; x < size; x++) {
+                            uint8_t index = scratch[y * size + x];
+                            if (index != 0) {
+                                dst[y * surfaceSize + x] = index;
+                            }
+                        }
+                    }
+                }
+            }
+            printRate("LZ decode + per-pixel test", timer.seconds(),
+                      double(corpus.size()) * passes, double(spriteCount) * passes, "sprites");
+        }
+        {
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                for (int i = 0; i < spriteCount; i++) {
+                    int cell = i % (columns * columns);
+                    uint8_t* dst = surface.data() + (cell / columns) * size * surfaceSize + (cell % columns) * size;
+                    SpriteCodecs::blitMasked(maskedPayloads[i].data(), maskedPayloads[i].size(),
+                                             size, size, dst, surfaceSize);
+                }
+            }
+            printRate("Masked span blit", timer.seconds(),
+                      double(corpus.size()) * passes, double(spriteCount) * passes, "sprites");
+        }
+    }
+}
+
+// =============================================================================
+// Batch Encoding: one-off encodes vs SpriteBatchEncoder
+// =============================================================================
+
+void benchBatchEncode(int spriteCount) {
+    printHeader("BATCH ENCODE (" + std::to_string(spriteCount) + " sprites)");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+    double totalPixels = 0;
+    for (const SpriteData& sprite : sprites) {
+        totalPixels += sprite.getWidth() * sprite.getHeight();
+    }
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    for (SPRTZCodec codec : {SPRTZCodec::Zlib, SPRTZCodec::AutoSmallest}) {
+        printSection(std::string("Codec: ") + SpriteCodecs::getCodecName(codec));
+
+        // Untimed pass so every path starts with warm caches and allocator
+        std::vector<std::vector<uint8_t>> reference(sprites.size());
+        for (size_t i = 0; i < sprites.size(); i++) {
+            SpriteCompression::encodeSPRTZv3Custom(reference[i], sprites[i].getWidth(), sprites[i].getHeight(),
+                                                   sprites[i].getPixelData(), sprites[i].getPaletteData(), codec);
+        }
+        {
+            std::vector<uint8_t> image;
+            BenchTimer timer;
+            for (size_t i = 0; i < sprites.size(); i++) {
+                SpriteCompression::encodeSPRTZv3Custom(image, sprites[i].getWidth(), sprites[i].getHeight(),
+                                                       sprites[i].getPixelData(), sprites[i].getPaletteData(), codec);
+            }
+            printRate("per-sprite encode", timer.seconds(), totalPixels, double(sprites.size()), "sprites");
+        }
+
+        std::vector<int> threadCounts = {1};
+        if (cores > 1) {
+            threadCounts.push_back(cores);
+        }
+        for (int threads : threadCounts) {
+            SpriteBatchEncoder encoder(codec, threads);
+            for (const SpriteData& sprite : sprites) {
+                encoder.addSprite("", sprite);
+            }
+            std::vector<std::vector<uint8_t>> images;
+            encoder.encodeAll(images);
+
+            const SpriteBatchStats& stats = encoder.getStats();
+            printRate("batch, " + std::to_string(threads) + " thread(s)", stats.seconds,
+                      double(stats.inputBytes), double(stats.spriteCount), "sprites");
+            if (images != reference) {
+                reportFailure() << "Batch output differs from per-sprite output\n";
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Trace Overhead: SPRTZ decode with tracing off, counting and capturing
+// =============================================================================
+
+void benchTraceOverhead(int spriteCount) {
+    printHeader(std::string("TRACE OVERHEAD (") + std::to_string(spriteCount) + " sprites, compiled " +
+                (SPRED_ENABLE_TRACE ? "in" : "out") + ")");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+
+    std::vector<std::vector<uint8_t>> images(sprites.size());
+    double totalPixels = 0;
+    for (size_t i = 0; i < sprites.size(); i++) {
+        SpriteCompression::encodeSPRTZv3Custom(images[i], sprites[i].getWidth(), sprites[i].getHeight(),
+                                               sprites[i].getPixelData(), sprites[i].getPaletteData(),
+                                               SPRTZCodec::RLE);
+        totalPixels += sprites[i].getWidth() * sprites[i].getHeight();
+    }
+
+    printSection("Decode (RLE)");
+    const char* modes[] = {"tracing disabled", "counters", "counters + capture"};
+    for (int mode = 0; mode < 3; mode++) {
+        SpriteTrace::reset();
+        SpriteTrace::setEnabled(mode >= 1);
+        SpriteTrace::setCaptureEvents(mode == 2);
+
+        const int passes = 5;
+        uint8_t pixels[MAX_SPRITE_PIXELS];
+        uint8_t palette[PALETTE_BYTES];
+        int width, height;
+        bool isStandard;
+        uint8_t paletteID;
+        BenchTimer timer;
+        for (int pass = 0; pass < passes; pass++) {
+            for (const std::vector<uint8_t>& image : images) {
+                SpriteCompression::decodeSPRTZv2(image.data(), image.size(), width, height,
+                                                 pixels, palette, isStandard, paletteID);
+            }
+        }
+        printRate(modes[mode], timer.seconds(), totalPixels * passes, double(images.size()) * passes, "sprites");
+    }
+
+    TraceCounters counters = SpriteTrace::getCounters(TraceStage::Decompress);
+    std::cout << "    (decompress calls recorded: " << counters.calls << ")\n";
+    SpriteTrace::setEnabled(false);
+    SpriteTrace::setCaptureEvents(false);
+    SpriteTrace::reset();
+}
+
+// =============================================================================
+// Preset Dictionary: zlib with and without a trained dictionary
+// =============================================================================
+
+void benchDictionary(int spriteCount) {
+    printHeader("PRESET DICTIONARY (" + std::to_string(spriteCount) + " sprites per size, half held out)");
+
+    const uint8_t dictionaryID = 1;
+    for (int size : kSpriteSizes) {
+        int pixelCount = size * size;
+        std::vector<std::vector<uint8_t>> training;
+        std::vector<std::vector<uint8_t>> holdout;
+        SpriteData sprite(size, size);
+        for (int i = 0; i < spriteCount; i++) {
+            fillSyntheticSprite(sprite, static_cast<uint32_t>(i));
+            const uint8_t* pixels = sprite.getPixelData();
+            (i % 2 == 0 ? training : holdout).emplace_back(pixels, pixels + pixelCount);
+        }
+
+        std::vector<uint8_t> dictionary;
+        BenchTimer trainTimer;
+        SpriteDictionary::train(training, 4096, dictionary);
+        double trainSeconds = trainTimer.seconds();
+        SpriteDictionary::registerDictionary(dictionaryID, dictionary.data(), dictionary.size());
+
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " (dictionary " +
+                     std::to_string(dictionary.size()) + " B, trained in " +
+                     std::to_string(int(trainSeconds * 1000.0)) + " ms)");
+
+        std::vector<uint8_t> decoded(pixelCount);
+        for (uint8_t id : {uint8_t(0), dictionaryID}) {
+            std::vector<std::vector<uint8_t>> payloads(holdout.size());
+            size_t payloadBytes = 0;
+            for (size_t i = 0; i < holdout.size(); i++) {
+                SpriteCodecs::encode(SPRTZCodec::Zlib, holdout[i].data(), pixelCount, payloads[i], nullptr, id);
+                payloadBytes += payloads[i].size();
+            }
+
+            bool ok = true;
+            BenchTimer timer;
+            for (size_t i = 0; i < holdout.size(); i++) {
+                ok &= SpriteCodecs::decode(SPRTZCodec::Zlib, payloads[i].data(), payloads[i].size(),
+                                           decoded.data(), pixelCount, id) &&
+                      decoded == holdout[i];
+            }
+            std::string label = std::string(id ? "zlib + dictionary" : "zlib") + " (avg " +
+                                std::to_string(payloadBytes / holdout.size()) + " B)";
+            printRate(label, timer.seconds(), double(holdout.size()) * pixelCount, double(holdout.size()), "sprites");
+            if (!ok) {
+                reportFailure() << "Round trip mismatch\n";
+            }
+        }
+    }
+    SpriteDictionary::unregisterDictionary(dictionaryID);
+}
+
+// =============================================================================
+// Content Hash: header-only cache check vs decoding
+// =============================================================================
+
+void benchContentHash(int spriteCount) {
+    printHeader("CONTENT HASH (" + std::to_string(spriteCount) + " sprites)");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+
+    std::vector<std::vector<uint8_t>> images(sprites.size());
+    std::vector<uint64_t> cachedHashes(sprites.size());
+    double totalPixels = 0;
+    for (size_t i = 0; i < sprites.size(); i++) {
+        const SpriteData& sprite = sprites[i];
+        SpriteCompression::encodeSPRTZv3Custom(images[i], sprite.getWidth(), sprite.getHeight(),
+                                               sprite.getPixelData(), sprite.getPaletteData());
+        cachedHashes[i] = SpriteCompression::computeContentHash(sprite.getWidth(), sprite.getHeight(),
+                                                                sprite.getPixelData(), 0xFF,
+                                                                sprite.getPaletteData());
+        totalPixels += sprite.getWidth() * sprite.getHeight();
+    }
+
+    printSection("Is the cached copy current?");
+    {
+        size_t hits = 0;
+        BenchTimer timer;
+        for (size_t i = 0; i < images.size(); i++) {
+            SPRTZInfo info;
+            if (SpriteCompression::readSPRTZInfo(images[i].data(), images[i].size(), info) &&
+                info.hasContentHash && info.contentHash == cachedHashes[i]) {
+                hits++;
+            }
+        }
+        printRate("header-only hash compare", timer.seconds(), totalPixels, double(images.size()), "sprites");
+        if (hits != images.size()) {
+            reportFailure() << "" << images.size() - hits << " hash misses\n";
+        }
+    }
+    {
+        std::vector<uint8_t> pixels(MAX_SPRITE_PIXELS);
+        uint8_t palette[64];
+        bool ok = true;
+        BenchTimer timer;
+        for (const std::vector<uint8_t>& image : images) {
+            int width, height;
+            bool isStandard;
+            uint8_t paletteID;
+            ok &= SpriteCompression::decodeSPRTZv2(image.data(), image.size(), width, height,
+                                                   pixels.data(), palette, isStandard, paletteID);
+        }
+        printRate("full decode", timer.seconds(), totalPixels, double(images.size()), "sprites");
+        if (!ok) {
+            reportFailure() << "Decode failed\n";
+        }
+    }
+
+    printSection("Validation");
+    {
+        size_t valid = 0;
+        BenchTimer timer;
+        for (const std::vector<uint8_t>& image : images) {
+            valid += SpriteCompression::validateSPRTZ(image.data(), image.size()) ? 1 : 0;
+        }
+        printRate("validateSPRTZ", timer.seconds(), totalPixels, double(images.size()), "sprites");
+        if (valid != images.size()) {
+            reportFailure() << "" << images.size() - valid << " sprites rejected\n";
+        }
+    }
+    {
+        uint64_t checksum = 0;
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            checksum ^= SpriteHash::hash64(sprite.getPixelData(), sprite.getWidth() * sprite.getHeight());
+        }
+        printRate("hash64 alone", timer.seconds(), totalPixels, double(sprites.size()), "sprites");
+        std::cout << "    (checksum: " << checksum << ")\n";
+    }
+}
+
+// =============================================================================
+// Surface Decode: SPRTZ to a 32-bit sprite sheet
+// =============================================================================
+
+void benchSurfaceDecode(int spriteCount) {
+    printHeader("SURFACE DECODE (" + std::to_string(spriteCount) + " sprites into a 1024x1024 sheet)");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+
+    // Stored payloads keep the decode cost out of the comparison
+    std::vector<std::vector<uint8_t>> images(sprites.size());
+    double totalPixels = 0;
+    for (size_t i = 0; i < sprites.size(); i++) {
+        const SpriteData& sprite = sprites[i];
+        SpriteCompression::encodeSPRTZv3Custom(images[i], sprite.getWidth(), sprite.getHeight(),
+                                               sprite.getPixelData(), sprite.getPaletteData(),
+                                               SPRTZCodec::Stored);
+        totalPixels += sprite.getWidth() * sprite.getHeight();
+    }
+
+    const int sheetSize = 1024;
+    const int cell = MAX_SPRITE_SIZE;
+    const int columns = sheetSize / cell;
+    std::vector<uint8_t> sheet(size_t(sheetSize) * sheetSize * 4);
+    std::vector<uint8_t> reference(sheet.size());
+
+    {
+        std::vector<uint8_t> pixels(MAX_SPRITE_PIXELS);
+        std::vector<uint8_t> rgba(MAX_SPRITE_PIXELS * 4);
+        uint8_t palette[PALETTE_BYTES];
+        BenchTimer timer;
+        for (size_t i = 0; i < images.size(); i++) {
+            int width, height;
+            bool isStandard;
+            uint8_t paletteID;
+            SpriteCompression::decodeSPRTZv2(images[i].data(), images[i].size(), width, height,
+                                             pixels.data(), palette, isStandard, paletteID);
+
+            // Same per-pixel copy SpriteData::getRGBAPixels used to do
+            for (int p = 0; p < width * height; p++) {
+                std::memcpy(rgba.data() + p * 4, palette + (pixels[p] & 0x0F) * 4, 4);
+            }
+
+            int slot = int(i % (columns * columns));
+            uint8_t* dst = reference.data() + ((slot / columns) * cell * sheetSize + (slot % columns) * cell) * 4;
+            for (int y = 0; y < height; y++) {
+                std::memcpy(dst + size_t(y) * sheetSize * 4, rgba.data() + size_t(y) * width * 4, width * 4);
+            }
+        }
+        printRate("decode + RGBA buffer + copy", timer.seconds(), totalPixels * 4, double(images.size()), "sprites");
+    }
+
+    for (SurfaceFormat format : {SurfaceFormat::RGBA, SurfaceFormat::PremultipliedBGRA}) {
+        SpriteSurface surface;
+        surface.pixels = sheet.data();
+        surface.width = sheetSize;
+        surface.height = sheetSize;
+        surface.stride = size_t(sheetSize) * 4;
+        surface.format = format;
+
+        bool ok = true;
+        BenchTimer timer;
+        for (size_t i = 0; i < images.size(); i++) {
+            int slot = int(i % (columns * columns));
+            int width, height;
+            ok &= SpriteCompression::decodeSPRTZToSurface(images[i].data(), images[i].size(), surface,
+                                                          (slot % columns) * cell, (slot / columns) * cell,
+                                                          width, height);
+        }
+        printRate(format == SurfaceFormat::RGBA ? "direct RGBA" : "direct premultiplied BGRA",
+                  timer.seconds(), totalPixels * 4, double(images.size()), "sprites");
+        if (!ok || (format == SurfaceFormat::RGBA && sheet != reference)) {
+            reportFailure() << "Surface mismatch\n";
+        }
+    }
+}
+
+// =============================================================================
+// Palette Expansion: scalar reference vs SIMD kernel
+// =============================================================================
+
+void benchPaletteExpand(int spriteCount) {
+    printHeader(std::string("PALETTE EXPAND (kernel: ") + PaletteExpand::getKernelName() + ")");
+
+    uint32_t table[PaletteExpand::TABLE_SIZE];
+    std::vector<uint8_t> rgba(MAX_SPRITE_PIXELS * 4);
+    std::vector<uint8_t> reference(MAX_SPRITE_PIXELS * 4);
+
+    for (int size : kSpriteSizes) {
+        int pixelCount = size * size;
+        SpriteData sprite(size, size);
+        fillSyntheticSprite(sprite, static_cast<uint32_t>(size));
+        PaletteExpand::buildTable(sprite.getPaletteData(), SurfaceFormat::RGBA, table);
+        std::vector<uint8_t> packed(NibblePacking::packedSize(pixelCount));
+        NibblePacking::pack(sprite.getPixelData(), packed.data(), pixelCount);
+
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " sprite");
+        const int passes = std::max(1, spriteCount * 100 / pixelCount);
+        const double pixels = double(pixelCount) * passes;
+        {
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                PaletteExpand::expandRowScalar(sprite.getPixelData(), pixelCount, table, reference.data());
+            }
+            printRate("scalar (unpacked)", timer.seconds(), pixels * 4, pixels, "px");
+        }
+        {
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                PaletteExpand::expandRow(sprite.getPixelData(), pixelCount, table, rgba.data());
+            }
+            printRate(std::string(PaletteExpand::getKernelName()) + " (unpacked)", timer.seconds(),
+                      pixels * 4, pixels, "px");
+        }
+        {
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                PaletteExpand::expandPackedRow(packed.data(), pixelCount, table, rgba.data());
+            }
+            printRate(std::string(PaletteExpand::getKernelName()) + " (packed)", timer.seconds(),
+                      pixels * 4, pixels, "px");
+        }
+        if (rgba != reference) {
+            reportFailure() << "Kernel output differs from the scalar reference\n";
+        }
+    }
+
+    printSection(std::to_string(spriteCount) + "-sprite bank (getRGBAPixels)");
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+    double totalPixels = 0;
+    for (const SpriteData& sprite : sprites) {
+        totalPixels += sprite.getWidth() * sprite.getHeight();
+    }
+    {
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            PaletteExpand::buildTable(sprite.getPaletteData(), SurfaceFormat::RGBA, table);
+            PaletteExpand::expandRowScalar(sprite.getPixelData(), sprite.getWidth() * sprite.getHeight(),
+                                           table, rgba.data());
+        }
+        printRate("scalar reference", timer.seconds(), totalPixels * 4, totalPixels, "px");
+    }
+    for (PixelLayout layout : {PixelLayout::Unpacked, PixelLayout::Packed}) {
+        for (SpriteData& sprite : sprites) {
+            sprite.setPixelLayout(layout);
+        }
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            sprite.getRGBAPixels(rgba.data());
+        }
+        printRate(layout == PixelLayout::Packed ? "getRGBAPixels (packed)" : "getRGBAPixels (unpacked)",
+                  timer.seconds(), totalPixels * 4, totalPixels, "px");
+    }
+}
+
+// =============================================================================
+// Atlas: skyline packing into 1024x1024 pages
+// =============================================================================
+
+void benchAtlas(int spriteCount) {
+    printHeader("SPRITE ATLAS (1024x1024 pages, 1 texel padding)");
+
+    std::vector<SpriteData> uniform;
+    buildSyntheticBank(uniform, spriteCount);
+
+    // Every size from 4x4 to 40x40, non-square, as in a real sprite library
+    std::vector<SpriteData> mixed;
+    mixed.reserve(spriteCount);
+    uint32_t state = 12345;
+    for (int i = 0; i < spriteCount; i++) {
+        state = state * 1664525u + 1013904223u;
+        int width = 4 + static_cast<int>((state >> 8) % 37);
+        int height = 4 + static_cast<int>((state >> 20) % 37);
+        mixed.emplace_back(width, height);
+        fillSyntheticSprite(mixed.back(), static_cast<uint32_t>(i));
+    }
+
+    const std::pair<const char*, std::vector<SpriteData>*> banks[] = {
+        {"8/16/40 squares", &uniform}, {"mixed 4-40 sizes", &mixed}};
+    for (const auto& bank : banks) {
+        printSection(std::to_string(spriteCount) + " sprites, " + bank.first);
+
+        SpriteAtlasBuilder atlas(1024, 1024);
+        for (const SpriteData& sprite : *bank.second) {
+            atlas.addSprite(sprite);
+        }
+        if (!atlas.build()) {
+            reportFailure() << "Packing failed\n";
+            continue;
+        }
+        const AtlasStats& stats = atlas.getStats();
+        std::cout << "  Pack:      " << std::fixed << std::setprecision(2) << (stats.seconds * 1000.0)
+                  << " ms (" << std::setprecision(1) << (stats.spriteCount / stats.seconds / 1e6)
+                  << " M sprites/s)\n";
+        std::cout << "  Pages:     " << stats.pageCount << ", " << std::setprecision(1)
+                  << (100.0 * stats.getOccupancy(atlas.getPageWidth(), atlas.getPageHeight()))
+                  << "% occupied overall (";
+        for (int page = 0; page < atlas.getPageCount(); page++) {
+            std::cout << (page > 0 ? " / " : "") << (100.0 * atlas.getPageOccupancy(page)) << "%";
+        }
+        std::cout << ")\n";
+
+        std::vector<uint8_t> table;
+        atlas.buildTable(AtlasPageFormat::Indexed4, table);
+        std::cout << "  Table:     " << table.size() << " bytes (" << stats.paletteCount << " palettes)\n";
+
+        double pagePixels = double(atlas.getPageWidth()) * atlas.getPageHeight() * atlas.getPageCount();
+        std::vector<uint8_t> indexed;
+        {
+            BenchTimer timer;
+            for (int page = 0; page < atlas.getPageCount(); page++) {
+                atlas.buildIndexedPage(page, indexed);
+            }
+            printRate("build indexed pages", timer.seconds(), pagePixels / 2, pagePixels, "px");
+        }
+        std::vector<uint8_t> rgba;
+        {
+            BenchTimer timer;
+            for (int page = 0; page < atlas.getPageCount(); page++) {
+                atlas.buildRGBAPage(page, SurfaceFormat::RGBA, rgba);
+            }
+            printRate("build RGBA pages", timer.seconds(), pagePixels * 4, pagePixels, "px");
+        }
+
+        // Last page: every sprite on it must read back from its placement
+        int lastPage = atlas.getPageCount() - 1;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < bank.second->size(); i++) {
+            const AtlasPlacement* placement = atlas.getPlacement(i);
+            const SpriteData& sprite = (*bank.second)[i];
+            if (placement->page != lastPage) {
+                continue;
+            }
+            for (int y = 0; y < sprite.getHeight(); y++) {
+                for (int x = 0; x < sprite.getWidth(); x++) {
+                    size_t texel = size_t(placement->y + y) * atlas.getPageWidth() + placement->x + x;
+                    if (NibblePacking::get(indexed.data(), texel) != sprite.getPixel(x, y)) {
+                        mismatches++;
+                    }
+                }
+            }
+        }
+        if (mismatches > 0) {
+            reportFailure() << "" << mismatches << " texels differ from their sprites\n";
+        }
+    }
+}
+
+// =============================================================================
+// Compose: tile-binned software sprite layer
+// =============================================================================
+
+void benchCompositor(int spriteCount) {
+    (void)spriteCount;
+    const int width = 1920;
+    const int height = 1080;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    printHeader("SPRITE COMPOSITOR (1920x1080 BGRA, " + std::to_string(cores) + " threads)");
+
+    // 96 sprites (8/16/40) with 8 palettes, as a game sprite layer would use
+    SpriteCompositor compositor(SurfaceFormat::BGRA);
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, 96);
+    for (const SpriteData& sprite : sprites) {
+        compositor.addSprite(sprite);
+    }
+    for (int i = 0; i < 8; i++) {
+        compositor.addPalette(sprites[i].getPaletteData());
+    }
+
+    std::vector<uint8_t> framebuffer(size_t(width) * height * 4);
+    std::vector<uint8_t> reference(framebuffer.size());
+    SpriteSurface target;
+    target.pixels = framebuffer.data();
+    target.width = width;
+    target.height = height;
+    target.stride = size_t(width) * 4;
+    target.format = SurfaceFormat::BGRA;
+
+    for (int instanceCount : {1000, 10000, 100000}) {
+        // Positions overhang every edge so clipping is exercised
+        std::vector<SpriteInstance> instances(instanceCount);
+        uint32_t state = static_cast<uint32_t>(instanceCount);
+        for (SpriteInstance& instance : instances) {
+            state = state * 1664525u + 1013904223u;
+            instance.x = static_cast<int32_t>((state >> 4) % (width + 40)) - 40;
+            state = state * 1664525u + 1013904223u;
+            instance.y = static_cast<int32_t>((state >> 4) % (height + 40)) - 40;
+            instance.sprite = static_cast<uint16_t>((state >> 12) % sprites.size());
+            instance.palette = static_cast<uint16_t>((state >> 20) % 8);
+            instance.flip = static_cast<uint8_t>((state >> 28) & 3);
+        }
+
+        printSection(std::to_string(instanceCount) + " instances");
+        const int frames = std::max(3, 2000000 / instanceCount);
+        for (int threadCount : {1, 0}) {
+            compositor.setThreadCount(threadCount);
+            std::fill(framebuffer.begin(), framebuffer.end(), 0);
+            compositor.render(instances.data(), instances.size(), target);
+
+            double seconds = 0.0;
+            double binSeconds = 0.0;
+            for (int frame = 0; frame < frames; frame++) {
+                compositor.render(instances.data(), instances.size(), target);
+                seconds += compositor.getStats().seconds;
+                binSeconds += compositor.getStats().binSeconds;
+            }
+            double frameMs = seconds / frames * 1000.0;
+            double perFrame = instanceCount * (1000.0 / 60.0) / frameMs;
+            std::cout << "  " << std::left << std::setw(12) << (threadCount == 1 ? "1 thread" : "all threads")
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(9) << frameMs
+                      << " ms/frame (bin " << std::setw(6) << (binSeconds / frames * 1000.0) << " ms)  "
+                      << std::setprecision(0) << std::setw(10) << perFrame << " sprites per 60 Hz frame\n";
+
+            // Draw order is the same on every thread count, so a clean frame must match exactly
+            std::fill(framebuffer.begin(), framebuffer.end(), 0);
+            compositor.render(instances.data(), instances.size(), target);
+            if (threadCount == 1) {
+                reference = framebuffer;
+            } else if (framebuffer != reference) {
+                reportFailure() << "Threaded frame differs from the single-thread frame\n";
+            }
+        }
+        const CompositorStats& stats = compositor.getStats();
+        std::cout << "    (visible: " << stats.visibleCount << ", tile refs: " << stats.tileRefs << ")\n";
+    }
+}
+
+// =============================================================================
+// Palette swap: recolored copies vs per-instance palette IDs
+// =============================================================================
+
+void benchPaletteSwap(int spriteCount) {
+    (void)spriteCount;
+    printHeader("PALETTE SWAP (40x40 sprite)");
+
+    SpriteData base(40, 40);
+    fillSyntheticSprite(base, 40);
+    const int pixelCount = base.getWidth() * base.getHeight();
+
+    for (int variantCount : {16, 256, 4096}) {
+        printSection(std::to_string(variantCount) + " color variants");
+
+        // Before: one recolored SpriteData per variant, expanded to RGBA for drawing
+        std::vector<uint8_t> expanded(size_t(variantCount) * pixelCount * 4);
+        {
+            BenchTimer timer;
+            for (int v = 0; v < variantCount; v++) {
+                SpriteData variant = base;
+                for (int index = 2; index < 16; index++) {
+                    variant.setPaletteColor(index, static_cast<uint8_t>(v * 7 + index * 16),
+                                            static_cast<uint8_t>(v * 13), static_cast<uint8_t>(index * 9), 255);
+                }
+                variant.getRGBAPixels(&expanded[size_t(v) * pixelCount * 4]);
+            }
+            double seconds = timer.seconds();
+            std::cout << "  recolor + getRGBAPixels     " << std::fixed << std::setprecision(3) << std::setw(9)
+                      << (seconds * 1000.0) << " ms  " << std::setw(10) << expanded.size() << " bytes\n";
+        }
+
+        // After: indices stored once, one 64-byte table per variant
+        SpriteCompositor compositor(SurfaceFormat::RGBA, 1);
+        uint16_t spriteID = compositor.addSprite(base);
+        {
+            uint8_t palette[64];
+            std::memcpy(palette, base.getPaletteData(), sizeof(palette));
+            BenchTimer timer;
+            for (int v = 0; v < variantCount; v++) {
+                for (int index = 2; index < 16; index++) {
+                    palette[index * 4 + 0] = static_cast<uint8_t>(v * 7 + index * 16);
+                    palette[index * 4 + 1] = static_cast<uint8_t>(v * 13);
+                    palette[index * 4 + 2] = static_cast<uint8_t>(index * 9);
+                }
+                compositor.addPalette(palette);
+            }
+            double seconds = timer.seconds();
+            std::cout << "  palette IDs                 " << std::fixed << std::setprecision(3) << std::setw(9)
+                      << (seconds * 1000.0) << " ms  " << std::setw(10) << compositor.getMemoryUsage() << " bytes\n";
+        }
+
+        // Draw every variant once; the blit applies each instance's table
+        const int columns = 32;
+        std::vector<uint8_t> framebuffer(size_t(columns * 40) * 40 * 4 * ((variantCount + columns - 1) / columns));
+        SpriteSurface target;
+        target.pixels = framebuffer.data();
+        target.width = columns * 40;
+        target.height = 40 * ((variantCount + columns - 1) / columns);
+        target.stride = size_t(target.width) * 4;
+        target.format = SurfaceFormat::RGBA;
+        std::vector<SpriteInstance> instances(variantCount);
+        for (int v = 0; v < variantCount; v++) {
+            instances[v] = {(v % columns) * 40, (v / columns) * 40, spriteID,
+                            static_cast<uint16_t>(v), SPRITE_FLIP_NONE};
+        }
+        compositor.render(instances.data(), instances.size(), target);
+
+        // Opaque pixels of each drawn variant must match its recolored expansion
+        size_t mismatches = 0;
+        for (int v = 0; v < variantCount; v++) {
+            for (int p = 0; p < pixelCount; p++) {
+                if (base.getPixel(p % 40, p / 40) == 0) {
+                    continue;
+                }
+                size_t offset = size_t((v / columns) * 40 + p / 40) * target.stride +
+                                size_t((v % columns) * 40 + p % 40) * 4;
+                if (std::memcmp(&framebuffer[offset], &expanded[(size_t(v) * pixelCount + p) * 4], 4) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+        if (mismatches > 0) {
+            reportFailure() << "" << mismatches << " pixels differ from the recolored copies\n";
+        }
+
+        const int frames = std::max(3, 200000 / variantCount);
+        BenchTimer timer;
+        for (int frame = 0; frame < frames; frame++) {
+            compositor.render(instances.data(), instances.size(), target);
+        }
+        double seconds = timer.seconds() / frames;
+        std::cout << "  draw all variants           " << std::fixed << std::setprecision(3) << std::setw(9)
+                  << (seconds * 1000.0) << " ms/frame\n";
+    }
+}
+
+// =============================================================================
+// Scale: integer export scales
+// =============================================================================
+
+/// Per-output-pixel index lookup, as a straightforward exportPNG rescale does it
+void scaleFromIndicesNaive(const SpriteData& sprite, int scale, uint8_t* dst) {
+    const uint8_t* palette = sprite.getPaletteData();
+    int outWidth = sprite.getWidth() * scale;
+    int outHeight = sprite.getHeight() * scale;
+    for (int y = 0; y < outHeight; y++) {
+        for (int x = 0; x < outWidth; x++) {
+            uint8_t index = sprite.getPixel(x / scale, y / scale);
+            std::memcpy(dst + (size_t(y) * outWidth + x) * 4, palette + (index < 16 ? index : 0) * 4, 4);
+        }
+    }
+}
+
+void benchSpriteScale(int spriteCount) {
+    printHeader("EXPORT SCALES (1x, 2x, 4x per sprite)");
+
+    const int count = std::max(1, spriteCount / 10);
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, count);
+    const int scales[3] = {1, 2, 4};
+    double outputPixels = 0;
+    for (const SpriteData& sprite : sprites) {
+        outputPixels += double(sprite.getWidth()) * sprite.getHeight() * (1 + 4 + 16);
+    }
+
+    printSection(std::to_string(count) + " sprites");
+    std::vector<uint8_t> naive(MAX_SPRITE_PIXELS * 16 * 4);
+    {
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            for (int scale : scales) {
+                scaleFromIndicesNaive(sprite, scale, naive.data());
+            }
+        }
+        printRate("per-pixel rescale per scale", timer.seconds(), outputPixels * 4, outputPixels, "px");
+    }
+
+    std::vector<uint8_t> images[3];
+    for (int i = 0; i < 3; i++) {
+        images[i].resize(MAX_SPRITE_PIXELS * scales[i] * scales[i] * 4);
+    }
+    uint8_t* outputs[3] = {images[0].data(), images[1].data(), images[2].data()};
+    {
+        uint32_t table[PaletteExpand::TABLE_SIZE];
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            PaletteExpand::buildTable(sprite.getPaletteData(), SurfaceFormat::RGBA, table);
+            SpriteScale::expandScaled(sprite.getPixelData(), sprite.getWidth(), sprite.getHeight(),
+                                      table, scales, 3, outputs);
+        }
+        printRate("one expansion, all scales", timer.seconds(), outputPixels * 4, outputPixels, "px");
+    }
+
+    size_t mismatches = 0;
+    for (size_t s = 0; s < sprites.size(); s += 97) {
+        SpriteData& sprite = sprites[s];
+        uint32_t table[PaletteExpand::TABLE_SIZE];
+        PaletteExpand::buildTable(sprite.getPaletteData(), SurfaceFormat::RGBA, table);
+        SpriteScale::expandScaled(sprite.getPixelData(), sprite.getWidth(), sprite.getHeight(),
+                                  table, scales, 3, outputs);
+        for (int i = 0; i < 3; i++) {
+            scaleFromIndicesNaive(sprite, scales[i], naive.data());
+            size_t bytes = size_t(sprite.getWidth()) * sprite.getHeight() * scales[i] * scales[i] * 4;
+            if (std::memcmp(naive.data(), images[i].data(), bytes) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    if (mismatches > 0) {
+        reportFailure() << "" << mismatches << " scaled images differ from the per-pixel rescale\n";
+    }
+
+    ScaledSpriteCache cache(size_t(1) << 30);
+    ScaledSpriteCache::Image cached[3];
+    for (const char* label : {"cache, first export", "cache, unchanged re-export"}) {
+        BenchTimer timer;
+        for (const SpriteData& sprite : sprites) {
+            cache.get(sprite, scales, 3, cached);
+        }
+        printRate(label, timer.seconds(), outputPixels * 4, outputPixels, "px");
+    }
+    ScaledSpriteCacheStats stats = cache.getStats();
+    std::cout << "    (hits: " << stats.hits << ", misses: " << stats.misses
+              << ", cached: " << stats.bytes / 1024 << " KB)\n";
+}
+
+// =============================================================================
+// Dirty: per-stroke view refresh
+// =============================================================================
+
+void benchDirtyTracking(int spriteCount) {
+    printHeader("DIRTY TRACKING (40x40 sprite, RGBA view refresh per stroke)");
+
+    const int strokes = std::max(1, spriteCount * 10);
+    for (int brush : {1, 3, 8}) {
+        printSection(std::to_string(brush) + "x" + std::to_string(brush) + " brush, " +
+                     std::to_string(strokes) + " strokes");
+
+        for (bool incremental : {false, true}) {
+            SpriteData sprite(40, 40);
+            fillSyntheticSprite(sprite, 7);
+            std::vector<uint8_t> view(MAX_SPRITE_PIXELS * 4);
+            sprite.getRGBAPixels(view.data());
+            sprite.consumeChanges();
+
+            uint32_t state = 99;
+            size_t dirtyPixels = 0;
+            BenchTimer timer;
+            for (int stroke = 0; stroke < strokes; stroke++) {
+                state = state * 1664525u + 1013904223u;
+                int cx = static_cast<int>((state >> 8) % 40);
+                int cy = static_cast<int>((state >> 16) % 40);
+                uint8_t color = static_cast<uint8_t>(2 + (state >> 28) % 14);
+                for (int y = cy; y < cy + brush; y++) {
+                    for (int x = cx; x < cx + brush; x++) {
+                        sprite.setPixel(x, y, color);
+                    }
+                }
+
+                if (incremental) {
+                    SpriteChanges changes = sprite.consumeChanges();
+                    if (changes.paletteChanged || changes.resized) {
+                        sprite.getRGBAPixels(view.data());
+                    } else {
+                        sprite.updateRGBAPixels(view.data(), changes.pixels);
+                    }
+                    dirtyPixels += size_t(changes.pixels.width) * changes.pixels.height;
+                } else {
+                    sprite.getRGBAPixels(view.data());
+                    dirtyPixels += MAX_SPRITE_PIXELS;
+                }
+            }
+            double seconds = timer.seconds();
+            std::cout << "  " << std::left << std::setw(26) << (incremental ? "dirty rectangle" : "whole sprite")
+                      << std::right << std::fixed << std::setprecision(1) << std::setw(9)
+                      << (seconds / strokes * 1e9) << " ns/stroke  "
+                      << std::setw(7) << double(dirtyPixels) / strokes << " px re-expanded\n";
+
+            std::vector<uint8_t> expected(MAX_SPRITE_PIXELS * 4);
+            sprite.getRGBAPixels(expected.data());
+            if (expected != view) {
+                reportFailure() << "Incremental view differs from a full expansion\n";
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Transform: dihedral orientations and wrapping shifts
+// =============================================================================
+
+void benchTransforms(int spriteCount) {
+    printHeader("TRANSFORMS (flip, rotate, shift)");
+
+    for (int size : kSpriteSizes) {
+        const int pixelCount = size * size;
+        SpriteData sprite(size, size);
+        fillSyntheticSprite(sprite, static_cast<uint32_t>(size));
+        const int passes = std::max(1, spriteCount * 100 / pixelCount);
+        const double pixels = double(pixelCount) * passes;
+
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " sprite");
+        {
+            // What callers did before: rotate through the pixel accessors
+            SpriteData rotated(size, size);
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                for (int y = 0; y < size; y++) {
+                    for (int x = 0; x < size; x++) {
+                        rotated.setPixel(size - 1 - y, x, sprite.getPixel(x, y));
+                    }
+                }
+            }
+            printRate("getPixel/setPixel rotate90CW", timer.seconds(), pixels, pixels, "px");
+
+            SpriteData check = sprite;
+            check.rotate90CW();
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    if (check.getPixel(x, y) != rotated.getPixel(x, y)) {
+                        reportFailure() << "rotate90CW differs from the per-pixel rotation\n";
+                        y = size;
+                        break;
+                    }
+                }
+            }
+        }
+
+        std::vector<uint8_t> out(pixelCount);
+        for (SpriteOrientation orientation : {SpriteOrientation::FlipHorizontal, SpriteOrientation::Rotate90CW,
+                                              SpriteOrientation::Transpose}) {
+            const char* names[SPRITE_ORIENTATION_COUNT] = {"identity", "flip horizontal", "flip vertical",
+                                                           "rotate 180", "transpose", "rotate 90 CW",
+                                                           "rotate 90 CCW", "anti-transpose"};
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                SpriteTransform::apply(sprite.getPixelData(), size, size, orientation, out.data());
+            }
+            printRate(std::string("kernel ") + names[static_cast<int>(orientation)], timer.seconds(),
+                      pixels, pixels, "px");
+        }
+        {
+            SpriteData shifted = sprite;
+            BenchTimer timer;
+            for (int pass = 0; pass < passes; pass++) {
+                shifted.shift(1, -1);
+            }
+            printRate("SpriteData::shift (in place)", timer.seconds(), pixels, pixels, "px");
+        }
+        {
+            SpriteOrientationSet orientations;
+            const int builds = std::max(1, passes / 8);
+            BenchTimer timer;
+            for (int pass = 0; pass < builds; pass++) {
+                orientations.build(sprite);
+            }
+            double built = double(pixelCount) * SPRITE_ORIENTATION_COUNT * builds;
+            printRate("orientation set build (8x)", timer.seconds(), built, built, "px");
+            std::cout << "    (orientation set: " << orientations.getMemoryUsage() << " bytes)\n";
+        }
+    }
+
+    // Assigning a sprite with the same edit history must still rebuild the set
+    {
+        SpriteData target(16, 16);
+        SpriteData other(16, 16);
+        target.setPixel(2, 2, 1);
+        other.setPixel(10, 10, 3);
+        SpriteOrientationSet orientations;
+        orientations.update(target);
+        target = other;
+        if (!orientations.update(target) ||
+            orientations.getPixels(SpriteOrientation::Identity)[10 * 16 + 10] != 3) {
+            reportFailure() << "Orientation set was not rebuilt after assigning another sprite\n";
+        }
+    }
+}
+
+// =============================================================================
+// Collide: pixel-perfect overlap tests
+// =============================================================================
+
+/// Compare index bytes over the overlapping rectangle, as games did before masks
+bool overlapsByIndices(const SpriteData& a, int ax, int ay, const SpriteData& b, int bx, int by) {
+    int x0 = std::max(ax, bx);
+    int y0 = std::max(ay, by);
+    int x1 = std::min(ax + a.getWidth(), bx + b.getWidth());
+    int y1 = std::min(ay + a.getHeight(), by + b.getHeight());
+    const uint8_t* pa = a.getPixelData();
+    const uint8_t* pb = b.getPixelData();
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            if (pa[(y - ay) * a.getWidth() + (x - ax)] != 0 && pb[(y - by) * b.getWidth() + (x - bx)] != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void benchCollisionMasks(int spriteCount) {
+    printHeader("COLLISION MASKS (pixel-perfect overlap)");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, 96);
+    std::vector<CollisionMask> masks(sprites.size());
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            masks[i].build(sprites[i]);
+        }
+        std::cout << "  Build:  " << std::fixed << std::setprecision(1)
+                  << (timer.seconds() / sprites.size() * 1e9) << " ns per mask\n";
+    }
+
+    // Pairs of one size, placed so their boxes overlap (the expensive case)
+    const int tests = std::max(1000, spriteCount * 100);
+    for (int size : kSpriteSizes) {
+        printSection(std::to_string(size) + "x" + std::to_string(size) + " vs " +
+                     std::to_string(size) + "x" + std::to_string(size) + ", overlapping boxes");
+        std::vector<size_t> ofSize;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            if (sprites[i].getWidth() == size) {
+                ofSize.push_back(i);
+            }
+        }
+        struct Pair { size_t a; size_t b; int dx; int dy; };
+        std::vector<Pair> pairs(4096);
+        uint32_t state = static_cast<uint32_t>(size);
+        for (Pair& pair : pairs) {
+            state = state * 1664525u + 1013904223u;
+            pair.a = ofSize[(state >> 8) % ofSize.size()];
+            pair.b = ofSize[(state >> 16) % ofSize.size()];
+            state = state * 1664525u + 1013904223u;
+            pair.dx = static_cast<int>((state >> 8) % (2 * size - 1)) - (size - 1);
+            pair.dy = static_cast<int>((state >> 20) % (2 * size - 1)) - (size - 1);
+        }
+
+        size_t byteHits = 0;
+        size_t maskHits = 0;
+        double byteSeconds;
+        double maskSeconds;
+        {
+            BenchTimer timer;
+            for (int t = 0; t < tests; t++) {
+                const Pair& pair = pairs[t & 4095];
+                byteHits += overlapsByIndices(sprites[pair.a], 100, 100, sprites[pair.b], 100 + pair.dx, 100 + pair.dy);
+            }
+            byteSeconds = timer.seconds();
+        }
+        {
+            BenchTimer timer;
+            for (int t = 0; t < tests; t++) {
+                const Pair& pair = pairs[t & 4095];
+                maskHits += CollisionMask::overlaps(masks[pair.a], 100, 100, masks[pair.b], 100 + pair.dx, 100 + pair.dy);
+            }
+            maskSeconds = timer.seconds();
+        }
+        std::cout << "  index bytes       " << std::fixed << std::setprecision(1) << std::setw(8)
+                  << (byteSeconds / tests * 1e9) << " ns/test\n";
+        std::cout << "  collision masks   " << std::setw(8) << (maskSeconds / tests * 1e9) << " ns/test  ("
+                  << std::setprecision(1) << (byteSeconds / maskSeconds) << "x)\n";
+        std::cout << "    (hits: " << maskHits << " of " << tests << ")\n";
+        if (byteHits != maskHits) {
+            reportFailure() << "Mask results differ from the index comparison\n";
+        }
+    }
+}
+
+// =============================================================================
+// Spans: sparse blits through opaque run lists
+// =============================================================================
+
+void benchOpaqueSpans(int spriteCount) {
+    printHeader("OPAQUE SPANS (sparse blits)");
+
+    std::vector<SpriteData> sprites;
+    buildSyntheticBank(sprites, spriteCount);
+    std::vector<OpaqueSpans> spans(sprites.size());
+    double totalPixels = 0;
+    double opaquePixels = 0;
+    size_t spanCount = 0;
+    size_t spanBytes = 0;
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            spans[i].update(sprites[i]);
+        }
+        double seconds = timer.seconds();
+        for (size_t i = 0; i < sprites.size(); i++) {
+            totalPixels += sprites[i].getWidth() * sprites[i].getHeight();
+            opaquePixels += double(spans[i].getOpaquePixelCount());
+            spanCount += spans[i].getSpanCount();
+            spanBytes += spans[i].getMemoryUsage();
+        }
+        printRate("build run lists", seconds, totalPixels, double(sprites.size()), "sprites");
+        std::cout << "    (" << std::fixed << std::setprecision(1) << (100.0 * opaquePixels / totalPixels)
+                  << "% opaque, " << spanCount << " runs, " << spanBytes << " bytes)\n";
+    }
+    {
+        BenchTimer timer;
+        size_t rebuilt = 0;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            rebuilt += spans[i].update(sprites[i]);
+        }
+        printRate("update (unchanged)", timer.seconds(), totalPixels, double(sprites.size()), "sprites");
+        if (rebuilt != 0) {
+            reportFailure() << "Unchanged sprites were rebuilt\n";
+        }
+    }
+
+    // Every sprite drawn at a spread of positions on a 512x512 target, some clipped
+    const int targetSize = 512;
+    std::vector<int> positions(sprites.size() * 2);
+    uint32_t state = 7;
+    for (int& position : positions) {
+        state = state * 1664525u + 1013904223u;
+        position = static_cast<int>((state >> 8) % (targetSize + 40)) - 20;
+    }
+    std::vector<std::array<uint32_t, PaletteExpand::TABLE_SIZE>> tables(sprites.size());
+    for (size_t i = 0; i < sprites.size(); i++) {
+        PaletteExpand::buildTable(sprites[i].getPaletteData(), SurfaceFormat::RGBA, tables[i].data());
+    }
+    std::vector<uint8_t> reference(size_t(targetSize) * targetSize * 4, 0);
+    std::vector<uint8_t> rgba(reference.size(), 0);
+    SpriteSurface surface;
+    surface.pixels = rgba.data();
+    surface.width = targetSize;
+    surface.height = targetSize;
+    surface.stride = size_t(targetSize) * 4;
+
+    printSection(std::to_string(sprites.size()) + "-sprite bank into RGBA");
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            const SpriteData& sprite = sprites[i];
+            const uint8_t* pixels = sprite.getPixelData();
+            const int x = positions[i * 2];
+            const int y = positions[i * 2 + 1];
+            for (int v = 0; v < sprite.getHeight(); v++) {
+                for (int u = 0; u < sprite.getWidth(); u++) {
+                    uint8_t index = pixels[v * sprite.getWidth() + u];
+                    if (index == 0 || x + u < 0 || y + v < 0 || x + u >= targetSize || y + v >= targetSize) {
+                        continue;
+                    }
+                    std::memcpy(&reference[(size_t(y + v) * targetSize + (x + u)) * 4], &tables[i][index], 4);
+                }
+            }
+        }
+        printRate("per-pixel blit", timer.seconds(), totalPixels * 4, totalPixels, "px");
+    }
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            spans[i].blit(surface, positions[i * 2], positions[i * 2 + 1], tables[i].data());
+        }
+        printRate("span blit", timer.seconds(), totalPixels * 4, totalPixels, "px");
+    }
+    if (rgba != reference) {
+        reportFailure() << "Span blit differs from the per-pixel blit\n";
+    }
+
+    printSection(std::to_string(sprites.size()) + "-sprite bank into indices");
+    std::vector<uint8_t> indexReference(size_t(targetSize) * targetSize, 0);
+    std::vector<uint8_t> indices(indexReference.size(), 0);
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            const SpriteData& sprite = sprites[i];
+            const int x = positions[i * 2];
+            const int y = positions[i * 2 + 1];
+            for (int v = 0; v < sprite.getHeight(); v++) {
+                for (int u = 0; u < sprite.getWidth(); u++) {
+                    uint8_t index = sprite.getPixel(u, v);
+                    if (index == 0 || x + u < 0 || y + v < 0 || x + u >= targetSize || y + v >= targetSize) {
+                        continue;
+                    }
+                    indexReference[size_t(y + v) * targetSize + (x + u)] = index;
+                }
+            }
+        }
+        printRate("getPixel blit", timer.seconds(), totalPixels, totalPixels, "px");
+    }
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < sprites.size(); i++) {
+            spans[i].blitIndices(indices.data(), targetSize, targetSize, targetSize,
+                                 positions[i * 2], positions[i * 2 + 1]);
+        }
+        printRate("span blitIndices", timer.seconds(), totalPixels, totalPixels, "px");
+    }
+    if (indices != indexReference) {
+        reportFailure() << "Span index blit differs from the getPixel blit\n";
+    }
+
+    // Assigning a sprite with the same edit history must still rebuild the runs
+    {
+        SpriteData target(16, 16);
+        SpriteData other(16, 16);
+        target.setPixel(2, 2, 1);
+        other.setPixel(10, 10, 3);
+        OpaqueSpans cached;
+        cached.update(target);
+        target = other;
+        if (!cached.update(target) || cached.getRowSpanCount(10) != 1 || cached.getRowSpanCount(2) != 0) {
+            reportFailure() << "Spans were not rebuilt after assigning another sprite\n";
+        }
+    }
+}
+
+// =============================================================================
+// Import: interactive PNG import on a large source
+// =============================================================================
+
+void benchPNGImport(int spriteCount) {
+    printHeader("PNG IMPORT (3840x2160 source, 40x40 target)");
+
+    // Flat background with a noisy subject, like a screenshot or scan
+    const int width = 3840;
+    const int height = 2160;
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    uint32_t state = 1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t* pixel = &rgba[(size_t(y) * width + x) * 4];
+            int dx = x - width / 2;
+            int dy = y - height / 2;
+            bool subject = dx * dx / 4 + dy * dy < (height / 3) * (height / 3);
+            state = state * 1664525u + 1013904223u;
+            pixel[0] = subject ? static_cast<uint8_t>(x / 16 + (state >> 28)) : 32;
+            pixel[1] = subject ? static_cast<uint8_t>(y / 9 + (state >> 28)) : 48;
+            pixel[2] = subject ? static_cast<uint8_t>((x + y) / 24) : 64;
+            pixel[3] = 255;
+        }
+    }
+    const std::string filename = "/tmp/spred_import_bench.png";
+    if (!PNGConverter::savePNGFile(filename, rgba.data(), width, height)) {
+        std::cout << "  [SKIP] Could not write " << filename << "\n";
+        return;
+    }
+
+    const double frameMs = 1000.0 / 60.0;
+    const int nudges = std::max(10, std::min(100, spriteCount / 100));
+    SpriteData sprite;
+    {
+        BenchTimer timer;
+        if (!sprite.startPNGImport(filename, 40, 40)) {
+            reportFailure() << "startPNGImport failed\n";
+            return;
+        }
+        std::cout << "  startPNGImport (load + all steps)  " << std::fixed << std::setprecision(2)
+                  << std::setw(8) << (timer.seconds() * 1000.0) << " ms\n";
+    }
+    {
+        BenchTimer timer;
+        for (int i = 0; i < nudges; i++) {
+            sprite.shiftPNGImportOffset(i % 2 ? -1 : 1, 0);
+        }
+        double ms = timer.seconds() * 1000.0 / nudges;
+        std::cout << "  shiftPNGImportOffset (nudge)       " << std::setw(8) << ms << " ms  ("
+                  << std::setprecision(0) << (100.0 * ms / frameMs) << "% of a 60 Hz frame)\n";
+        if (ms > frameMs) {
+            reportFailure() << "Nudging takes longer than a frame\n";
+        }
+    }
+    {
+        const int trims = std::max(5, nudges / 4);
+        BenchTimer timer;
+        for (int i = 0; i < trims; i++) {
+            sprite.trimPNGImport(1, 1, 1, 1);
+        }
+        std::cout << "  trimPNGImport (1 px per edge)      " << std::setprecision(2) << std::setw(8)
+                  << (timer.seconds() * 1000.0 / trims) << " ms\n";
+    }
+    sprite.cancelPNGImport();
+    std::remove(filename.c_str());
+}
+
+// =============================================================================
+// Palette mapping: linear nearest-color search vs lookup table
+// =============================================================================
+
+void benchPaletteMapping(int spriteCount) {
+    printHeader(std::string("PALETTE MAPPING (build kernel: ") + PaletteMapper::getKernelName() + ")");
+
+    // 14 extracted colors, as import step F produces
+    std::vector<Color> colors;
+    uint32_t state = 7;
+    auto next = [&state]() { state = state * 1664525u + 1013904223u; return state >> 24; };
+    for (int i = 0; i < 14; i++) {
+        colors.emplace_back(static_cast<uint8_t>(next() & 0xF0), static_cast<uint8_t>(next() & 0xF0),
+                            static_cast<uint8_t>(next() & 0xF0));
+    }
+
+    // A sheet of quantized 40x40 frames, a quarter of it transparent
+    const size_t pixelCount = size_t(std::max(1, spriteCount)) * MAX_SPRITE_PIXELS;
+    std::vector<uint8_t> rgba(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint32_t bits = next() | (next() << 8);
+        rgba[i * 4 + 0] = static_cast<uint8_t>(bits & 0xF0);
+        rgba[i * 4 + 1] = static_cast<uint8_t>((bits << 4) & 0xF0);
+        rgba[i * 4 + 2] = static_cast<uint8_t>((bits >> 4) & 0xF0);
+        rgba[i * 4 + 3] = (bits >> 8) % 4 == 0 ? 0 : 255;
+    }
+    std::vector<uint8_t> reference(pixelCount);
+    std::vector<uint8_t> indices(pixelCount);
+    const double pixels = double(pixelCount);
+
+    printSection(std::to_string(spriteCount) + " frames of 40x40, 14-color palette");
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < pixelCount; i++) {
+            const uint8_t* p = &rgba[i * 4];
+            reference[i] = static_cast<uint8_t>(PNGConverter::findClosestColor(Color(p[0], p[1], p[2], p[3]), colors));
+        }
+        printRate("findClosestColor per pixel", timer.seconds(), pixels * 4, pixels, "px");
+    }
+    PaletteMapper mapper;
+    {
+        const int builds = 100;
+        BenchTimer timer;
+        for (int i = 0; i < builds; i++) {
+            mapper.build(colors, 2);
+        }
+        std::cout << "  " << std::left << std::setw(34) << "PaletteMapper::build" << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(9)
+                  << (timer.seconds() * 1e6 / builds) << " us per palette\n";
+    }
+    {
+        BenchTimer timer;
+        mapper.map(rgba.data(), pixelCount, indices.data());
+        printRate("PaletteMapper::map", timer.seconds(), pixels * 4, pixels, "px");
+    }
+    {
+        // Copy bandwidth for the same bytes, the ceiling for any mapping pass
+        std::vector<uint8_t> copy(rgba.size());
+        BenchTimer timer;
+        std::memcpy(copy.data(), rgba.data(), rgba.size());
+        printRate("memcpy (reference)", timer.seconds(), pixels * 4, pixels, "px");
+    }
+    if (indices != reference) {
+        reportFailure() << "Table lookup differs from findClosestColor\n";
+    }
+
+    // Every possible quantized color, both alpha states
+    for (int key = 0; key < PaletteMapper::TABLE_SIZE * 2; key++) {
+        Color pixel(static_cast<uint8_t>((key >> 4) & 0xF0), static_cast<uint8_t>(key & 0xF0),
+                    static_cast<uint8_t>((key << 4) & 0xF0), key >= PaletteMapper::TABLE_SIZE ? 255 : 0);
+        if (mapper.map(pixel) != PNGConverter::findClosestColor(pixel, colors)) {
+            reportFailure() << "Table entry " << key << " differs from findClosestColor\n";
+            break;
+        }
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    std::string benchmark = argc >= 2 ? argv[1] : "all";
+    int spriteCount = argc >= 3 ? std::stoi(argv[2]) : 10000;
+
+    if (benchmark == "-h" || benchmark == "--help") {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    bool all = benchmark == "all";
+    bool ran = false;
+
+    if (all || benchmark == "layout") {
+        benchPixelLayout(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "codecs") {
+        benchCodecs(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "batch") {
+        benchBatchEncode(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "trace") {
+        benchTraceOverhead(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "dict") {
+        benchDictionary(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "hash") {
+        benchContentHash(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "surface") {
+        benchSurfaceDecode(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "expand") {
+        benchPaletteExpand(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "atlas") {
+        benchAtlas(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "compose") {
+        benchCompositor(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "palswap") {
+        benchPaletteSwap(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "scale") {
+        benchSpriteScale(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "dirty") {
+        benchDirtyTracking(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "transform") {
+        benchTransforms(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "collide") {
+        benchCollisionMasks(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "spans") {
+        benchOpaqueSpans(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "import") {
+        benchPNGImport(spriteCount);
+        ran = true;
+    }
+
+    if (all || benchmark == "palmap") {
+        benchPaletteMapping(spriteCount);
+        ran = true;
+    }
+
+    if (!ran) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (g_failureCount > 0) {
+        printHeader("BENCHMARKS COMPLETE: " + std::to_string(g_failureCount) + " CHECK(S) FAILED");
+        return 1;
+    }
+    printHeader("BENCHMARKS COMPLETE");
+    return 0;
+}